@@ -2,6 +2,10 @@
 #define  METADATA_INC
 
 #include <string>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
 #include "Datasets/VTKDataset.h"
 #include "Datasets/VectorFieldDataset.h"
 #include "VFVClientSocket.h"
@@ -10,6 +14,11 @@
 #include "Datasets/CloudPointDataset.h"
 #include "Datasets/Annotation/AnnotationLogContainer.h"
 #include "Datasets/SubDatasetGroup.h"
+#include "VFVPointOctree.h"
+#include "VFVMaskBricks.h"
+#include "VFVTimestepSource.h"
+#include "VFVIndexedList.h"
+#include "VFVValuesMutex.h"
 
 namespace sereno
 {
@@ -241,6 +250,14 @@ namespace sereno
 
         int32_t  sdgID = -1;                                 /*!< The SubDatasetGroup linked with this SubDataset*/
 
+        VFVMaskBricks volumetricMaskBricks;                  /*!< The bricks of the volumetric mask changed since it was last sent (see VFV_SEND_VOLUMETRIC_MASK_DELTA). Every code writing the mask marks them*/
+        bool     sentVolumetricMaskEnabled = false;          /*!< Was the volumetric mask last sent enabled?*/
+        uint32_t volumetricMaskSequence    = 0;              /*!< The sequence number of the volumetric mask last sent. 0 == never sent*/
+        std::vector<uint32_t> volumetricMaskDirtyBricks;     /*!< The bricks which changed between the sequence numbers volumetricMaskSequence-1 and volumetricMaskSequence*/
+        bool     volumetricMaskDeltaValid  = false;          /*!< Is volumetricMaskDirtyBricks valid? (false if the mask was resized)*/
+        std::shared_ptr<uint8_t> volumetricMaskEvents[4];    /*!< The mask messages of volumetricMaskSequence (full, full encoded, delta, resync), shared by every send. NULL == not generated yet*/
+        size_t   volumetricMaskEventSizes[4] = {0, 0, 0, 0}; /*!< The size of volumetricMaskEvents*/
+
         /** \brief Push a new DrawableAnnotationPosition meta data object  
          * \param annot the object to consider and configure. A link is created between the SubDataset and this drawable.  */
         void pushDrawableAnnotationPosition(std::shared_ptr<DrawableAnnotationPositionMetaData> annot)
@@ -267,32 +284,42 @@ namespace sereno
     inline std::shared_ptr<DrawableAnnotationPositionMetaData> SubDatasetMetaData::getDrawableAnnotation(uint32_t drawableID)
     { return getDrawableAnnotation(drawableID, annotPos); }
 
+    /** \brief  The SubDatasetMetaData of a dataset, in insertion order, indexed by their SubDataset ID.
+     * The elements are never moved: pointers to them stay valid until they are erased */
+    typedef VFVIndexedList<SubDatasetMetaData, &SubDatasetMetaData::sdID> SubDatasetMetaDataList;
+
     /*!< Structure representing MetaData associated with the opened Datasets*/
     struct DatasetMetaData
     {
         std::string name;      /*!< The MetaData's name*/
         uint32_t    datasetID; /*!< The MetaData's ID*/
 
-        std::vector<SubDatasetMetaData> sdMetaData; /*!< SubDataset meta data*/
+        SubDatasetMetaDataList sdMetaData; /*!< SubDataset meta data*/
+
+        std::shared_ptr<VFVValuesMutex> valuesMutex = std::make_shared<VFVValuesMutex>(); /*!< Protect the values of the dataset (e.g., volumetric masks) while being computed or loaded,
+                                                                                               so that long computations do not have to hold VFVServer's global locks*/
 
         /** \brief  Get the SubDatasetMetaData based on the sdID
          * \param sdID the SubDataset ID
          * \return  The SubDataset at the corresponding ID, NULL otherwise */
         SubDatasetMetaData* getSDMetaDataByID(uint32_t sdID)
         {
-            for(SubDatasetMetaData& sd : sdMetaData)
-                if(sd.sdID == sdID)
-                    return &sd;
-            return NULL;
+            auto it = sdMetaData.find(sdID);
+            return (it == sdMetaData.end() ? NULL : &(*it));
         }
     };
 
+    /** \brief  The parsed files (one per timestep) of a VTK dataset, shared by every VTKDataset opened from the same file with the same fields.
+     * The first opening parses the files and publishes the timesteps in order. The other openings subscribe to them instead of parsing the files again */
+    typedef VFVTimestepSource<VTKParser> VFVVTKSource;
+
     /** \brief  The VTK MetaData structure, containing metadata of VTK Datasets */
     struct VTKMetaData : public DatasetMetaData
     {
         VTKDataset* dataset; /*!< The dataset opened*/
         std::vector<uint32_t> ptFieldValueIndices;   /*!< the pt field values to take account of*/
         std::vector<uint32_t> cellFieldValueIndices; /*!< the cell field values to take account of*/
+        std::shared_ptr<VFVVTKSource> source;        /*!< The parsed files, shared with the other datasets opened from the same file and fields*/
     };
 
     /** \brief  The VectorField MetaData structure, containing metadata of VectorField Datasets */
@@ -305,6 +332,10 @@ namespace sereno
     struct CloudPointMetaData : public DatasetMetaData
     {
         CloudPointDataset* dataset; /*!< The dataset opened*/
+        std::shared_ptr<const VFVPointCloud>  points;      /*!< The point positions, for the volumetric selections. NULL until they are read (see VFVServer::loadCloudPointDataset)*/
+        std::shared_ptr<const VFVPointOctree> pointOctree; /*!< The level of detail octree over "points"*/
+        uint32_t pointStride = 1; /*!< "points" holds every pointStride-th point of the dataset while the octree over every point is built, 1 afterwards*/
+        uint32_t nbPoints    = 0; /*!< The number of points of the dataset*/
     };
 }
 
@@ -2,6 +2,7 @@
 #define  VFVBUFFERVALUE_INC
 
 #include <vector>
+#include <algorithm>
 #include <cstdint>
 
 namespace sereno
@@ -32,6 +33,19 @@ namespace sereno
             buffer.push_back(b);
         }
 
+        /* \brief push several uint8_t values into the buffer without going beyond maxSize
+         * \param b the values to push
+         * \param size the number of values available in b
+         * \return the number of values consumed from b */
+        uint32_t pushValues(const uint8_t* b, uint32_t size)
+        {
+            if(maxSize < 0)
+                return 0;
+            uint32_t n = std::min<uint32_t>(size, maxSize - buffer.size());
+            buffer.insert(buffer.end(), b, b+n);
+            return n;
+        }
+
         /* \brief Set the desired maximum buffer size
          * \param size the desired maximum buffer size. */
         void setMaxSize(int32_t size)
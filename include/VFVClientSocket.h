@@ -18,9 +18,11 @@
 #include "VFVBufferValue.h"
 #include "Types/ServerType.h"
 #include "writeData.h"
+#include "readData.h"
 #include "Quaternion.h"
 #include "VolumetricSelection.h"
 #include "Triangulor.h"
+#include "VFVSelectionEvaluator.h"
 
 #define CLIENT_PORT 8000
 
@@ -84,9 +86,24 @@ namespace sereno
         RENAME_SUBDATASET                      = 41,
         SAVE_SUBDATASET_VISUAL                 = 42,
         VOLUMETRIC_SELECTION_METHOD            = 43,
+        IDENT_HEADSET_FRAMED                   = 44,
+        IDENT_TABLET_FRAMED                    = 45,
+        CLIENT_FEATURES                        = 46,
+        CANCEL_SELECTION                       = 47,
+        SELECTION_PREVIEW                      = 48,
+        VOLUMETRIC_MASK_RESYNC                 = 49,
         END_MESSAGE_TYPE
     };
 
+    /** \brief  The optional protocol features a client can announce with CLIENT_FEATURES */
+    enum VFVClientFeature
+    {
+        CLIENT_FEATURE_HEADSETS_STATUS_DELTA   = (1 << 0), /*!< The client understands VFV_SEND_HEADSETS_STATUS_DELTA instead of VFV_SEND_HEADSETS_STATUS*/
+        CLIENT_FEATURE_QUANTIZED_ROTATION      = (1 << 1), /*!< The client accepts quantized headset rotations in VFV_SEND_HEADSETS_STATUS_DELTA*/
+        CLIENT_FEATURE_ENCODED_VOLUMETRIC_MASK = (1 << 2), /*!< The client understands VFV_SEND_VOLUMETRIC_MASK_ENCODED instead of VFV_SEND_VOLUMETRIC_MASK*/
+        CLIENT_FEATURE_VOLUMETRIC_MASK_DELTA   = (1 << 3), /*!< The client understands VFV_SEND_VOLUMETRIC_MASK_DELTA instead of VFV_SEND_VOLUMETRIC_MASK(_ENCODED)*/
+    };
+
     /** \brief Enumeration of the client current action */
     enum VFVHeadsetCurrentActionType
     {
@@ -203,6 +220,10 @@ namespace sereno
             struct VFVRenameSubDataset                          renameSD;                 /*!< Rename a subdataset*/
             struct VFVSaveSubDatasetVisual                      saveSDVisual;             /*!< Save on disk the image of the subdataset*/
             struct VFVVolumetricSelectionMethod                          volumetricSelectionMethod; /*!< Select along the z axis*/
+            struct VFVClientFeatures                            clientFeatures;           /*!< The protocol features supported by the client*/
+            struct VFVCancelSelection                           cancelSelection;          /*!< Cancel a volumetric selection being computed*/
+            struct VFVSelectionPreviewRequest                   selectionPreview;         /*!< Start or stop the live preview of the volumetric selection*/
+            struct VFVVolumetricMaskResync                      volumetricMaskResync;     /*!< Ask for the whole volumetric mask of a subdataset*/
         };
 
         VFVMessage() : type(NOTHING)
@@ -223,10 +244,12 @@ namespace sereno
                     switch(type)
                     {
                         case IDENT_HEADSET:
+                        case IDENT_HEADSET_FRAMED:
                             noData = cpy.noData;
                             curMsg = &noData;
                             break;
                         case IDENT_TABLET:
+                        case IDENT_TABLET_FRAMED:
                             identTablet = cpy.identTablet;
                             curMsg = &identTablet;
                             break;
@@ -398,6 +421,22 @@ namespace sereno
                             volumetricSelectionMethod = cpy.volumetricSelectionMethod;
                             curMsg = &volumetricSelectionMethod;
                             break;
+                        case CLIENT_FEATURES:
+                            clientFeatures = cpy.clientFeatures;
+                            curMsg = &clientFeatures;
+                            break;
+                        case CANCEL_SELECTION:
+                            cancelSelection = cpy.cancelSelection;
+                            curMsg = &cancelSelection;
+                            break;
+                        case SELECTION_PREVIEW:
+                            selectionPreview = cpy.selectionPreview;
+                            curMsg = &selectionPreview;
+                            break;
+                        case VOLUMETRIC_MASK_RESYNC:
+                            volumetricMaskResync = cpy.volumetricMaskResync;
+                            curMsg = &volumetricMaskResync;
+                            break;
                         default:
                             WARNING << "Type " << cpy.type << " not handled yet in the copy constructor " << std::endl;
                             break;
@@ -422,11 +461,13 @@ namespace sereno
             switch(t)
             {
                 case IDENT_HEADSET:
+                case IDENT_HEADSET_FRAMED:
                     new (&noData) VFVNoDataInformation;
                     curMsg = &noData;
                     noData.type = t;
                     break;
                 case IDENT_TABLET:
+                case IDENT_TABLET_FRAMED:
                     new (&identTablet) VFVIdentTabletInformation;
                     curMsg = &identTablet;
                     break;
@@ -599,6 +640,22 @@ namespace sereno
                     new(&volumetricSelectionMethod) VFVVolumetricSelectionMethod;
                     curMsg = &volumetricSelectionMethod;
                     break;
+                case CLIENT_FEATURES:
+                    new(&clientFeatures) VFVClientFeatures;
+                    curMsg = &clientFeatures;
+                    break;
+                case CANCEL_SELECTION:
+                    new(&cancelSelection) VFVCancelSelection;
+                    curMsg = &cancelSelection;
+                    break;
+                case SELECTION_PREVIEW:
+                    new(&selectionPreview) VFVSelectionPreviewRequest;
+                    curMsg = &selectionPreview;
+                    break;
+                case VOLUMETRIC_MASK_RESYNC:
+                    new(&volumetricMaskResync) VFVVolumetricMaskResync;
+                    curMsg = &volumetricMaskResync;
+                    break;
                 case NOTHING:
                     break;
                 default:
@@ -615,9 +672,11 @@ namespace sereno
             switch(type)
             {
                 case IDENT_HEADSET:
+                case IDENT_HEADSET_FRAMED:
                     noData.~VFVNoDataInformation();
                     break;
                 case IDENT_TABLET:
+                case IDENT_TABLET_FRAMED:
                     identTablet.~VFVIdentTabletInformation();
                     break;
                 case ADD_BINARY_DATASET:
@@ -746,6 +805,18 @@ namespace sereno
                 case VOLUMETRIC_SELECTION_METHOD:
                     volumetricSelectionMethod.~VFVVolumetricSelectionMethod();
                     break;
+                case CLIENT_FEATURES:
+                    clientFeatures.~VFVClientFeatures();
+                    break;
+                case CANCEL_SELECTION:
+                    cancelSelection.~VFVCancelSelection();
+                    break;
+                case SELECTION_PREVIEW:
+                    selectionPreview.~VFVSelectionPreviewRequest();
+                    break;
+                case VOLUMETRIC_MASK_RESYNC:
+                    volumetricMaskResync.~VFVVolumetricMaskResync();
+                    break;
                 case NOTHING:
                     break;
                 default:
@@ -789,16 +860,34 @@ namespace sereno
         Quaternionf rotation; /*!< The rotation*/
     };
 
+    /** \brief  A closed part of a tangible brush mesh, extruded between two consecutive lasso positions */
+    struct VFVTangibleBrushSlice
+    {
+        std::vector<glm::vec3> points;    /*!< The two lasso rings*/
+        std::vector<uint32_t>  triangles; /*!< The side and cap triangles*/
+    };
+
     /** \brief  The tangible brush mesh data */
     struct VFVTangibleBrushMesh : public VolumetricMesh
     {
         std::vector<glm::vec2> lasso; /*!< The lasso associated to this mesh*/
         bool isClosed = false; /*!< Is this mesh closed?*/
+        VFVSelectionOp selectionOp; /*!< How this mesh is combined with the previous ones*/
 
-        VFVTangibleBrushMesh(const std::vector<glm::vec2>& _lasso, BooleanSelectionOp _op = SELECTION_OP_NONE) : VolumetricMesh(_op), lasso(_lasso) {};
+        VFVTangibleBrushMesh(const std::vector<glm::vec2>& _lasso, BooleanSelectionOp _op = SELECTION_OP_NONE) : VolumetricMesh(_op), lasso(_lasso), selectionOp(getSelectionOp(_op)) {};
 
         /** \brief  Close this mesh */
         void close();
+
+        /** \brief  Get the number of slices extruded so far (the number of lasso positions minus one)
+         * \return   the number of slices */
+        size_t getNbSlices() const;
+
+        /** \brief  Get one slice of this mesh, closed by the lasso triangulation on both ends.
+         * The parity of the whole mesh is the XOR of the parities of its slices (the internal caps cancel each other)
+         * \param sliceID the slice to get (< getNbSlices())
+         * \param slice[out] the slice */
+        void getSlice(size_t sliceID, VFVTangibleBrushSlice& slice) const;
     };
 
     /** \brief  The volumetric data of the associated headset */
@@ -831,6 +920,7 @@ namespace sereno
         uint32_t                    id;                                             /*!< ID of the headset*/
         VFVClientSocket*            tablet = NULL;                                  /*!< The tablet bound to this Headset*/
         uint32_t                    color  = 0x000000;                              /*!< The displayed color representing this headset*/
+        bool                        ownColor = false;                               /*!< Was "color" taken from the available colors? false if it is shared with other headsets*/
         glm::vec3                   position;                                       /*!< 3D position of the headset*/
         Quaternionf                 rotation;                                       /*!< 3D rotation of the headset*/
         bool                        anchoringSent = false;                          /*!< Has the anchoring data been sent?*/
@@ -852,6 +942,29 @@ namespace sereno
         }
     };
 
+    /** \brief  The state of a headset as last sent to a given client (see VFV_SEND_HEADSETS_STATUS_DELTA) */
+    struct VFVHeadsetStatus
+    {
+        uint32_t color                = 0;             /*!< The headset color*/
+        uint32_t currentAction        = HEADSET_CURRENT_ACTION_NOTHING; /*!< The headset current action*/
+        float    position[3]          = {0, 0, 0};     /*!< The headset position*/
+        float    rotation[4]          = {1, 0, 0, 0};  /*!< The headset rotation*/
+        uint32_t pointingIT           = POINTING_NONE; /*!< The pointing interaction technique in use*/
+        int32_t  pointingDatasetID    = -1;            /*!< The dataset the user is manipulating*/
+        int32_t  pointingSubDatasetID = -1;            /*!< The subdataset the user is manipulating*/
+        bool     pointingInPublic     = true;          /*!< Is the user manipulating the dataset in the public space?*/
+        float    pointingPosition[10] = {0};           /*!< The pointing local SD position (3), headset start position (3) and headset start orientation (4)*/
+    };
+
+    /** \brief  A complete message received in framed mode, not decoded yet.
+     * A frame is a uint32_t byte length followed by the message (uint16_t type + payload) */
+    struct VFVFrame
+    {
+        std::shared_ptr<uint8_t> owner;       /*!< The owner of "data" if the frame was copied, NULL if "data" is a view over the receive buffer*/
+        const uint8_t*           data = NULL; /*!< The frame content (type + payload)*/
+        uint32_t                 size = 0;    /*!< The frame content size in bytes*/
+    };
+
     /* \brief VFVClientSocket class. Represent a Client for VFV Application */
     class VFVClientSocket : public ClientSocket
     {
@@ -863,6 +976,33 @@ namespace sereno
 
             bool feedMessage(uint8_t* message, uint32_t size);
 
+            /* \brief Copy the pending frames that are still views over the receive buffer given to feedMessage.
+             * Must be called before that buffer is released, i.e., before returning from the call that received it */
+            void detachFrames();
+
+            /* \brief Is this client using the length-prefixed framed protocol?
+             * This mode is enabled once IDENT_HEADSET_FRAMED or IDENT_TABLET_FRAMED is received.
+             * \return true if yes, false if the client uses the legacy cursor-driven protocol */
+            bool isFramed() const {return m_framed;}
+
+            /* \brief Does this client support a given optional feature?
+             * \param feature the feature to test
+             * \return true if the client announced this feature through CLIENT_FEATURES, false otherwise */
+            bool hasFeature(VFVClientFeature feature) const {return (m_features & feature) != 0;}
+
+            /* \brief Set the optional features this client supports. This resets the headsets status and the volumetric mask sequence numbers
+             * last sent to this client: the next updates are sent in full
+             * \param features bitmask of VFVClientFeature */
+            void setFeatures(uint32_t features) {m_features = features; m_sentHeadsetsStatus.clear(); m_volumetricMaskSequences.clear();}
+
+            /* \brief Get the headsets status last sent to this client, per headset ID. Used to compute VFV_SEND_HEADSETS_STATUS_DELTA messages
+             * \return the headsets status last sent */
+            std::map<uint32_t, VFVHeadsetStatus>& getSentHeadsetsStatus() {return m_sentHeadsetsStatus;}
+
+            /* \brief Get the sequence number of the volumetric mask last sent to this client, per (datasetID, subDatasetID). Used to compute VFV_SEND_VOLUMETRIC_MASK_DELTA messages
+             * \return the sequence numbers last sent. A missing entry means that the client needs the whole mask */
+            std::map<std::pair<uint32_t, uint32_t>, uint32_t>& getVolumetricMaskSequences() {return m_volumetricMaskSequences;}
+
             /* \brief Set the client as tablet
              * \param headset IP the headset IP 
              * \param handedness the tablet's handedness*/
@@ -919,6 +1059,22 @@ namespace sereno
         private:
             static uint32_t nextHeadsetID;
 
+            /* \brief Feed the message when the client uses the framed protocol.
+             * Complete frames are only delimited here and decoded in pullMessage
+             * \param message the received data
+             * \param size the received data size
+             * \return true on success, false otherwise */
+            bool feedFramedMessage(uint8_t* message, uint32_t size);
+
+            /* \brief Decode a frame into a message
+             * \param frame the frame to decode
+             * \param msg[out] the message to fill
+             * \return true on success, false if the frame is malformed or its type unknown */
+            bool decodeFrame(const VFVFrame& frame, VFVMessage* msg);
+
+            /* \brief Push the current parsed message (legacy protocol) in the list of messages parsed */
+            void pushCurrentMessage();
+
             std::queue<VFVMessage> m_messages; /*!< List of messages parsed*/
             VFVMessage             m_curMsg;   /*!< The current in read message*/
             int32_t                m_cursor;   /*!< Indice cursor (what information ID are we reading at ?)*/
@@ -939,6 +1095,16 @@ namespace sereno
             VFVBufferValue<std::string> stringBuffer;     /*!< The current std::string buffer*/
             uint8_t*                    arrBuffer = NULL; /*!< The uint8_t array buffer*/
             uint32_t                    arrBufferIdx;     /*!< The current array buffer Idx*/
+
+            bool                        m_framed = false;      /*!< Is the client using the framed protocol?*/
+            std::queue<VFVFrame>        m_frames;              /*!< The complete frames not decoded yet*/
+            VFVBufferValue<uint32_t>    m_frameSizeBuffer;     /*!< The size of the frame being received*/
+            uint8_t*                    m_frameBuffer = NULL;  /*!< The frame being received when it spans several received segments*/
+            uint32_t                    m_frameBufferIdx = 0;  /*!< The current m_frameBuffer Idx*/
+
+            uint32_t                             m_features = 0;       /*!< The supported optional features (bitmask of VFVClientFeature)*/
+            std::map<uint32_t, VFVHeadsetStatus> m_sentHeadsetsStatus; /*!< The headsets status last sent to this client*/
+            std::map<std::pair<uint32_t, uint32_t>, uint32_t> m_volumetricMaskSequences; /*!< The volumetric mask sequence numbers last sent to this client*/
     };
 }
 
@@ -0,0 +1,53 @@
+#ifndef  VFVCLOUDPOINTFILE_INC
+#define  VFVCLOUDPOINTFILE_INC
+
+#include <string>
+#include "VFVPointInMesh.h"
+
+namespace sereno
+{
+    /** \brief  Reader of the point positions of a cloud point (.cp) file, as written by new_gen_spring.py:
+     * the number of points (uint32), then the big endian positions (x, y, z floats), then one big endian float value per point.
+     * The byte order of the number of points is deduced from the file size. The values are left to CloudPointDataset::loadValues.
+     * The file is read with pread: a reader can be shared by several threads reading different ranges */
+    class VFVCloudPointReader
+    {
+        public:
+            VFVCloudPointReader() {}
+
+            /** \brief  Destructor. Close the file */
+            ~VFVCloudPointReader();
+
+            /* Explicitly disallow copying. */
+            VFVCloudPointReader(const VFVCloudPointReader&)            = delete;
+            VFVCloudPointReader& operator=(const VFVCloudPointReader&) = delete;
+
+            /** \brief  Open a file and read its header
+             * \param path the file to read
+             * \return   true on success, false otherwise (an error is logged) */
+            bool open(const std::string& path);
+
+            /** \brief  Get the number of points of the opened file
+             * \return   the number of points */
+            uint32_t getNbPoints() const {return m_nbPoints;}
+
+            /** \brief  Read a range of positions, VFV_CLOUD_POINT_FILE_CHUNK points at a time
+             * \param begin the first point to read
+             * \param end the point after the last one to read
+             * \param xyz[out] the interleaved positions of the points [begin, end). 3*(end-begin) floats
+             * \return   true on success, false otherwise (an error is logged) */
+            bool readPositions(uint32_t begin, uint32_t end, float* xyz) const;
+
+            /** \brief  Read an evenly decimated subset of the positions: the points 0, stride, 2*stride, ... (see VFVPointCloud::decimate)
+             * \param maxPoints the maximum number of points to read. Must be > 0
+             * \param points[out] the owned positions read
+             * \return   the stride, 0 on error */
+            uint32_t readDecimatedPositions(size_t maxPoints, VFVPointCloud& points) const;
+        private:
+            std::string m_path;          /*!< The file path*/
+            int         m_fd       = -1; /*!< The file descriptor*/
+            uint32_t    m_nbPoints = 0;  /*!< The number of points*/
+    };
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef  VFVCOMPUTEPOOL_INC
+#define  VFVCOMPUTEPOOL_INC
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+namespace sereno
+{
+    /** \brief  The priorities of the tasks run by a VFVComputePool. Lower values run first */
+    enum VFVTaskPriority
+    {
+        TASK_PRIORITY_HIGH   = 0, /*!< Interactive work a user is waiting for (e.g., volumetric selections)*/
+        TASK_PRIORITY_NORMAL = 1, /*!< Default priority (e.g., mask encoding)*/
+        TASK_PRIORITY_LOW    = 2, /*!< Background work (e.g., dataset loading)*/
+        TASK_PRIORITY_COUNT       /*!< The number of priorities*/
+    };
+
+    /** \brief  Pool of worker threads running heavy computations.
+     * Each worker owns one deque per priority. Tasks pushed by a worker go to its own deques (and are popped LIFO),
+     * tasks pushed by other threads are distributed in a round-robin way. An idle worker steals the oldest tasks of the other workers.
+     * Priorities are honoured across workers: a worker looks for a task of a given priority in every deque before looking at a lower priority.
+     *
+     * The number of queued tasks is bounded: push() blocks the calling thread until there is room.
+     * Workers themselves never block when pushing (they could otherwise wait for each other): they may exceed the bound. */
+    class VFVComputePool
+    {
+        public:
+            /** \brief  Constructor. No thread is started before launch() is called
+             * \param maxTasks the maximum number of queued tasks (not yet running) */
+            VFVComputePool(uint32_t maxTasks);
+
+            /** \brief  Destructor. Close the pool and join the workers */
+            ~VFVComputePool();
+
+            /* Explicitly disallow copying. */
+            VFVComputePool(const VFVComputePool&)            = delete;
+            VFVComputePool& operator=(const VFVComputePool&) = delete;
+
+            /** \brief  Start the workers
+             * \param nbThreads the number of workers. 0 == one per hardware thread (minus one for the network thread)
+             * \return   true on success, false if the pool is already launched or closed */
+            bool launch(uint32_t nbThreads = 0);
+
+            /** \brief  Ask the workers to stop. The tasks not started yet are discarded and the threads blocked in push() are released */
+            void close();
+
+            /** \brief  Wait for the workers to stop. See close() */
+            void wait();
+
+            /** \brief  Push a task. Block while the pool is full, unless called from a worker
+             * \param f the task to run
+             * \param priority the task priority
+             * \return   true on success, false if the pool is closed (the task is then discarded) */
+            bool push(const std::function<void(void)>& f, VFVTaskPriority priority = TASK_PRIORITY_NORMAL);
+
+            /** \brief  Push a task if the pool is not full
+             * \param f the task to run
+             * \param priority the task priority
+             * \return   true on success, false if the pool is full or closed (the task is then discarded) */
+            bool tryPush(const std::function<void(void)>& f, VFVTaskPriority priority = TASK_PRIORITY_NORMAL);
+
+            /** \brief  Call f(0), f(1), ..., f(nbIterations-1) in parallel and wait for them.
+             * The calling thread runs iterations as well, so this can be called from a task of this pool without deadlocking,
+             * and it does not wait for room in the pool (helpers are only added if there is room).
+             * \param nbIterations the number of iterations
+             * \param f the function to call per iteration
+             * \param priority the priority of the helper tasks
+             * \param maxParallelism the maximum number of iterations running at once, the calling thread included. 0 == no limit */
+            void parallelFor(size_t nbIterations, const std::function<void(size_t)>& f, VFVTaskPriority priority = TASK_PRIORITY_NORMAL,
+                             size_t maxParallelism = 0);
+
+            /** \brief  Get the number of workers
+             * \return   the number of worker threads */
+            uint32_t getNbThreads() const {return m_workers.size();}
+
+            /** \brief  Get the number of tasks run since the creation of this pool
+             * \return   the number of executed tasks */
+            uint64_t getNbExecuted() const {return m_nbExecuted;}
+
+            /** \brief  Get the number of tasks a worker took from the deques of another worker
+             * \return   the number of stolen tasks */
+            uint64_t getNbStolen() const {return m_nbStolen;}
+
+            /** \brief  Get the number of push() calls which had to wait for room in the pool
+             * \return   the number of blocked pushes */
+            uint64_t getNbBlockedPushes() const {return m_nbBlockedPushes;}
+
+            /** \brief  Get the maximum number of tasks queued at once
+             * \return   the highest number of queued tasks */
+            uint32_t getMaxQueued() const {return m_maxQueued;}
+        private:
+            /** \brief  The queues of one worker */
+            struct Worker
+            {
+                std::mutex                              mutex;                     /*!< Protect tasks*/
+                std::deque<std::function<void(void)>>   tasks[TASK_PRIORITY_COUNT]; /*!< The tasks per priority*/
+                std::thread                             thread;                    /*!< The worker thread*/
+            };
+
+            /** \brief  Push a task. m_mutex has to be locked and the pool must not be full
+             * \param f the task to run
+             * \param priority the task priority */
+            void pushLocked(const std::function<void(void)>& f, VFVTaskPriority priority);
+
+            /** \brief  Pop the next task to run
+             * \param workerID the worker asking for a task
+             * \param f[out] the task to run
+             * \return   true if a task was found, false otherwise */
+            bool pop(uint32_t workerID, std::function<void(void)>& f);
+
+            /** \brief  The worker thread function
+             * \param workerID the worker ID */
+            void workerThread(uint32_t workerID);
+
+            /** \brief  Get the ID of the worker calling this method
+             * \return   the worker ID, or -1 if not called by a worker of this pool */
+            int32_t getCurrentWorkerID() const;
+
+            std::vector<std::unique_ptr<Worker>> m_workers;  /*!< The workers*/
+            std::mutex              m_mutex;                 /*!< Protect m_nbQueued and m_closed, and serializes the pushes*/
+            std::condition_variable m_workCond;              /*!< Notified when a task is pushed or when the pool closes*/
+            std::condition_variable m_spaceCond;             /*!< Notified when a task is popped or when the pool closes*/
+            uint32_t                m_maxTasks;              /*!< The maximum number of queued tasks*/
+            uint32_t                m_nbQueued  = 0;         /*!< The number of queued tasks*/
+            uint32_t                m_nextWorker = 0;        /*!< The worker receiving the next task pushed by a non-worker thread*/
+            bool                    m_launched  = false;     /*!< Have the workers been started? m_workers does not change afterward*/
+            bool                    m_closed    = false;     /*!< Is the pool closed?*/
+            std::atomic<uint64_t>   m_nbExecuted{0};         /*!< The number of executed tasks*/
+            std::atomic<uint64_t>   m_nbStolen{0};           /*!< The number of stolen tasks*/
+            std::atomic<uint64_t>   m_nbBlockedPushes{0};    /*!< The number of push() calls which waited for room*/
+            std::atomic<uint32_t>   m_maxQueued{0};          /*!< The maximum number of tasks queued at once*/
+    };
+}
+
+#endif
@@ -1819,6 +1819,108 @@ namespace sereno
         int32_t getMaxCursor() const {return 1;}
     };
 
+    /** \brief  Cancel the volumetric selection being computed on a SubDataset */
+    struct VFVCancelSelection : public VFVDataInformation
+    {
+        int32_t datasetID    = 0;  /*!< The dataset ID*/
+        int32_t subDatasetID = -1; /*!< The subdataset ID*/
+
+        bool pushValue(uint32_t cursor, uint32_t value)
+        {
+            if(cursor == 0)
+                datasetID = value;
+            else if(cursor == 1)
+                subDatasetID = value;
+            else
+                VFV_DATA_ERROR
+            return true;
+        }
+
+        char getTypeAt(uint32_t cursor) const {return 'I';}
+
+        virtual std::string toJson(const std::string& sender, const std::string& headsetIP, time_t timeOffset) const
+        {
+            std::ostringstream oss;
+
+            VFV_BEGINING_TO_JSON(oss, sender, headsetIP, timeOffset, "CancelSelection");
+            oss << ",    \"datasetID\" : " << datasetID << ",\n" 
+                << "    \"subDatasetID\" : " << subDatasetID << "\n";
+            VFV_END_TO_JSON(oss);
+
+            return oss.str();
+        }
+
+        int32_t getMaxCursor() const {return 1;}
+    };
+
+    /** \brief  Start (or stop) the live preview of the volumetric selection being extruded */
+    struct VFVSelectionPreviewRequest : public VFVDataInformation
+    {
+        int32_t datasetID    = -1; /*!< The dataset ID. -1 == stop the preview*/
+        int32_t subDatasetID = -1; /*!< The subdataset ID. -1 == stop the preview*/
+
+        bool pushValue(uint32_t cursor, uint32_t value)
+        {
+            if(cursor == 0)
+                datasetID = value;
+            else if(cursor == 1)
+                subDatasetID = value;
+            else
+                VFV_DATA_ERROR
+            return true;
+        }
+
+        char getTypeAt(uint32_t cursor) const {return 'I';}
+
+        virtual std::string toJson(const std::string& sender, const std::string& headsetIP, time_t timeOffset) const
+        {
+            std::ostringstream oss;
+
+            VFV_BEGINING_TO_JSON(oss, sender, headsetIP, timeOffset, "SelectionPreview");
+            oss << ",    \"datasetID\" : " << datasetID << ",\n"
+                << "    \"subDatasetID\" : " << subDatasetID << "\n";
+            VFV_END_TO_JSON(oss);
+
+            return oss.str();
+        }
+
+        int32_t getMaxCursor() const {return 1;}
+    };
+
+    /** \brief  Ask for the whole volumetric mask of a subdataset (e.g., a VFV_SEND_VOLUMETRIC_MASK_DELTA could not be applied) */
+    struct VFVVolumetricMaskResync : public VFVDataInformation
+    {
+        int32_t datasetID    = 0;  /*!< The dataset ID*/
+        int32_t subDatasetID = -1; /*!< The subdataset ID*/
+
+        bool pushValue(uint32_t cursor, uint32_t value)
+        {
+            if(cursor == 0)
+                datasetID = value;
+            else if(cursor == 1)
+                subDatasetID = value;
+            else
+                VFV_DATA_ERROR
+            return true;
+        }
+
+        char getTypeAt(uint32_t cursor) const {return 'I';}
+
+        virtual std::string toJson(const std::string& sender, const std::string& headsetIP, time_t timeOffset) const
+        {
+            std::ostringstream oss;
+
+            VFV_BEGINING_TO_JSON(oss, sender, headsetIP, timeOffset, "VolumetricMaskResync");
+            oss << ",    \"datasetID\" : " << datasetID << ",\n"
+                << "    \"subDatasetID\" : " << subDatasetID << "\n";
+            VFV_END_TO_JSON(oss);
+
+            return oss.str();
+        }
+
+        int32_t getMaxCursor() const {return 1;}
+    };
+
     /* \brief Represents the information about VTK Datasets*/
     struct VFVVTKDatasetInformation : public VFVDataInformation
     {
@@ -2722,6 +2824,41 @@ namespace sereno
 
         int32_t getMaxCursor() const {return 0;}
     };
+
+    /** \brief  The optional protocol features a client supports (see VFVClientFeature) */
+    struct VFVClientFeatures : public VFVDataInformation
+    {
+        uint32_t features = 0; /*!< Bitmask of VFVClientFeature*/
+
+        char getTypeAt(uint32_t cursor) const
+        {
+            if(cursor == 0)
+                return 'I';
+            return 0;
+        }
+
+        bool pushValue(uint32_t cursor, uint32_t value)
+        {
+            if(cursor == 0)
+                features = value;
+            else
+                VFV_DATA_ERROR
+            return true;
+        }
+
+        virtual std::string toJson(const std::string& sender, const std::string& headsetIP, time_t timeOffset) const
+        {
+            std::ostringstream oss;
+
+            VFV_BEGINING_TO_JSON(oss, sender, headsetIP, timeOffset, "ClientFeatures");
+            oss << ",    \"features\" : " << features << "\n" ;
+            VFV_END_TO_JSON(oss);
+
+            return oss.str();
+        }
+
+        int32_t getMaxCursor() const {return 0;}
+    };
 }
 
 #undef VFV_DATA_ERROR
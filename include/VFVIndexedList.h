@@ -0,0 +1,84 @@
+#ifndef  VFVINDEXEDLIST_INC
+#define  VFVINDEXEDLIST_INC
+
+#include <cstdint>
+#include <list>
+#include <iterator>
+#include <unordered_map>
+
+namespace sereno
+{
+    /** \brief  A list of elements, in insertion order, indexed by one of their members (e.g., the SubDataset ID of SubDatasetMetaData).
+     * The elements are never moved: pointers to them stay valid until they are erased
+     * \tparam T the type of the elements
+     * \tparam ID the member of T identifying an element. It must not change while the element is in the list */
+    template <typename T, uint64_t T::*ID>
+    class VFVIndexedList
+    {
+        public:
+            typedef typename std::list<T>::iterator       iterator;
+            typedef typename std::list<T>::const_iterator const_iterator;
+
+            VFVIndexedList() {}
+
+            VFVIndexedList(const VFVIndexedList& cpy) {*this = cpy;}
+
+            VFVIndexedList& operator=(const VFVIndexedList& cpy)
+            {
+                if(this != &cpy)
+                {
+                    clear();
+                    for(const T& t : cpy)
+                        push_back(t);
+                }
+                return *this;
+            }
+
+            /** \brief  Add an element. No element with the same ID must be in the list
+             * \param t the element to add */
+            void push_back(const T& t)
+            {
+                m_list.push_back(t);
+                m_index[t.*ID] = std::prev(m_list.end());
+            }
+
+            /** \brief  Remove an element
+             * \param it the element to remove
+             * \return   the element following it */
+            iterator erase(iterator it)
+            {
+                m_index.erase((*it).*ID);
+                return m_list.erase(it);
+            }
+
+            /** \brief  Remove every element */
+            void clear()
+            {
+                m_index.clear();
+                m_list.clear();
+            }
+
+            /** \brief  Find an element in constant time
+             * \param id the element ID
+             * \return   the element, end() if not found */
+            iterator find(uint64_t id)
+            {
+                auto it = m_index.find(id);
+                return (it == m_index.end() ? m_list.end() : it->second);
+            }
+
+            T&     back()        {return m_list.back();}
+            size_t size()  const {return m_list.size();}
+            bool   empty() const {return m_list.empty();}
+
+            iterator       begin()       {return m_list.begin();}
+            iterator       end()         {return m_list.end();}
+            const_iterator begin() const {return m_list.begin();}
+            const_iterator end()   const {return m_list.end();}
+        private:
+            std::list<T>                           m_list;  /*!< The elements, in insertion order*/
+            std::unordered_map<uint64_t, iterator> m_index; /*!< The elements per ID*/
+    };
+}
+
+#endif
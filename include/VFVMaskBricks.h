@@ -0,0 +1,87 @@
+#ifndef  VFVMASKBRICKS_INC
+#define  VFVMASKBRICKS_INC
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include "config.h"
+
+namespace sereno
+{
+    /** \brief  Finds the bricks of a volumetric mask which changed since it was last sent, without keeping a copy of the mask.
+     *
+     * The code writing the mask marks the bricks it may modify (markDirty, markPoint, markAllDirty).
+     * update() then hashes the marked bricks only, and reports those whose hash differs from the one last sent:
+     * a brick written with the same content is not sent again. The hashes are 64 bits wide: a collision hiding a change is negligible.
+     * Marking is thread safe (e.g., from the compute pool tasks writing the mask), but must not run concurrently with update() */
+    class VFVMaskBricks
+    {
+        public:
+            /** \brief  Constructor. Every brick is considered dirty until the first update
+             * \param brickSize the size of the bricks, in bytes */
+            VFVMaskBricks(size_t brickSize = VOLUMETRIC_MASK_BRICK_SIZE);
+
+            /** \brief  Copy constructor
+             * \param copy the object to copy */
+            VFVMaskBricks(const VFVMaskBricks& copy);
+
+            /** \brief  Copy assignment
+             * \param copy the object to copy
+             * \return   *this */
+            VFVMaskBricks& operator=(const VFVMaskBricks& copy);
+
+            /** \brief  Mark the bricks covering a range of the mask as dirty
+             * \param begin the first byte of the range
+             * \param end the byte after the last one of the range */
+            void markDirty(size_t begin, size_t end)
+            {
+                if(begin >= end)
+                    return;
+                size_t last = (end-1)/m_brickSize;
+                for(size_t i = begin/m_brickSize; i <= last && i < m_nbBricks; i++)
+                    m_dirty[i].store(1, std::memory_order_relaxed);
+            }
+
+            /** \brief  Mark the brick containing one byte of the mask as dirty
+             * \param id the byte (i.e., the point) */
+            void markPoint(size_t id)
+            {
+                size_t brick = id/m_brickSize;
+                if(brick < m_nbBricks)
+                    m_dirty[brick].store(1, std::memory_order_relaxed);
+            }
+
+            /** \brief  Mark the whole mask as dirty, e.g., after restoring or resetting it */
+            void markAllDirty() {m_allDirty.store(true, std::memory_order_relaxed);}
+
+            /** \brief  Find the bricks which changed since the last update, and clear the dirty marks.
+             * A mask whose size changed (or the first mask given) is hashed entirely, and no brick is reported: the whole mask has to be sent.
+             * \param mask the mask
+             * \param size the mask size, in bytes
+             * \param changed[out] the dirty bricks whose content changed are appended here, in ascending order
+             * \return   true if the mask size changed (or if this is the first update), false otherwise */
+            bool update(const uint8_t* mask, size_t size, std::vector<uint32_t>& changed);
+
+            /** \brief  Get the size of the bricks
+             * \return   the size of the bricks, in bytes */
+            size_t getBrickSize() const {return m_brickSize;}
+
+            /** \brief  Hash one brick
+             * \param data the brick data
+             * \param size the brick size, in bytes
+             * \return   the hash */
+            static uint64_t hashBrick(const uint8_t* data, size_t size);
+        private:
+            size_t                                 m_brickSize;        /*!< The size of the bricks*/
+            size_t                                 m_size     = 0;     /*!< The mask size at the last update*/
+            size_t                                 m_nbBricks = 0;     /*!< The number of bricks at the last update*/
+            bool                                   m_updated  = false; /*!< Was update called at least once?*/
+            std::vector<uint64_t>                  m_hashes;           /*!< The hash of each brick, as last updated*/
+            std::unique_ptr<std::atomic<uint8_t>[]> m_dirty;           /*!< The dirty mark of each brick*/
+            std::atomic<bool>                      m_allDirty{false};  /*!< Is every brick dirty?*/
+    };
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef  VFVMASKENCODING_INC
+#define  VFVMASKENCODING_INC
+
+#include <cstdint>
+#include <cstddef>
+
+namespace sereno
+{
+    /** \brief  The encodings of a volumetric mask sent with VFV_SEND_VOLUMETRIC_MASK_ENCODED.
+     * Run lengths are unsigned LEB128 varints (7 bits per byte, least significant group first, bit 7 set if another byte follows) */
+    enum VFVMaskEncoding
+    {
+        VFV_MASK_ENCODING_RAW       = 0, /*!< The mask bytes as is*/
+        VFV_MASK_ENCODING_BITS      = 1, /*!< Every mask byte is 0 or 1: bit i%8 of byte i/8 is the mask byte i*/
+        VFV_MASK_ENCODING_BITS_RLE  = 2, /*!< Every mask byte is 0 or 1: the lengths of the runs of 0s and 1s, alternating, starting with 0s (the first run may be empty)*/
+        VFV_MASK_ENCODING_BYTES_RLE = 3, /*!< Pairs of (byte value, run length)*/
+    };
+
+    /** \brief  Choose the smallest encoding of a mask. Runs in one pass over the mask
+     * \param mask the mask to encode
+     * \param size the mask size in bytes
+     * \param encodedSize[out] the size of the mask once encoded
+     * \return   the encoding to use */
+    VFVMaskEncoding chooseMaskEncoding(const uint8_t* mask, size_t size, size_t* encodedSize);
+
+    /** \brief  Encode a mask
+     * \param mask the mask to encode
+     * \param size the mask size in bytes
+     * \param encoding the encoding to use. BITS and BITS_RLE expect a mask made of 0s and 1s only (see chooseMaskEncoding)
+     * \param out[out] where to write the encoded mask. Its size must be the encodedSize given by chooseMaskEncoding
+     * \return   the number of bytes written */
+    size_t encodeMask(const uint8_t* mask, size_t size, VFVMaskEncoding encoding, uint8_t* out);
+}
+
+#endif
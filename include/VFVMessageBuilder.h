@@ -0,0 +1,144 @@
+#ifndef  VFVMESSAGEBUILDER_INC
+#define  VFVMESSAGEBUILDER_INC
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "writeData.h"
+
+/* \brief The smallest size class (in power of two) of pooled buffers */
+#define VFV_BUFFER_POOL_MIN_CLASS         6
+
+/* \brief The biggest size class (in power of two) of pooled buffers. Bigger buffers are not pooled */
+#define VFV_BUFFER_POOL_MAX_CLASS         16
+
+/* \brief The maximum number of buffers kept per size class */
+#define VFV_BUFFER_POOL_MAX_PER_CLASS     256
+
+namespace sereno
+{
+    /** \brief  Pool of reusable outgoing message buffers sorted by size classes (powers of two).
+     * The pool keeps a reference on every buffer it created. A buffer is recycled once every SocketMessage referencing it
+     * has been written, i.e., when the pool is again its only owner. This avoids both the allocation of the buffer
+     * and of the shared_ptr control block for each sent message. */
+    class VFVBufferPool
+    {
+        public:
+            VFVBufferPool() {}
+
+            /* Explicitly disallow copying. */
+            VFVBufferPool(const VFVBufferPool&)            = delete;
+            VFVBufferPool& operator=(const VFVBufferPool&) = delete;
+
+            /** \brief  Get a buffer of at least "size" bytes. Its content is undefined
+             * \param size the minimum size of the buffer
+             * \param capacity[out] if not NULL, the real size of the returned buffer
+             * \return   the buffer. Release it (and all its copies) to recycle it */
+            std::shared_ptr<uint8_t> acquire(size_t size, size_t* capacity = NULL);
+
+            /** \brief  Get the number of buffers this pool had to allocate since its creation
+             * \return   the number of allocations */
+            uint64_t getNbAllocations() const {return m_nbAllocations;}
+
+            /** \brief  Get the number of buffers requested to this pool since its creation
+             * \return   the number of acquisitions */
+            uint64_t getNbAcquisitions() const {return m_nbAcquisitions;}
+        private:
+            /** \brief  The buffers of a given size */
+            struct SizeClass
+            {
+                std::vector<std::shared_ptr<uint8_t>> buffers;  /*!< The buffers owned by the pool*/
+                size_t                                next = 0; /*!< Where to start looking for a free buffer*/
+            };
+
+            std::mutex            m_mutex;              /*!< Protect m_classes*/
+            SizeClass             m_classes[VFV_BUFFER_POOL_MAX_CLASS-VFV_BUFFER_POOL_MIN_CLASS+1]; /*!< The size classes*/
+            std::atomic<uint64_t> m_nbAllocations{0};   /*!< The number of allocated buffers*/
+            std::atomic<uint64_t> m_nbAcquisitions{0};  /*!< The number of acquired buffers*/
+    };
+
+    /** \brief  Typed builder of outgoing messages (big endian), using a VFVBufferPool for its storage.
+     * The uint16_t message type is written first. The buffer grows if more than the initial capacity is written. */
+    class VFVMessageBuilder
+    {
+        public:
+            /** \brief  Constructor
+             * \param pool the pool to take the buffer from
+             * \param type the message type to write
+             * \param capacity the expected size of the payload (type excluded) */
+            VFVMessageBuilder(VFVBufferPool& pool, uint16_t type, size_t capacity = 0) : m_pool(pool)
+            {
+                m_data = m_pool.acquire(capacity + sizeof(uint16_t), &m_capacity);
+                pushUint16(type);
+            }
+
+            VFVMessageBuilder& pushUint16(uint16_t value)
+            {
+                writeUint16(reserve(sizeof(uint16_t)), value);
+                return *this;
+            }
+
+            VFVMessageBuilder& pushUint32(uint32_t value)
+            {
+                writeUint32(reserve(sizeof(uint32_t)), value);
+                return *this;
+            }
+
+            VFVMessageBuilder& pushFloat(float value)
+            {
+                writeFloat(reserve(sizeof(float)), value);
+                return *this;
+            }
+
+            VFVMessageBuilder& pushByte(uint8_t value)
+            {
+                reserve(sizeof(uint8_t))[0] = value;
+                return *this;
+            }
+
+            /** \brief  Push a string as its uint32_t size followed by its characters
+             * \param value the string to push */
+            VFVMessageBuilder& pushString(const std::string& value)
+            {
+                pushUint32(value.size());
+                return pushBytes((const uint8_t*)value.data(), value.size());
+            }
+
+            VFVMessageBuilder& pushBytes(const uint8_t* values, size_t size)
+            {
+                if(size)
+                    memcpy(reserve(size), values, size);
+                return *this;
+            }
+
+            /** \brief  Reserve "size" bytes at the end of the message, for the caller to fill
+             * \param size the number of bytes to reserve
+             * \return   where to write these bytes. Valid until the next push/reserve call */
+            uint8_t* reserve(size_t size);
+
+            /** \brief  Overwrite a uint32_t value already written (e.g., a counter known only at the end)
+             * \param offset the offset of the value in the message
+             * \param value the value to write */
+            void setUint32At(size_t offset, uint32_t value) {writeUint32(m_data.get()+offset, value);}
+
+            /** \brief  Get the current message size in bytes
+             * \return   the message size */
+            uint32_t getSize() const {return m_size;}
+
+            /** \brief  Get the message buffer, to share with SocketMessage objects
+             * \return   the message buffer */
+            const std::shared_ptr<uint8_t>& getData() const {return m_data;}
+        private:
+            VFVBufferPool&           m_pool;         /*!< The buffer pool*/
+            std::shared_ptr<uint8_t> m_data;         /*!< The message buffer*/
+            size_t                   m_capacity = 0; /*!< The buffer capacity*/
+            uint32_t                 m_size     = 0; /*!< The bytes written*/
+    };
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef  VFVPOINTINMESH_INC
+#define  VFVPOINTINMESH_INC
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/* \brief The maximum number of cells per axis of the VFVPointInMesh grid */
+#define VFV_POINT_IN_MESH_MAX_GRID_RES 64
+
+namespace sereno
+{
+    /** \brief  The instruction sets the point-in-mesh kernel can use */
+    enum VFVSIMDLevel
+    {
+        VFV_SIMD_SCALAR = 0, /*!< Plain C++*/
+        VFV_SIMD_SSE2   = 1, /*!< 4 points per instruction*/
+        VFV_SIMD_AVX2   = 2, /*!< 8 points per instruction*/
+    };
+
+    /** \brief  Get the best instruction set supported by this CPU (checked once, through CPUID)
+     * \return   the SIMD level to use */
+    VFVSIMDLevel getSIMDLevel();
+
+    /** \brief  Get a human readable name of a SIMD level
+     * \param level the SIMD level
+     * \return   its name */
+    const char* getSIMDLevelName(VFVSIMDLevel level);
+
+    /** \brief  The interleaved positions (x0, y0, z0, x1, y1, z1, ...) of a point cloud.
+     * They are either owned (e.g., a decimated copy) or borrowed from a buffer outliving this object (e.g., the positions a CloudPointDataset loaded) */
+    class VFVPointCloud
+    {
+        public:
+            VFVPointCloud() {}
+
+            /** \brief  Constructor borrowing positions
+             * \param xyz the positions. They are not copied and must outlive this object
+             * \param nbPoints the number of points */
+            VFVPointCloud(const float* xyz, size_t nbPoints) : m_xyz(xyz), m_nbPoints(nbPoints) {}
+
+            /* Explicitly disallow copying: a copy would borrow the owned positions of the original */
+            VFVPointCloud(const VFVPointCloud&)            = delete;
+            VFVPointCloud& operator=(const VFVPointCloud&) = delete;
+            VFVPointCloud(VFVPointCloud&&)                 = default;
+            VFVPointCloud& operator=(VFVPointCloud&&)      = default;
+
+            /** \brief  Allocate owned positions, to be filled by the caller
+             * \param nbPoints the number of points
+             * \return   the positions, 3*nbPoints floats */
+            float* allocate(size_t nbPoints)
+            {
+                m_storage.resize(3*nbPoints);
+                m_xyz      = m_storage.data();
+                m_nbPoints = nbPoints;
+                return m_storage.data();
+            }
+
+            /** \brief  Get the position of a point
+             * \param i the point index
+             * \return   its x, y, and z coordinates */
+            const float* operator[](size_t i) const {return m_xyz+3*i;}
+
+            /** \brief  Get the positions
+             * \return   the interleaved positions, 3*size() floats */
+            const float* data() const {return m_xyz;}
+
+            /** \brief  Get the number of points
+             * \return   the number of points */
+            size_t size() const {return m_nbPoints;}
+
+            /** \brief  Copy one point every "stride" points, the stride being the smallest one keeping at most maxPoints points
+             * \param maxPoints the maximum number of points to keep. Must be > 0
+             * \param subset[out] the owned copy of the kept points
+             * \return   the stride. The point i of subset is the point i*stride of this cloud */
+            uint32_t decimate(size_t maxPoints, VFVPointCloud& subset) const;
+        private:
+            std::vector<float> m_storage;           /*!< The owned positions. Empty if they are borrowed*/
+            const float*       m_xyz      = nullptr; /*!< The positions*/
+            size_t             m_nbPoints = 0;       /*!< The number of points*/
+    };
+
+    /** \brief  Point-in-closed-mesh test by ray casting (a ray along +X, counting the crossed triangles).
+     * The triangles are pre-processed once and tested against several points at once (SSE2 / AVX2 when available).
+     * Points outside the mesh bounding box are rejected early. The triangles are registered in a uniform grid over the YZ plane
+     * (the plane the rays are orthogonal to), so that a point is tested only against the triangles of its cell.
+     * Rays passing exactly through shared edges or vertices are handled consistently (top-left rule), so a watertight mesh gives exact parities. */
+    class VFVPointInMesh
+    {
+        public:
+            VFVPointInMesh() {clear();}
+
+            /** \brief  Constructor from a mesh
+             * \param mesh the closed mesh. See setMesh */
+            template<typename Mesh>
+            VFVPointInMesh(const Mesh& mesh) {setMesh(mesh);}
+
+            /** \brief  Set the triangles to test and build the acceleration grid
+             * \param mesh any mesh type containing "points" (having x, y, and z members) and "triangles" (three indices per triangle), e.g., VolumetricMesh */
+            template<typename Mesh>
+            void setMesh(const Mesh& mesh)
+            {
+                clear();
+                for(size_t i = 0; i+2 < mesh.triangles.size(); i+=3)
+                {
+                    const auto& a = mesh.points[mesh.triangles[i]];
+                    const auto& b = mesh.points[mesh.triangles[i+1]];
+                    const auto& c = mesh.points[mesh.triangles[i+2]];
+                    const float fa[3] = {(float)a.x, (float)a.y, (float)a.z};
+                    const float fb[3] = {(float)b.x, (float)b.y, (float)b.z};
+                    const float fc[3] = {(float)c.x, (float)c.y, (float)c.z};
+                    addTriangle(fa, fb, fc);
+                }
+                build();
+            }
+
+            /** \brief  Remove every triangle */
+            void clear();
+
+            /** \brief  Get the number of triangles kept
+             * \return   the number of triangles */
+            size_t getNbTriangles() const {return m_coefs[0].size();}
+
+            /** \brief  Get the number of triangles of the mesh surface, including the ones parallel to the X axis that are not kept for the ray casting
+             * \return   the number of triangles of the surface */
+            size_t getNbSurfaceTriangles() const {return m_surfaceBounds.size()/6;}
+
+            /** \brief  Get the bounding boxes of the triangles of the mesh surface, e.g., to know whether the surface may cross a region.
+             * A region no surface triangle crosses is either fully inside or fully outside the mesh
+             * \return   the bounding boxes (minX, minY, minZ, maxX, maxY, maxZ) per triangle, getNbSurfaceTriangles() boxes */
+            const float* getSurfaceBounds() const {return m_surfaceBounds.data();}
+
+            /** \brief  Get the number of cells per axis of the acceleration grid
+             * \return   the grid resolution. At least 1 once built (a single cell if there is no triangle), 0 before the first build or after clear() */
+            uint32_t getGridResolution() const {return m_gridRes;}
+
+            /** \brief  Get the minimum corner of the mesh bounding box. Meaningless if there is no triangle
+             * \return   the minimum corner (x, y, z) */
+            const float* getMin() const {return m_min;}
+
+            /** \brief  Get the maximum corner of the mesh bounding box. Meaningless if there is no triangle
+             * \return   the maximum corner (x, y, z) */
+            const float* getMax() const {return m_max;}
+
+            /** \brief  Test whether points are inside the mesh
+             * \param cloud the points to test
+             * \param begin the first point to test
+             * \param end the point after the last one to test
+             * \param inside[out] inside[i-begin] is set to 1 if the point i is inside the mesh, 0 otherwise
+             * \param level the instruction set to use. It must be supported by the CPU (see getSIMDLevel) */
+            void compute(const VFVPointCloud& cloud, size_t begin, size_t end, uint8_t* inside, VFVSIMDLevel level = getSIMDLevel()) const;
+        private:
+            /** \brief  The pre-computed values per triangle. The ray starting at (px, py, pz) crosses a triangle
+             * if its three edge functions e_i = EDY_i*(pz-EZ_i) - EDZ_i*(py-EY_i) are all > 0 (or == 0 with ETL_i != 0),
+             * and if PX0 + PXY*py + PXZ*pz > px */
+            enum Coef
+            {
+                COEF_EY0, COEF_EZ0, COEF_EDY0, COEF_EDZ0, COEF_ETL0,
+                COEF_EY1, COEF_EZ1, COEF_EDY1, COEF_EDZ1, COEF_ETL1,
+                COEF_EY2, COEF_EZ2, COEF_EDY2, COEF_EDZ2, COEF_ETL2,
+                COEF_PX0, COEF_PXY, COEF_PXZ,
+                COEF_COUNT,
+                COEF_EDGE_STRIDE = COEF_EY1 - COEF_EY0
+            };
+
+            /** \brief  Add a triangle. Triangles parallel to the X axis are ignored (a ray can only graze them)
+             * \param a the first vertex (x, y, z)
+             * \param b the second vertex
+             * \param c the third vertex */
+            void addTriangle(const float a[3], const float b[3], const float c[3]);
+
+            /** \brief  Build the acceleration grid once every triangle is added */
+            void build();
+
+            /** \brief  Get the cell index along one axis of the grid
+             * \param v the coordinate
+             * \param axis 0 for Y, 1 for Z
+             * \return   the cell index, clamped to the grid */
+            uint32_t getCell(float v, uint32_t axis) const;
+
+            /** \brief  Test points against a subset of the triangles (the kernels)
+             * \param xs the X coordinates of the points
+             * \param ys the Y coordinates of the points
+             * \param zs the Z coordinates of the points
+             * \param nbPoints the number of points
+             * \param triangles the indices of the triangles to test
+             * \param nbTriangles the number of triangles to test
+             * \param inside[out] the parity per point */
+            void computeScalar(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                               const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const;
+            void computeSSE2(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                             const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const;
+            void computeAVX2(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                             const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const;
+
+            std::vector<float>    m_coefs[COEF_COUNT]; /*!< The pre-computed values, one array per Coef*/
+            std::vector<float>    m_triangleBounds;    /*!< The projected bounding box (minY, maxY, minZ, maxZ) per triangle*/
+            std::vector<float>    m_surfaceBounds;     /*!< The bounding box (minX, minY, minZ, maxX, maxY, maxZ) of every non-degenerate triangle*/
+            float                 m_min[3];            /*!< The minimum corner of the mesh bounding box*/
+            float                 m_max[3];            /*!< The maximum corner of the mesh bounding box*/
+            uint32_t              m_gridRes = 0;       /*!< The number of cells per axis (Y and Z)*/
+            float                 m_invCellSize[2];    /*!< 1/(cell size) along Y and Z. 0 if the mesh is flat along an axis*/
+            std::vector<uint32_t> m_cellStart;         /*!< Where the triangles of each cell start in m_cellTriangles (plus the end)*/
+            std::vector<uint32_t> m_cellTriangles;     /*!< The triangles per cell*/
+    };
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef  VFVPOINTOCTREE_INC
+#define  VFVPOINTOCTREE_INC
+
+#include <cstdint>
+#include <vector>
+#include "VFVPointInMesh.h"
+
+/* \brief The maximum number of points of a VFVPointOctree leaf (unless VFV_POINT_OCTREE_MAX_DEPTH is reached) */
+#define VFV_POINT_OCTREE_LEAF_SIZE 64
+
+/* \brief The maximum depth of a VFVPointOctree. Bounds the subdivision of duplicated points */
+#define VFV_POINT_OCTREE_MAX_DEPTH 16
+
+/* \brief The number of representative points per VFVPointOctree node */
+#define VFV_POINT_OCTREE_REPRESENTATIVES 64
+
+namespace sereno
+{
+    /** \brief  Octree over a point cloud, used as a level of detail hierarchy.
+     *
+     * The points are reordered so that the points of every node are contiguous, its children covering its range octant after octant:
+     * the representatives of a node, evenly taken in its range, are spread over its children.
+     * Each node keeps the tight bounding box and the value range of its points.
+     * Selections reject the nodes outside the mesh bounding box, and accept or reject at once the nodes the mesh surface does not cross. */
+    class VFVPointOctree
+    {
+        public:
+            /** \brief  A node of the octree */
+            struct Node
+            {
+                float    min[3];         /*!< The minimum corner of the bounding box of its points*/
+                float    max[3];         /*!< The maximum corner of the bounding box of its points*/
+                float    valueMin = 0;   /*!< The minimum value of its points. 0 if the octree has no value*/
+                float    valueMax = 0;   /*!< The maximum value of its points. 0 if the octree has no value*/
+                uint32_t begin    = 0;   /*!< The first point of the node in getPointIDs()*/
+                uint32_t end      = 0;   /*!< The point after the last one of the node in getPointIDs()*/
+                uint32_t firstChild = 0; /*!< The index of its first child. Its children are contiguous. 0 if the node is a leaf*/
+                uint32_t nbChildren = 0; /*!< The number of children (the non empty octants)*/
+            };
+
+            /** \brief  Build the octree
+             * \param points the points to register. The octree does not keep a reference to them
+             * \param values if not NULL, one value per point, to compute the value range of each node */
+            void build(const VFVPointCloud& points, const std::vector<float>* values = NULL);
+
+            /** \brief  Get the nodes. The root is the first node (if any)
+             * \return   the nodes */
+            const std::vector<Node>& getNodes() const {return m_nodes;}
+
+            /** \brief  Get the point IDs, ordered by node
+             * \return   the point IDs. The node n covers the IDs [n.begin, n.end) */
+            const std::vector<uint32_t>& getPointIDs() const {return m_pointIDs;}
+
+            /** \brief  Get the representative points of a node
+             * \param nodeID the node
+             * \param nbPoints the maximum number of points to get
+             * \param ids[out] the point IDs, evenly taken in the node range, are appended here */
+            void getRepresentatives(uint32_t nodeID, size_t nbPoints, std::vector<uint32_t>& ids) const;
+
+            /** \brief  Get a subset of the points, e.g., for previews. The octree is refined breadth first as long as
+             * the representatives of the nodes reached fit in the budget: the subset is spread over the whole cloud
+             * \param maxPoints the maximum number of points to get
+             * \param ids[out] the point IDs, in ascending order */
+            void getSubset(size_t maxPoints, std::vector<uint32_t>& ids) const;
+
+            /** \brief  Split the octree in subtrees of at most maxPoints points (unless a leaf holds more), e.g., to spread a computation
+             * \param maxPoints the maximum number of points per subtree
+             * \param nodeIDs[out] the roots of the subtrees. Their ranges of getPointIDs() follow each other and cover every point */
+            void getSubtrees(size_t maxPoints, std::vector<uint32_t>& nodeIDs) const;
+
+            /** \brief  Test the points of a subtree against a closed mesh
+             * \param points the points the octree was built with
+             * \param mesh the closed mesh
+             * \param nodeID the root of the subtree
+             * \param inside[out] inside[i] is set to 1 if the point getPointIDs()[node.begin+i] is inside the mesh, 0 otherwise. node.end-node.begin values */
+            void classifyInside(const VFVPointCloud& points, const VFVPointInMesh& mesh, uint32_t nodeID, uint8_t* inside) const;
+
+            /** \brief  Get the points inside a closed mesh
+             * \param points the points the octree was built with
+             * \param mesh the closed mesh
+             * \param ids[out] the IDs of the points inside the mesh are appended here */
+            void queryInside(const VFVPointCloud& points, const VFVPointInMesh& mesh, std::vector<uint32_t>& ids) const;
+        private:
+            std::vector<Node>     m_nodes;    /*!< The nodes, the root first*/
+            std::vector<uint32_t> m_pointIDs; /*!< The point IDs, ordered by node*/
+    };
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef  VFVSELECTIONEVALUATOR_INC
+#define  VFVSELECTIONEVALUATOR_INC
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include "VFVPointInMesh.h"
+#include "VFVPointOctree.h"
+#include "VFVComputePool.h"
+#include "VFVMaskBricks.h"
+
+/* \brief The number of points per tile evaluated by a task */
+#define VFV_SELECTION_TILE_SIZE 4096
+
+namespace sereno
+{
+    /** \brief  How the result of a selection mesh is combined with the current mask */
+    enum VFVSelectionOp
+    {
+        VFV_SELECTION_OP_REPLACE      = 0, /*!< mask = inside*/
+        VFV_SELECTION_OP_UNION        = 1, /*!< mask = mask | inside*/
+        VFV_SELECTION_OP_INTERSECTION = 2, /*!< mask = mask & inside*/
+        VFV_SELECTION_OP_MINUS        = 3, /*!< mask = mask & !inside*/
+    };
+
+    /** \brief  Convert the boolean operation sent by the tablet (ADD_NEW_SELECTION_INPUT) to a VFVSelectionOp
+     * \param booleanOp the value received: 0 == union, 1 == intersection, 2 == minus, anything else == replace
+     * \return   the corresponding operation */
+    inline VFVSelectionOp getSelectionOp(int32_t booleanOp)
+    {
+        switch(booleanOp)
+        {
+            case 0:
+                return VFV_SELECTION_OP_UNION;
+            case 1:
+                return VFV_SELECTION_OP_INTERSECTION;
+            case 2:
+                return VFV_SELECTION_OP_MINUS;
+            default:
+                return VFV_SELECTION_OP_REPLACE;
+        }
+    }
+
+    /** \brief  Combine the result of a selection mesh with the current selection
+     * \param op the operation
+     * \param inside the point-in-mesh results (0 or 1 per point)
+     * \param nbPoints the number of points
+     * \param selected[in, out] the current selection (0 or 1 per point) */
+    inline void combineSelection(VFVSelectionOp op, const uint8_t* inside, size_t nbPoints, uint8_t* selected)
+    {
+        switch(op)
+        {
+            case VFV_SELECTION_OP_REPLACE:
+                for(size_t i = 0; i < nbPoints; i++)
+                    selected[i] = inside[i];
+                break;
+            case VFV_SELECTION_OP_UNION:
+                for(size_t i = 0; i < nbPoints; i++)
+                    selected[i] |= inside[i];
+                break;
+            case VFV_SELECTION_OP_INTERSECTION:
+                for(size_t i = 0; i < nbPoints; i++)
+                    selected[i] &= inside[i];
+                break;
+            case VFV_SELECTION_OP_MINUS:
+                for(size_t i = 0; i < nbPoints; i++)
+                    selected[i] &= !inside[i];
+                break;
+        }
+    }
+
+    /** \brief  One step of a boolean selection chain */
+    struct VFVSelectionStep
+    {
+        const VFVPointInMesh* mesh; /*!< The mesh to test the points against. Must stay alive during the evaluation*/
+        VFVSelectionOp        op;   /*!< How to combine its result with the mask*/
+    };
+
+    /** \brief  Evaluate a whole boolean selection chain on a point cloud.
+     * The points are split in tiles of VFV_SELECTION_TILE_SIZE points spread on the compute pool.
+     * Each tile goes through every step while it is in cache.
+     * The result is the same, byte for byte, as applying the steps one after the other on the whole cloud.
+     * \param points the points, expressed in the space of the meshes
+     * \param steps the steps to apply, in order
+     * \param mask[in, out] the mask, one byte (0 or 1) per point, as SubDataset::getVolumetricMask. Its initial value is the input of the first step
+     * \param pool the pool to run the tiles on. NULL == run them in the calling thread
+     * \param cancelled if not NULL and set to true, the remaining tiles are skipped and the mask is left partially evaluated
+     * \param bricks if not NULL, the bricks of the evaluated tiles are marked dirty
+     * \return   false if cancelled, true otherwise */
+    bool evaluateSelection(const VFVPointCloud& points, const std::vector<VFVSelectionStep>& steps, uint8_t* mask,
+                           VFVComputePool* pool = NULL, const std::atomic<bool>* cancelled = NULL, VFVMaskBricks* bricks = NULL);
+
+    /** \brief  Evaluate a whole boolean selection chain on a point cloud, using an octree over it.
+     * The octree is split in subtrees of about VFV_SELECTION_TILE_SIZE points spread on the compute pool.
+     * Each subtree goes through every step: the nodes the mesh surface does not cross are accepted or rejected at once (see VFVPointOctree::classifyInside).
+     * The result is the same, byte for byte, as applying the steps one after the other on the whole cloud.
+     * \param points the points, expressed in the space of the meshes
+     * \param octree the octree built over "points"
+     * \param steps the steps to apply, in order
+     * \param mask[in, out] the mask, one byte (0 or 1) per point. Its initial value is the input of the first step
+     * \param pool the pool to run the subtrees on. NULL == run them in the calling thread
+     * \param cancelled if not NULL and set to true, the remaining subtrees are skipped and the mask is left partially evaluated
+     * \param bricks if not NULL, the bricks of the points whose mask value changed are marked dirty
+     * \return   false if cancelled, true otherwise */
+    bool evaluateSelection(const VFVPointCloud& points, const VFVPointOctree& octree, const std::vector<VFVSelectionStep>& steps, uint8_t* mask,
+                           VFVComputePool* pool = NULL, const std::atomic<bool>* cancelled = NULL, VFVMaskBricks* bricks = NULL);
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef  VFVSELECTIONPREVIEW_INC
+#define  VFVSELECTIONPREVIEW_INC
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "VFVPointInMesh.h"
+#include "VFVPointOctree.h"
+#include "VFVSelectionEvaluator.h"
+
+namespace sereno
+{
+    /** \brief  Volumetric selection computed incrementally while the meshes are being extruded.
+     *
+     * Each extrusion step adds a closed slice (the prism between two consecutive lasso positions) to the current mesh.
+     * The octree over the points rejects the nodes outside the slice bounding box, and accepts or rejects at once the nodes the slice surface does not cross:
+     * only the points close to the slice surface are tested one by one.
+     * Every internal cap is shared by two consecutive slices: XOR-ing the slice parities gives exactly the parity of the whole extruded mesh.
+     *
+     * Slices are queued by pushSlice (cheap) and tested by processPending (heavy, e.g., in the compute pool).
+     * Every method is thread safe. */
+    class VFVSelectionPreview
+    {
+        public:
+            /** \brief  Constructor
+             * \param points the points to select, expressed in the space of the slices
+             * \param octree the octree built over "points"
+             * \param pointStride "points" are the points 0, pointStride, 2*pointStride, ... of the dataset (e.g., while the dataset is being loaded)
+             * \param nbDatasetPoints the number of points of the dataset. 0 == points->size() */
+            VFVSelectionPreview(std::shared_ptr<const VFVPointCloud> points, std::shared_ptr<const VFVPointOctree> octree,
+                                uint32_t pointStride = 1, size_t nbDatasetPoints = 0);
+
+            /** \brief  Remove every mesh. Slices being processed meanwhile are discarded */
+            void clear();
+
+            /** \brief  Start a new mesh. The next slices belong to it
+             * \param op how this mesh is combined with the previous ones */
+            void beginMesh(VFVSelectionOp op);
+
+            /** \brief  Queue a slice of the current mesh. Ignored if no mesh is started
+             * \param slice the closed slice */
+            void pushSlice(std::shared_ptr<const VFVPointInMesh> slice);
+
+            /** \brief  Test the queued slices. Calls are serialized: concurrent callers wait for each other */
+            void processPending();
+
+            /** \brief  Are there slices not processed yet?
+             * \return   true if yes, false otherwise */
+            bool hasPending() const;
+
+            /** \brief  Get the number of meshes started
+             * \return   the number of meshes */
+            size_t getNbMeshes() const;
+
+            /** \brief  Get the number of points
+             * \return   the number of points */
+            size_t getNbPoints() const {return m_points->size();}
+
+            /** \brief  Get the stride between two points of getPoints() in the dataset. The selection can be applied on the dataset mask only if it is 1
+             * \return   the stride */
+            uint32_t getPointStride() const {return m_pointStride;}
+
+            /** \brief  Get the number of points of the dataset
+             * \return   the number of points of the dataset */
+            size_t getNbDatasetPoints() const {return m_nbDatasetPoints;}
+
+            /** \brief  Get the points to select
+             * \return   the points */
+            std::shared_ptr<const VFVPointCloud> getPoints() const {return m_points;}
+
+            /** \brief  Get the octree built over the points
+             * \return   the octree */
+            std::shared_ptr<const VFVPointOctree> getOctree() const {return m_octree;}
+
+            /** \brief  Get a counter incremented each time the selection changes
+             * \return   the version of the selection */
+            uint64_t getVersion() const;
+
+            /** \brief  Apply the meshes processed so far on a mask
+             * \param mask[in, out] the mask, one byte (0 or 1) per point as SubDataset::getVolumetricMask, getNbPoints() bytes */
+            void applyOnMask(uint8_t* mask) const;
+
+            /** \brief  Get the selection of a subset of the points, starting from an empty mask
+             * \param subset the points to get, as indices in getPoints() (e.g., a subset spread by the octree, see VFVPointOctree::getSubset)
+             * \param preview[out] the bit-packed selection: bit i%8 of byte i/8 for the point subset[i] */
+            void getPreview(const std::vector<uint32_t>& subset, std::vector<uint8_t>& preview) const;
+        private:
+            /** \brief  A mesh and the points inside it */
+            struct Mesh
+            {
+                VFVSelectionOp       op;     /*!< How this mesh is combined with the previous ones*/
+                std::vector<uint8_t> inside; /*!< The bit-packed parities of the slices processed so far*/
+            };
+
+            /** \brief  A slice not processed yet */
+            struct PendingSlice
+            {
+                std::shared_ptr<const VFVPointInMesh> slice;      /*!< The slice*/
+                size_t                                meshID;     /*!< The mesh it belongs to*/
+                uint64_t                              generation; /*!< The value of m_generation when the slice was pushed*/
+            };
+
+            std::shared_ptr<const VFVPointCloud>    m_points;           /*!< The points*/
+            std::shared_ptr<const VFVPointOctree>   m_octree;           /*!< The octree over m_points*/
+            uint32_t                                m_pointStride;      /*!< The stride between two points of m_points in the dataset*/
+            size_t                                  m_nbDatasetPoints;  /*!< The number of points of the dataset*/
+            std::vector<Mesh>                       m_meshes;           /*!< The meshes started*/
+            std::deque<PendingSlice>                m_pending;          /*!< The slices not processed yet*/
+            uint64_t                                m_generation = 0;   /*!< Incremented by clear()*/
+            uint64_t                                m_version    = 0;   /*!< See getVersion()*/
+            mutable std::mutex                      m_mutex;            /*!< Protects the members above*/
+            std::mutex                              m_processMutex;     /*!< Serializes processPending()*/
+    };
+}
+
+#endif
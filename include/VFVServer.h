@@ -2,8 +2,12 @@
 #define  VFVSERVER_INC
 
 #include <map>
+#include <unordered_map>
+#include <tuple>
 #include <string>
 #include <stack>
+#include <shared_mutex>
+#include <functional>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
@@ -15,6 +19,11 @@
 #include "Datasets/Annotation/Annotation.h"
 #include "MetaData.h"
 #include "AnchorHeadsetData.h"
+#include "VFVMessageBuilder.h"
+#include "VFVTimingHistogram.h"
+#include "VFVTimedLock.h"
+#include "VFVComputePool.h"
+#include "VFVSelectionPreview.h"
 #include "config.h"
 
 #define VFVSERVER_ANNOTATION_NOT_FOUND(_annotID)\
@@ -80,9 +89,27 @@ namespace sereno
         VFV_SEND_REMOVE_SUBDATASET_GROUP                        = 38, /*!< Remove a SubDataset Group*/
         VFV_SEND_RENAME_SD                                      = 39, /*!< Rename a SubDataset*/
         VFV_SEND_DISPLAY_SHORT_MESSAGE                          = 40, /*!< Display on the device a short message*/
+        VFV_SEND_HEADSETS_STATUS_DELTA                          = 41, /*!< Send the headsets status which changed since the last message sent to this client*/
+        VFV_SEND_SELECTION_PROGRESS                             = 42, /*!< Send the progress of a volumetric selection being computed*/
+        VFV_SEND_SELECTION_PREVIEW                              = 43, /*!< Send the live preview of the volumetric selection being extruded*/
+        VFV_SEND_VOLUMETRIC_MASK_ENCODED                        = 44, /*!< Send SubDataset computed volumetric mask, compressed (see VFVMaskEncoding)*/
+        VFV_SEND_VOLUMETRIC_MASK_DELTA                          = 45, /*!< Send the bricks of a SubDataset volumetric mask which changed since a given sequence number*/
+        VFV_SEND_DATASET_LOADING_STATUS                         = 46, /*!< Send the loading progress of a dataset opened in the background*/
+        VFV_SEND_SELECTION_PREVIEW_POINTS                       = 47, /*!< Send the points the live previews of the volumetric selection are about*/
         VFV_SEND_END,
     };
 
+    /** \brief The fields an entry of VFV_SEND_HEADSETS_STATUS_DELTA can carry */
+    enum VFVHeadsetStatusField
+    {
+        HEADSET_STATUS_FIELD_COLOR              = (1 << 0), /*!< The headset color changed*/
+        HEADSET_STATUS_FIELD_CURRENT_ACTION     = (1 << 1), /*!< The headset current action changed*/
+        HEADSET_STATUS_FIELD_POSITION           = (1 << 2), /*!< The headset position changed*/
+        HEADSET_STATUS_FIELD_ROTATION           = (1 << 3), /*!< The headset rotation changed*/
+        HEADSET_STATUS_FIELD_POINTING           = (1 << 4), /*!< The headset pointing data changed*/
+        HEADSET_STATUS_FIELD_QUANTIZED_ROTATION = (1 << 5), /*!< The headset rotation is quantized ("smallest three" encoding)*/
+    };
+
     /** \brief  The types of existing dataset this server handles */
     enum DatasetType
     {
@@ -92,6 +119,108 @@ namespace sereno
         DATASET_TYPE_CLOUD_POINT  = 2,
     };
 
+    /** \brief  A registered dataset, as found from its ID or from its pointer (see VFVServer::registerDataset) */
+    struct VFVDatasetEntry
+    {
+        uint32_t         datasetID = 0;                      /*!< The dataset ID*/
+        DatasetType      type      = DATASET_TYPE_NOT_FOUND; /*!< The dataset type*/
+        Dataset*         dataset   = NULL;                   /*!< The dataset*/
+        DatasetMetaData* metaData  = NULL;                   /*!< Its meta data, stored in the map of its type (e.g., m_vtkDatasets)*/
+    };
+
+    /** \brief  The transformations received for a SubDataset and not yet applied.
+     * Only the latest rotation, position and scale are kept. */
+    struct VFVPendingTransform
+    {
+        bool                   hasRotate    = false; /*!< Is there a rotation to apply?*/
+        VFVClientSocket*       rotateClient = NULL;  /*!< The client which sent the rotation*/
+        VFVRotationInformation rotate;               /*!< The latest rotation*/
+
+        bool                   hasMove      = false; /*!< Is there a translation to apply?*/
+        VFVClientSocket*       moveClient   = NULL;  /*!< The client which sent the translation*/
+        VFVMoveInformation     move;                 /*!< The latest translation*/
+
+        bool                   hasScale     = false; /*!< Is there a scaling to apply?*/
+        VFVClientSocket*       scaleClient  = NULL;  /*!< The client which sent the scaling*/
+        VFVScaleInformation    scale;                /*!< The latest scaling*/
+    };
+
+    /** \brief  The status of a volumetric selection computed asynchronously */
+    enum VFVSelectionStatus
+    {
+        SELECTION_STATUS_RUNNING   = 0, /*!< The selection is being computed*/
+        SELECTION_STATUS_DONE      = 1, /*!< The selection is computed and its mask sent*/
+        SELECTION_STATUS_CANCELLED = 2, /*!< The selection was cancelled. The volumetric mask is reset*/
+        SELECTION_STATUS_FAILED    = 3, /*!< The selection could not be computed (e.g., the SubDataset was removed)*/
+    };
+
+    /** \brief  The status of a dataset loaded in the background */
+    enum VFVDatasetLoadingStatus
+    {
+        DATASET_LOADING_STATUS_LOADING = 0, /*!< The dataset is being loaded. Its first loaded timesteps are already usable*/
+        DATASET_LOADING_STATUS_DONE    = 1, /*!< Every timestep is loaded*/
+        DATASET_LOADING_STATUS_FAILED  = 2, /*!< The dataset could not be opened. Its ID will not be used*/
+    };
+
+    /** \brief  A dataset being loaded in the background (see VFVServer::addVTKDataset) */
+    struct VFVDatasetLoading
+    {
+        std::string name;                  /*!< The dataset name*/
+        uint32_t    nbLoadedTimesteps = 0; /*!< The number of timesteps already usable*/
+        uint32_t    nbTimesteps       = 0; /*!< The total number of timesteps. 0 == not known yet*/
+    };
+
+    class VFVServer;
+
+    /** \brief  A cloud point dataset whose values the library is loading (see VFVServer::loadCloudPointDataset).
+     * Shared by the thread publishing the dataset and the completion callback of CloudPointDataset::loadValues */
+    struct VFVCloudPointLoad
+    {
+        VFVServer*                      server     = NULL;  /*!< The server loading the dataset*/
+        uint32_t                        datasetID  = 0;     /*!< The dataset ID*/
+        std::string                     name;               /*!< The dataset name*/
+        CloudPointDataset*              cloudPoint = NULL;  /*!< The dataset*/
+        std::shared_ptr<VFVValuesMutex> valuesMutex;        /*!< The mutex of the dataset values, locked until they are loaded*/
+        bool                            hasPreview = false; /*!< Was the decimated preview read from the file before the library loaded it?*/
+        std::atomic<bool>               finished{false};    /*!< Has the loading been finished already?*/
+        std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now(); /*!< When the opening started*/
+    };
+
+    /** \brief  A volumetric selection computed by the compute thread.
+     * The meshes are a snapshot of the headset volumetric data when the selection was confirmed. */
+    struct VFVSelectionJob
+    {
+        uint32_t                          datasetID    = 0;       /*!< The dataset ID*/
+        uint32_t                          subDatasetID = 0;       /*!< The SubDataset ID*/
+        VFVClientSocket*                  headset      = NULL;    /*!< The headset which confirmed the selection. NULL if disconnected meanwhile*/
+        std::vector<VFVTangibleBrushMesh> meshes;                 /*!< The meshes to apply*/
+        void (*applyFunc)(const VolumetricMesh&, SubDataset*) = nullptr; /*!< The function applying a mesh on the SubDataset*/
+        std::shared_ptr<VFVSelectionPreview> preview;             /*!< The live preview of these meshes, reused instead of applyFunc. NULL if none*/
+        std::shared_ptr<const VFVPointCloud> points;              /*!< The positions of the cloud point dataset, tested against the meshes instead of applyFunc. NULL if not available*/
+        std::shared_ptr<const VFVPointOctree> pointOctree;        /*!< The octree over "points"*/
+        glm::vec3                         position;               /*!< The SubDataset position when the selection was confirmed*/
+        Quaternionf                       invRotation;            /*!< The inverse of the SubDataset global rotation when the selection was confirmed*/
+        glm::vec3                         scale;                  /*!< The SubDataset scale when the selection was confirmed*/
+        std::atomic<uint32_t>             nbMeshesDone{0};        /*!< The number of meshes already applied*/
+        std::atomic<bool>                 cancelled{false};       /*!< Has the selection been cancelled?*/
+    };
+
+    /** \brief  The live preview of the volumetric selection a headset is extruding.
+     * The slices are expressed in the SubDataset local space, using the SubDataset transformation as it was when the preview (re)started */
+    struct VFVSelectionPreviewState
+    {
+        uint32_t                             datasetID    = 0; /*!< The dataset ID*/
+        uint32_t                             subDatasetID = 0; /*!< The SubDataset ID*/
+        std::shared_ptr<VFVSelectionPreview> preview;          /*!< The selection computed so far*/
+        glm::vec3                            position;         /*!< The SubDataset position*/
+        Quaternionf                          invRotation;      /*!< The inverse of the SubDataset global rotation*/
+        glm::vec3                            scale;            /*!< The SubDataset scale*/
+        size_t                               nbSlices     = 0; /*!< The number of slices of the last mesh already pushed to the preview*/
+        uint64_t                             sentVersion  = 0; /*!< The preview version last sent*/
+        uint64_t                             sentTime     = 0; /*!< When the preview was last sent (monotonic, in microseconds)*/
+        std::vector<uint32_t>                subset;           /*!< The points sent with VFV_SEND_SELECTION_PREVIEW_POINTS, as indices in preview->getPoints(). Empty == not sent yet*/
+    };
+
     /** \brief  Clone a Transfer function based on its type
      * \param tf the transfer function to clone
      * \return the new Transfer Function allocated using new. The caller is responsible to destroy that object*/
@@ -130,6 +259,26 @@ namespace sereno
             /** \brief  Commit and send to all the clients all the devices' positions */
             void commitAllVRPNPositions();
 
+            /** \brief  Get the pool of outgoing message buffers. Useful to monitor its number of allocations
+             * \return   the outgoing buffer pool */
+            const VFVBufferPool& getBufferPool() const {return m_bufferPool;}
+
+            /** \brief  Get the time spent per update tick to build and send the headsets status messages
+             * \return   the timing histogram, in microseconds */
+            const VFVTimingHistogram& getHeadsetsStatusTiming() const {return m_headsetsStatusTiming;}
+
+            /** \brief  Get the waiting and holding times of m_datasetMutex, locked exclusively
+             * \return   the lock statistics, in microseconds */
+            const VFVLockStats& getDatasetLockStats() const {return m_datasetLockStats;}
+
+            /** \brief  Get the waiting and holding times of m_datasetMutex, locked in shared mode (read-only accesses)
+             * \return   the lock statistics, in microseconds */
+            const VFVLockStats& getDatasetSharedLockStats() const {return m_datasetSharedLockStats;}
+
+            /** \brief  Get the waiting and holding times of m_mapMutex (the client table), as locked by this class
+             * \return   the lock statistics, in microseconds */
+            const VFVLockStats& getMapLockStats() const {return m_mapLockStats;}
+
             /** \brief  The distinguishable color used in this sci vis application */
             static const uint32_t SCIVIS_DISTINGUISHABLE_COLORS[10];
         protected:
@@ -176,6 +325,12 @@ namespace sereno
              * \return The DatasetMetaData being updated. NULL if not found. In this case, sdMTPtr will not be modified*/
             DatasetMetaData* getMetaData(uint32_t datasetID, uint32_t sdID, SubDatasetMetaData** sdMTPtr = nullptr);
 
+            /* \brief  Get the mutex protecting the values of a dataset (see DatasetMetaData::valuesMutex). m_datasetMutex has to be locked (shared mode at least).
+             * Never wait for this mutex while holding m_datasetMutex or m_mapMutex: try_lock it and use deferUntilValuesFree if it is busy
+             * \param datasetID the dataset ID
+             * \return the mutex, or nullptr if the dataset is not found */
+            std::shared_ptr<VFVValuesMutex> getDatasetValuesMutex(uint32_t datasetID);
+
             /* \brief  Update the subdataset meta data last modification component via its ID
              * \param client the client modifying the metadata
              * \param datasetID the dataset ID
@@ -193,6 +348,13 @@ namespace sereno
 
             bool canClientModifySubDatasetGroup(VFVClientSocket* client, const SubDatasetGroupMetaData& sdg);
 
+            /* \brief  Register an opened dataset in m_datasets and in the lookup tables (m_datasetEntries and m_datasetEntriesByPointer). m_datasetMutex has to be locked
+             * \param datasetID the dataset ID
+             * \param dataset the dataset
+             * \param type the dataset type
+             * \param metaData the dataset meta data, already stored in the map of its type (e.g., m_vtkDatasets) */
+            void registerDataset(uint32_t datasetID, Dataset* dataset, DatasetType type, DatasetMetaData* metaData);
+
             /** \brief Get the dataset ID from an already registered dataset
              * \param dataset the dataset to evaluate
              * \return the dataset ID, or the maximum value of uint32_t (i.e., the unsigned value of -1=)*/
@@ -211,21 +373,39 @@ namespace sereno
              * \param identTablet the message sent */
             void loginHeadset(VFVClientSocket* client);
 
-            /* \brief Handle the rotation
+            /* \brief Handle the rotation. m_datasetMutex and m_mapMutex have to be locked
              * \param client the client asking for a rotation
              * \param rotate the rotation data. Not constant because the headset ID will change*/
             void rotateSubDataset(VFVClientSocket* client, VFVRotationInformation& rotate);
 
-            /* \brief Handle the translation
+            /* \brief Handle the translation. m_datasetMutex and m_mapMutex have to be locked
              * \param client the client asking for a rotation
              * \param position the position of the data. Not constant because the headset ID will change*/
             void translateSubDataset(VFVClientSocket* client, VFVMoveInformation& position);
 
-            /* \brief Handle the scaling
+            /* \brief Handle the scaling. m_datasetMutex and m_mapMutex have to be locked
              * \param client the client asking for a rotation
              * \param scale the scale values of the data. Not constant because the headset ID will change*/
             void scaleSubDataset(VFVClientSocket* client, VFVScaleInformation& scale);
 
+            /* \brief Register a rotation to apply at the next transformation flush, replacing any pending rotation of the same SubDataset
+             * \param client the client asking for a rotation
+             * \param rotate the rotation data*/
+            void queueRotateSubDataset(VFVClientSocket* client, const VFVRotationInformation& rotate);
+
+            /* \brief Register a translation to apply at the next transformation flush, replacing any pending translation of the same SubDataset
+             * \param client the client asking for a translation
+             * \param position the position of the data*/
+            void queueTranslateSubDataset(VFVClientSocket* client, const VFVMoveInformation& position);
+
+            /* \brief Register a scaling to apply at the next transformation flush, replacing any pending scaling of the same SubDataset
+             * \param client the client asking for a scaling
+             * \param scale the scale values of the data*/
+            void queueScaleSubDataset(VFVClientSocket* client, const VFVScaleInformation& scale);
+
+            /* \brief Apply and broadcast all the pending transformations (see queueRotateSubDataset, queueTranslateSubDataset and queueScaleSubDataset) */
+            void flushTransforms();
+
             /* \brief Handle the clipping
              * \param client the client asking for a set in the clipping*/
             void setSubDatasetClipping(VFVClientSocket* client, VFVSetSubDatasetClipping& clipping);
@@ -235,15 +415,70 @@ namespace sereno
              * \param tfSD the transfer function data. Not constant because the headset ID will change */
             void tfSubDataset(VFVClientSocket* client, VFVTransferFunctionSubDataset& tfSD);
 
-            /* \brief  Add a VTKDataset to the visualized datasets
+            /* \brief  Add a VTKDataset to the visualized datasets.
+             * The dataset ID is reserved and a DATASET_LOADING_STATUS_LOADING status is broadcast at once. The files are then parsed by loadVTKDataset
              * \param client the client adding the dataset
+             * \param dataset the dataset information to add
+             * \param async true to parse the files in the compute pool, false to parse them in the calling thread */
+            void addVTKDataset(VFVClientSocket* client, const VFVVTKDatasetInformation& dataset, bool async = true);
+
+            /* \brief  Parse the files of a VTKDataset and register it. The dataset is broadcast as soon as its first timestep is parsed,
+             * the other timesteps are then added one after the other, with a loading status broadcast per timestep.
+             * If another opening of the same files is being parsed, this one subscribes to it and returns at once (see subscribeVTKSource).
+             * No lock has to be held.
+             * \param datasetID the ID reserved for this dataset (see m_loadingDatasets)
              * \param dataset the dataset information to add */
-            void addVTKDataset(VFVClientSocket* client, const VFVVTKDatasetInformation& dataset);
+            void loadVTKDataset(uint32_t datasetID, const VFVVTKDatasetInformation& dataset);
+
+            /* \brief  Build a VTKDataset from the timesteps of a source as they are published: the first one creates the dataset (see createVTKDataset),
+             * the others are added to it, and the end of the parsing broadcasts the final loading status.
+             * No lock has to be held.
+             * \param datasetID the ID reserved for this dataset (see m_loadingDatasets)
+             * \param dataset the dataset information to add
+             * \param source the parsed files to follow */
+            void subscribeVTKSource(uint32_t datasetID, const VFVVTKDatasetInformation& dataset, std::shared_ptr<VFVVTKSource> source);
 
-            /* \brief  Add a CloudPointDataset to the visualized datasets
+            /* \brief  Create a VTKDataset from its first timestep, register it and send it to the clients. No lock has to be held
+             * \param datasetID the ID reserved for this dataset (see m_loadingDatasets)
+             * \param dataset the dataset information to add
+             * \param parser the first timestep
+             * \param source the parsed files the dataset comes from
+             * \param valuesMutex[out] the mutex of the dataset values
+             * \return   the dataset, or NULL if the fields asked are not valid */
+            VTKDataset* createVTKDataset(uint32_t datasetID, const VFVVTKDatasetInformation& dataset, std::shared_ptr<VTKParser> parser,
+                                         std::shared_ptr<VFVVTKSource> source, std::shared_ptr<VFVValuesMutex>* valuesMutex);
+
+            /* \brief  Get the parsed files of a VTK dataset from m_vtkSources, registering a new entry if none is alive.
+             * No lock has to be held.
+             * \param dataset the dataset information
+             * \param owner[out] true if the entry is new: the caller has to parse the files, publish them, and finish the entry
+             * \return   the entry */
+            std::shared_ptr<VFVVTKSource> getVTKSource(const VFVVTKDatasetInformation& dataset, bool& owner);
+
+            /* \brief  Remove an entry of m_vtkSources, e.g., if its files could not be parsed. No lock has to be held
+             * \param dataset the dataset information */
+            void removeVTKSource(const VFVVTKDatasetInformation& dataset);
+
+            /* \brief  Add a CloudPointDataset to the visualized datasets.
+             * As for addVTKDataset, the dataset ID is reserved and a DATASET_LOADING_STATUS_LOADING status is broadcast at once. The file is then read by loadCloudPointDataset
              * \param client the client adding the dataset
+             * \param dataset the dataset information to add
+             * \param async true to read the file in the compute pool, false to read it in the calling thread */
+            void addCloudPointDataset(VFVClientSocket* client, const VFVCloudPointDatasetInformation& dataset, bool async = true);
+
+            /* \brief  Read the file of a CloudPointDataset and register it. A decimated copy of its positions (at most SELECTION_PREVIEW_MAX_POINTS points, see VFVCloudPointReader)
+             * and its octree are read first, so that the live previews work as soon as the dataset is broadcast. The library then loads the values in its own thread:
+             * they stay locked (valuesMutex) until its completion callback calls finishCloudPointDataset. This function does not wait for it.
+             * No lock has to be held.
+             * \param datasetID the ID reserved for this dataset (see m_loadingDatasets)
              * \param dataset the dataset information to add */
-            void addCloudPointDataset(VFVClientSocket* client, const VFVCloudPointDatasetInformation& dataset);
+            void loadCloudPointDataset(uint32_t datasetID, const VFVCloudPointDatasetInformation& dataset);
+
+            /* \brief  Finish the loading of a CloudPointDataset once the library loaded its values: unlock them, then build the octree over every point the library loaded.
+             * It replaces the decimated copy before DATASET_LOADING_STATUS_DONE is broadcast. Only the first call does something.
+             * No lock has to be held.
+             * \param load the dataset being loaded */
+            void finishCloudPointDataset(std::shared_ptr<VFVCloudPointLoad> load);
 
             /* \brief  Add a SubDataset to a given one
              * \param client the client adding the dataset
@@ -252,9 +487,12 @@ namespace sereno
              * \return the SubDataset added. NULL if error*/
             SubDataset* onAddSubDataset(VFVClientSocket* client, const VFVAddSubDataset& dataset);
 
-            /* \brief  Remove a known subdataset
-             * \param dataset the dataset ID information */
-            void removeSubDataset(const VFVRemoveSubDataset& dataset);
+            /* \brief  Remove a known subdataset. m_datasetMutex and m_mapMutex have to be locked.
+             * If the dataset values are busy (e.g., a volumetric selection is computed), the selection of this SubDataset is cancelled
+             * and the removal is retried once the values are free (see deferUntilValuesFree)
+             * \param dataset the dataset ID information
+             * \param valuesLocked are the values of this dataset already locked by the caller? (e.g., removing the counter part of a subjective view) */
+            void removeSubDataset(const VFVRemoveSubDataset& dataset, bool valuesLocked = false);
 
             /* \brief  Add a Log data to the dataset objects
              * \param client the client adding the dataset
@@ -332,6 +570,30 @@ namespace sereno
              * \param confirmSelection confirmation message */
             void onConfirmSelection(VFVClientSocket* client, const VFVConfirmSelection& confirmSelection);
 
+            /* \brief  Apply a volumetric selection. Called by the compute thread: only the dataset values are locked during the computation
+             * \param job the selection to compute */
+            void runSelectionJob(std::shared_ptr<VFVSelectionJob> job);
+
+            /* \brief  Cancel a volumetric selection being computed
+             * \param client the client cancelling the selection. It has to be the headset which confirmed it, or its tablet
+             * \param cancel the selection to cancel */
+            void onCancelSelection(VFVClientSocket* client, const VFVCancelSelection& cancel);
+
+            /* \brief  Start or stop the live preview of the volumetric selection a headset is extruding. Only cloud point datasets are supported
+             * \param client the headset or its tablet
+             * \param request the SubDataset to preview, or -1 to stop */
+            void onSelectionPreview(VFVClientSocket* client, const VFVSelectionPreviewRequest& request);
+
+            /* \brief  Send again the whole volumetric mask of a SubDataset to a client
+             * \param client the client asking for it
+             * \param resync the SubDataset */
+            void onVolumetricMaskResync(VFVClientSocket* client, const VFVVolumetricMaskResync& resync);
+
+            /* \brief  Push to the live preview of a headset the slices extruded since the last call, and schedule their computation. m_mapMutex has to be locked
+             * \param headset the headset extruding the selection
+             * \param restart true to recompute the whole preview (e.g., the SubDataset transformation changed) */
+            void updateSelectionPreview(VFVClientSocket* headset, bool restart = false);
+
             /* \brief  CHange the map visibility of a given subdataset
              * \param client the client asking to change the map visibility
              * \param mapVisibility IDs and visibility parameters*/
@@ -362,6 +624,13 @@ namespace sereno
              * \param reset the reset data*/
             void onResetVolumetricSelection(VFVClientSocket* client, const VFVResetVolumetricSelection& reset);
 
+            /** \brief  Reset the volumetric selection of a SubDataset and tell the clients. m_datasetMutex and m_mapMutex have to be locked.
+             * If the dataset values are busy, the reset is retried once they are free (see deferUntilValuesFree)
+             * \param datasetID the dataset ID
+             * \param subDatasetID the SubDataset ID
+             * \param headsetID the ID of the headset asking for it. -1 == none */
+            void resetVolumetricSelection(uint32_t datasetID, uint32_t subDatasetID, int32_t headsetID);
+
             /** \brief Handle the "set the default color of drawable annotation position".
              * \param client The client asking to set the default color
              * \param color the new default color data message to use*/
@@ -408,11 +677,27 @@ namespace sereno
 
             void onSetVolumetricSelectionMethod(VFVClientSocket* client, const VFVVolumetricSelectionMethod& method);
 
+            /** \brief  Register the optional protocol features a client supports
+             * \param client the client announcing its features
+             * \param features the features supported */
+            void onClientFeatures(VFVClientSocket* client, const VFVClientFeatures& features);
+
             /** \brief Save into the current log file a VFVDataInformation message
              * \param client the client to which the message should have been sent to
              * \param data the data to save in a JSON format */
             void saveMessageSentToJSONLog(VFVClientSocket* client, const VFVDataInformation& data);
 
+            /** \brief Save into the current log file a VFVDataInformation message sent to several clients at once
+             * \param recipients the clients the message was sent to
+             * \param data the data to save in a JSON format */
+            void saveBroadcastMessageToJSONLog(const std::vector<VFVClientSocket*>& recipients, const VFVDataInformation& data);
+
+            /** \brief  Send an already serialized message to every connected client. The buffer is shared between all the recipients and the message is logged once
+             * \param msg the message to send
+             * \param data the information the message was generated from (for logging purpose)
+             * \param except a client that should not receive the message (e.g., the one the modification comes from). Can be NULL */
+            void broadcastMessage(const VFVMessageBuilder& msg, const VFVDataInformation& data, VFVClientSocket* except = NULL);
+
             /* \brief  Send an empty message
              * \param client the client to send the message
              * \param type the type of the message*/
@@ -467,16 +752,31 @@ namespace sereno
              * \param drawable the drawable meta data*/ 
             void sendAddAnnotationPositionToSD(VFVClientSocket* client, const SubDatasetMetaData& sdMT, const DrawableAnnotationPositionMetaData& drawable);
 
+            /* \brief  Serialize a rotation event
+             * \param rotate the rotate information
+             * \return the message to send */
+            VFVMessageBuilder generateRotateDatasetEvent(const VFVRotationInformation& rotate);
+
             /* \brief  Send a rotation event to client
              * \param client the client to send the information
              * \param rotate the rotate information*/
             void sendRotateDatasetEvent(VFVClientSocket* client, const VFVRotationInformation& rotate);
 
+            /* \brief  Serialize a scaling event
+             * \param scale the scale information
+             * \return the message to send */
+            VFVMessageBuilder generateScaleDatasetEvent(const VFVScaleInformation& scale);
+
             /* \brief  Send a scaling event to client
              * \param client the client to send the information
              * \param scale the scale information*/
             void sendScaleDatasetEvent(VFVClientSocket* client, const VFVScaleInformation& scale);
 
+            /* \brief  Serialize a position event
+             * \param position the position information
+             * \return the message to send */
+            VFVMessageBuilder generateMoveDatasetEvent(const VFVMoveInformation& position);
+
             /* \brief  Send a position event to client
              * \param client the client to send the information
              * \param position the position information */
@@ -498,6 +798,18 @@ namespace sereno
              * \param size the size of the data array*/
             void sendVolumetricMaskDataset(VFVClientSocket* client, std::shared_ptr<uint8_t> data, size_t size);
 
+            /** \brief  Send the volumetric mask of a SubDataset after it changed (or on login).
+             * The clients supporting CLIENT_FEATURE_VOLUMETRIC_MASK_DELTA receive the bricks changed since the last mask they received,
+             * or the whole mask if they missed a sequence number. The messages are cached in the SubDatasetMetaData until the mask changes:
+             * resending an unchanged mask (e.g., on login) costs only a comparison with the last mask sent.
+             * m_datasetMutex (shared mode at least) and m_mapMutex have to be locked, but not the dataset values.
+             * If the dataset values are busy, the update is sent once they are free (see deferUntilValuesFree)
+             * \param datasetID the dataset ID
+             * \param sd the SubDataset
+             * \param client the client to send the mask to. NULL == every client
+             * \param sendFull should the clients not supporting deltas receive the whole mask? (e.g., false if they were sent VFV_SEND_RESET_VOLUMETRIC_SELECTION) */
+            void sendVolumetricMaskUpdate(uint32_t datasetID, SubDataset* sd, VFVClientSocket* client, bool sendFull = true);
+
             /* \brief Send the current action message to a given client (will set what currently the headset is supposed to do)
              * \param client the client to send the information
              * \param currentActionID the action ID to send */
@@ -631,21 +943,63 @@ namespace sereno
              * \param msg the message (string) to display on the device for a short amount of time */
             void sendMessageToDisplay(VFVClientSocket* client, const std::string& msg);
 
+            /** \brief  Send the progress of a volumetric selection to the headset which confirmed it and to its tablet. m_mapMutex has to be locked
+             * \param job the selection being computed
+             * \param status the selection status */
+            void sendSelectionProgress(const VFVSelectionJob& job, VFVSelectionStatus status);
+
+            /** \brief  Send the loading status of a dataset opened in the background. m_mapMutex has to be locked
+             * \param client the client to send the status to
+             * \param datasetID the dataset ID
+             * \param loading the loading progress
+             * \param status the loading status */
+            void sendDatasetLoadingStatus(VFVClientSocket* client, uint32_t datasetID, const VFVDatasetLoading& loading, VFVDatasetLoadingStatus status);
+
+            /** \brief  Send the live preview of a volumetric selection to its headset. m_mapMutex has to be locked
+             * \param headset the headset extruding the selection
+             * \param state the preview to send */
+            void sendSelectionPreview(VFVClientSocket* headset, VFVSelectionPreviewState& state);
+
             /* \brief  Send the current status of the server on login
              * \param client the client to send the data */
             void onLoginSendCurrentStatus(VFVClientSocket* client);
 
             void onMessage(uint32_t bufID, VFVClientSocket* client, uint8_t* data, uint32_t size);
 
+            /** \brief  Generate the VFV_SEND_HEADSETS_STATUS message, which is the same for every recipient. m_mapMutex has to be locked
+             * \param headsetsStatus the current status of every headset, per headset ID
+             * \return the message to send */
+            VFVMessageBuilder generateHeadsetsStatus(const std::map<uint32_t, VFVHeadsetStatus>& headsetsStatus);
+
+            /** \brief  Fill a VFV_SEND_HEADSETS_STATUS_DELTA message with what changed since the last headsets status sent to "client".
+             * The status registered for "client" is then updated. m_mapMutex has to be locked
+             * \param client the client which will receive the message
+             * \param headsetsStatus the current status of every headset, per headset ID
+             * \param msg the message to fill
+             * \return true if something changed (the message has to be sent), false otherwise */
+            bool generateHeadsetsStatusDelta(VFVClientSocket* client, const std::map<uint32_t, VFVHeadsetStatus>& headsetsStatus, VFVMessageBuilder& msg);
+
             /** \brief Main thread running for updating other devices*/
             void updateThread();
 
-            /** \brief  Push a heavy computation function
-             * \param f the function to call in a separate thread */
-            void pushHeavy(const std::function<void(void)>& f);
+            /** \brief Thread flushing the pending transformations and the tasks waiting for dataset values at TRANSFORM_FLUSH_FRAMERATE*/
+            void transformThread();
+
+            /** \brief  Retry a task once the values of a dataset are free. Used by the functions holding m_datasetMutex and m_mapMutex,
+             * which must not wait for the dataset values (see the mutex order). The task is run by the transform thread with both locks held:
+             * it has to try_lock the values again (and call this function again if they are still busy)
+             * \param task the task to retry */
+            void deferUntilValuesFree(const std::function<void(void)>& task);
+
+            /** \brief  Run the tasks registered by deferUntilValuesFree. No lock has to be held */
+            void runDeferredValuesTasks();
 
-            /** \brief  The thread running for heavy computation */
-            void computeThread();
+            /** \brief  Push a heavy computation function. Block while the compute pool is full (unless called from the compute pool itself)
+             * Do not call this function while holding a lock a compute task may need.
+             * \param f the function to call in a separate thread
+             * \param priority the priority of this computation
+             * \return   true on success, false if the server is closing (f is then never called) */
+            bool pushHeavy(const std::function<void(void)>& f, VFVTaskPriority priority = TASK_PRIORITY_NORMAL);
 
             /*----------------------------------------------------------------------------*/
             /*---------------------------------ATTRIBUTES---------------------------------*/
@@ -653,15 +1007,40 @@ namespace sereno
 
             std::stack<uint32_t> m_availableHeadsetColors;       /*!< The available headset colors*/
 
+            VFVBufferPool m_bufferPool;                          /*!< The pool of outgoing message buffers*/
+            VFVTimingHistogram m_headsetsStatusTiming;           /*!< Time spent per update tick building and sending the headsets status*/
+
             std::map<uint32_t, VectorFieldMetaData>     m_binaryDatasets;     /*!< The binary datasets opened*/
             std::map<uint32_t, VTKMetaData>             m_vtkDatasets;        /*!< The vtk datasets opened*/
             std::map<uint32_t, CloudPointMetaData>      m_cloudPointDatasets; /*!< The cloud point datasets opened*/
             std::map<uint32_t, Dataset*>                m_datasets;           /*!< The datasets opened*/
+            std::unordered_map<uint32_t, VFVDatasetEntry>              m_datasetEntries;          /*!< The datasets opened per ID, for constant time lookups*/
+            std::unordered_map<const Dataset*, const VFVDatasetEntry*> m_datasetEntriesByPointer; /*!< The entries of m_datasetEntries per dataset*/
             std::map<uint32_t, LogMetaData>             m_logData;            /*!< The log data*/
             std::map<uint32_t, SubDatasetGroupMetaData> m_sdGroups;           /*!< The registered SubDatasetGroup opened*/
+            std::map<uint32_t, VFVDatasetLoading>       m_loadingDatasets;    /*!< The datasets being loaded in the background. Protected by m_datasetMutex*/
+
+            typedef std::tuple<std::string, std::vector<uint32_t>, std::vector<uint32_t>> VFVVTKSourceKey; /*!< (name, ptFields, cellFields)*/
+            std::map<VFVVTKSourceKey, std::weak_ptr<VFVVTKSource>> m_vtkSources; /*!< The parsed VTK files, alive while a dataset uses them or while being parsed*/
+            std::mutex m_vtkSourcesMutex;                        /*!< The mutex protecting m_vtkSources. Never held while locking another mutex*/
 
-            std::mutex   m_datasetMutex;                         /*!< The mutex handling the datasets*/
+            std::shared_mutex m_datasetMutex;                    /*!< The mutex handling the datasets. Locked in shared mode by the read-only accesses*/
+            VFVLockStats m_datasetLockStats;                     /*!< Waiting and holding times of m_datasetMutex, locked exclusively*/
+            VFVLockStats m_datasetSharedLockStats;               /*!< Waiting and holding times of m_datasetMutex, locked in shared mode*/
+            VFVLockStats m_mapLockStats;                         /*!< Waiting and holding times of m_mapMutex*/
             std::thread* m_updateThread  = NULL;                 /*!< The update thread*/
+            std::thread* m_transformThread = NULL;               /*!< The thread flushing the pending transformations*/
+
+            std::map<std::pair<uint32_t, uint32_t>, VFVPendingTransform> m_pendingTransforms; /*!< The pending transformations per (datasetID, subDatasetID)*/
+            std::map<std::pair<uint32_t, uint32_t>, VFVPendingTransform> m_flushedTransforms; /*!< The transformations flushTransforms took from m_pendingTransforms and is applying*/
+            std::mutex m_pendingTransformsMutex;                 /*!< The mutex protecting m_pendingTransforms and m_flushedTransforms*/
+            uint64_t   m_nbReceivedTransforms  = 0;              /*!< The number of transformations received*/
+            uint64_t   m_nbCoalescedTransforms = 0;              /*!< The number of transformations replaced by a newer one before being sent*/
+
+            std::map<std::pair<uint32_t, uint32_t>, std::shared_ptr<VFVSelectionJob>> m_selectionJobs; /*!< The volumetric selections being computed per (datasetID, subDatasetID)*/
+            std::mutex m_selectionJobsMutex;                     /*!< The mutex protecting m_selectionJobs*/
+
+            std::map<VFVClientSocket*, VFVSelectionPreviewState> m_selectionPreviews; /*!< The live selection previews per headset. Protected by m_mapMutex*/
 
             uint64_t m_currentDataset      = 0;                  /*!< The current Dataset id to push */
             uint64_t m_currentSubDataset   = 0;                  /*!< The current SubDatase id, useful to determine the next subdataset 3D position*/
@@ -672,18 +1051,19 @@ namespace sereno
             VFVClientSocket*  m_headsetAnchorClient = NULL;      /*!< The client sending the anchor. If the client is NULL, m_anchorData has to be redone*/
             AnchorHeadsetData m_anchorData;                      /*!< The anchor data registered*/
 
-            std::mutex                  m_computeMutex;           /*!< Mutex for m_computeThread*/
-            std::mutex                  m_computeTasksMutex;      /*!< Mutex for m_computeTasks*/
-            std::condition_variable     m_computeCond;            /*!< The condition variable associated to the compute thread*/
-            std::thread*                m_computeThread;          /*!< Thread handling heavy computation*/
-            std::queue<std::function<void(void)>> m_computeTasks; /*!< The tasks to run by the compute Thread*/
+            VFVComputePool m_computePool{COMPUTE_POOL_MAX_TASKS}; /*!< The threads handling heavy computation*/
+
 
 #ifdef VFV_LOG_DATA
             std::mutex    m_logMutex; /*!< The log file mutex */
             std::ofstream m_log;      /*!< The output log file recording every messages received and sent*/
 #endif
+            std::vector<std::function<void(void)>> m_deferredValuesTasks; /*!< The tasks waiting for dataset values (see deferUntilValuesFree)*/
+            std::mutex m_deferredValuesTasksMutex;               /*!< The mutex protecting m_deferredValuesTasks. Never held while locking another mutex*/
+
             //Mutex load order:
-            //datasetMutex, mapMutex, logMutex
+            //DatasetMetaData::valuesMutex, datasetMutex, mapMutex, pendingTransformsMutex, selectionJobsMutex, logMutex
+            //The values of a dataset may be held for long (e.g., volumetric selections): they are only try_locked while holding datasetMutex or mapMutex
     };
 }
 
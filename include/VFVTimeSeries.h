@@ -0,0 +1,23 @@
+#ifndef  VFVTIMESERIES_INC
+#define  VFVTIMESERIES_INC
+
+#include <string>
+#include <vector>
+
+namespace sereno
+{
+    /** \brief  Compare two timestep suffixes numerically ("2" < "10"), without converting them (they may not fit in an integer)
+     * \param a the first suffix, made of digits only
+     * \param b the second suffix, made of digits only
+     * \return   true if a comes before b, false otherwise */
+    bool compareTimestepSuffixes(const std::string& a, const std::string& b);
+
+    /** \brief  Find the other files of a time series: the files "<name>.<N>" next to the file "<name>", N being made of digits only
+     * \param directory the directory the name is relative to
+     * \param name the file of the first timestep, relative to directory
+     * \param suffixes[out] the suffixes N found, sorted by timestep (see compareTimestepSuffixes)
+     * \return   false if the directory could not be read, true otherwise */
+    bool getTimeSeriesSuffixes(const std::string& directory, const std::string& name, std::vector<std::string>& suffixes);
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef  VFVTIMEDLOCK_INC
+#define  VFVTIMEDLOCK_INC
+
+#include <chrono>
+#include <string>
+#include "VFVTimingHistogram.h"
+
+namespace sereno
+{
+    /** \brief  Statistics about a lock: how long threads waited to acquire it and how long they held it */
+    struct VFVLockStats
+    {
+        VFVTimingHistogram waitTime; /*!< Time spent waiting for the lock, in microseconds*/
+        VFVTimingHistogram holdTime; /*!< Time spent holding the lock, in microseconds*/
+
+        /** \brief  Summarize these statistics in a human readable way
+         * \return   the summary */
+        std::string toString() const
+        {
+            return "wait: " + waitTime.toString() + " | hold: " + holdTime.toString();
+        }
+    };
+
+    /** \brief  Scoped lock (as std::lock_guard) recording its waiting and holding times in a VFVLockStats object */
+    template<typename Mutex>
+    class VFVTimedLockGuard
+    {
+        public:
+            /** \brief  Constructor. Lock the mutex
+             * \param mutex the mutex to lock
+             * \param stats the statistics to update */
+            VFVTimedLockGuard(Mutex& mutex, VFVLockStats& stats) : m_mutex(mutex), m_stats(stats)
+            {
+                std::chrono::steady_clock::time_point beg = std::chrono::steady_clock::now();
+                m_mutex.lock();
+                m_lockTime = std::chrono::steady_clock::now();
+                m_stats.waitTime.addSample(std::chrono::duration_cast<std::chrono::microseconds>(m_lockTime - beg).count());
+            }
+
+            /** \brief  Destructor. Unlock the mutex */
+            ~VFVTimedLockGuard()
+            {
+                m_stats.holdTime.addSample(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_lockTime).count());
+                m_mutex.unlock();
+            }
+
+            /* Explicitly disallow copying. */
+            VFVTimedLockGuard(const VFVTimedLockGuard&)            = delete;
+            VFVTimedLockGuard& operator=(const VFVTimedLockGuard&) = delete;
+        private:
+            Mutex&                                m_mutex;    /*!< The mutex locked*/
+            VFVLockStats&                         m_stats;    /*!< The statistics to update*/
+            std::chrono::steady_clock::time_point m_lockTime; /*!< When the mutex was acquired*/
+    };
+
+    /** \brief  Scoped shared lock (as std::shared_lock) of a reader/writer mutex, recording its waiting and holding times in a VFVLockStats object */
+    template<typename Mutex>
+    class VFVTimedSharedLockGuard
+    {
+        public:
+            /** \brief  Constructor. Lock the mutex in shared mode
+             * \param mutex the mutex to lock
+             * \param stats the statistics to update */
+            VFVTimedSharedLockGuard(Mutex& mutex, VFVLockStats& stats) : m_mutex(mutex), m_stats(stats)
+            {
+                std::chrono::steady_clock::time_point beg = std::chrono::steady_clock::now();
+                m_mutex.lock_shared();
+                m_lockTime = std::chrono::steady_clock::now();
+                m_stats.waitTime.addSample(std::chrono::duration_cast<std::chrono::microseconds>(m_lockTime - beg).count());
+            }
+
+            /** \brief  Destructor. Unlock the mutex */
+            ~VFVTimedSharedLockGuard()
+            {
+                m_stats.holdTime.addSample(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_lockTime).count());
+                m_mutex.unlock_shared();
+            }
+
+            /* Explicitly disallow copying. */
+            VFVTimedSharedLockGuard(const VFVTimedSharedLockGuard&)            = delete;
+            VFVTimedSharedLockGuard& operator=(const VFVTimedSharedLockGuard&) = delete;
+        private:
+            Mutex&                                m_mutex;    /*!< The mutex locked*/
+            VFVLockStats&                         m_stats;    /*!< The statistics to update*/
+            std::chrono::steady_clock::time_point m_lockTime; /*!< When the mutex was acquired*/
+    };
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef  VFVTIMESTEPSOURCE_INC
+#define  VFVTIMESTEPSOURCE_INC
+
+#include <cstdint>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+namespace sereno
+{
+    /** \brief  The timesteps of a dataset being parsed, shared by every dataset opened from the same files.
+     * One opening (the owner) parses the files and publishes the timesteps in order.
+     * The openings subscribe to them instead of waiting: each subscriber is called once per timestep, in order, then once when the parsing ends.
+     * The calls of one subscriber never overlap. They run in the thread publishing the timestep (or finishing the source),
+     * or in the thread subscribing for the timesteps already published: callbacks must not wait for the publisher.
+     * No lock is held while calling a subscriber: it may use the source.
+     * \tparam T the type of a parsed timestep */
+    template <typename T>
+    class VFVTimestepSource
+    {
+        public:
+            /** \brief  Called for each timestep: the timestep index and the timestep */
+            typedef std::function<void(size_t, std::shared_ptr<T>)> TimestepCallback;
+
+            /** \brief  Called when the parsing ends. No timestep follows */
+            typedef std::function<void(void)> FinishCallback;
+
+            /** \brief  Publish the next timestep and call the subscribers
+             * \param timestep the parsed timestep */
+            void publish(std::shared_ptr<T> timestep)
+            {
+                std::list<std::shared_ptr<Subscriber>> subscribers;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_timesteps.push_back(timestep);
+                    subscribers = m_subscribers;
+                }
+                for(auto& sub : subscribers)
+                    deliver(sub);
+            }
+
+            /** \brief  Tell that no more timestep will be published, and call the subscribers */
+            void finish()
+            {
+                std::list<std::shared_ptr<Subscriber>> subscribers;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_finished = true;
+                    subscribers = m_subscribers;
+                }
+                for(auto& sub : subscribers)
+                    deliver(sub);
+            }
+
+            /** \brief  Subscribe to the timesteps. The timesteps already published are given at once, in the calling thread
+             * \param onTimestep the function called for each timestep, from the first one
+             * \param onFinish the function called when the parsing ends. The subscription ends with it */
+            void subscribe(const TimestepCallback& onTimestep, const FinishCallback& onFinish)
+            {
+                std::shared_ptr<Subscriber> sub = std::make_shared<Subscriber>();
+                sub->onTimestep = onTimestep;
+                sub->onFinish   = onFinish;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_subscribers.push_back(sub);
+                }
+                deliver(sub);
+            }
+
+            /** \brief  Set the number of timesteps expected
+             * \param nbTimesteps the number of timesteps. 0 == not known yet */
+            void setNbTimesteps(uint32_t nbTimesteps)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_nbTimesteps = nbTimesteps;
+            }
+
+            /** \brief  Get the number of timesteps expected
+             * \return   the number of timesteps. 0 == not known yet */
+            uint32_t getNbTimesteps()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_nbTimesteps;
+            }
+
+            /** \brief  Get the number of subscribers not finished yet
+             * \return   the number of subscribers */
+            size_t getNbSubscribers()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_subscribers.size();
+            }
+        private:
+            /** \brief  A subscriber and its progress */
+            struct Subscriber
+            {
+                TimestepCallback onTimestep;         /*!< See subscribe*/
+                FinishCallback   onFinish;           /*!< See subscribe*/
+                size_t           next       = 0;     /*!< The next timestep to give*/
+                bool             delivering = false; /*!< Is a thread calling this subscriber? It then gives the timesteps published meanwhile*/
+            };
+
+            /** \brief  Give a subscriber the timesteps it did not receive yet, and the end of the parsing, unless another thread is already doing it
+             * \param sub the subscriber */
+            void deliver(const std::shared_ptr<Subscriber>& sub)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if(sub->delivering)
+                    return;
+                sub->delivering = true;
+
+                while(sub->next < m_timesteps.size())
+                {
+                    size_t             i        = sub->next++;
+                    std::shared_ptr<T> timestep = m_timesteps[i];
+                    lock.unlock();
+                    sub->onTimestep(i, timestep);
+                    lock.lock();
+                }
+
+                if(m_finished)
+                {
+                    //Keep "delivering": the subscription is over
+                    m_subscribers.remove(sub);
+                    lock.unlock();
+                    sub->onFinish();
+                    return;
+                }
+                sub->delivering = false;
+            }
+
+            std::mutex                             m_mutex;               /*!< Protect the other members, and the progress of the subscribers*/
+            std::vector<std::shared_ptr<T>>        m_timesteps;           /*!< The published timesteps, in order*/
+            std::list<std::shared_ptr<Subscriber>> m_subscribers;         /*!< The subscribers not finished yet*/
+            uint32_t                               m_nbTimesteps = 0;     /*!< The number of timesteps expected. 0 == not known yet*/
+            bool                                   m_finished    = false; /*!< Is the parsing over (successfully or not)?*/
+    };
+}
+
+#endif
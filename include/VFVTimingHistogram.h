@@ -0,0 +1,96 @@
+#ifndef  VFVTIMINGHISTOGRAM_INC
+#define  VFVTIMINGHISTOGRAM_INC
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <sstream>
+
+/* \brief The number of buckets of a VFVTimingHistogram. The last bucket gathers every duration above 2^(N-2) microseconds */
+#define VFV_TIMING_HISTOGRAM_NB_BUCKETS 24
+
+namespace sereno
+{
+    /** \brief  Histogram of durations (in microseconds) using power-of-two buckets.
+     * Bucket 0 counts durations < 1us, bucket i counts durations in [2^(i-1), 2^i[ us.
+     * Samples can be added and read concurrently. */
+    class VFVTimingHistogram
+    {
+        public:
+            VFVTimingHistogram() {}
+
+            /* Explicitly disallow copying. */
+            VFVTimingHistogram(const VFVTimingHistogram&)            = delete;
+            VFVTimingHistogram& operator=(const VFVTimingHistogram&) = delete;
+
+            /** \brief  Add a duration
+             * \param us the duration in microseconds */
+            void addSample(uint64_t us)
+            {
+                uint32_t bucket = 0;
+                while(bucket < VFV_TIMING_HISTOGRAM_NB_BUCKETS-1 && ((uint64_t)1 << bucket) <= us)
+                    bucket++;
+
+                m_buckets[bucket]++;
+                m_nbSamples++;
+                m_sum += us;
+
+                uint64_t max = m_max;
+                while(us > max && !m_max.compare_exchange_weak(max, us));
+            }
+
+            /** \brief  Get the number of samples in a bucket
+             * \param bucket the bucket index (< VFV_TIMING_HISTOGRAM_NB_BUCKETS)
+             * \return   the number of samples */
+            uint64_t getBucket(uint32_t bucket) const {return m_buckets[bucket];}
+
+            /** \brief  Get the number of samples added
+             * \return   the number of samples */
+            uint64_t getNbSamples() const {return m_nbSamples;}
+
+            /** \brief  Get the longest duration added
+             * \return   the longest duration in microseconds */
+            uint64_t getMax() const {return m_max;}
+
+            /** \brief  Get the mean duration
+             * \return   the mean duration in microseconds, 0 if there is no sample */
+            double getMean() const
+            {
+                uint64_t nb = m_nbSamples;
+                return (nb == 0 ? 0.0 : (double)m_sum / nb);
+            }
+
+            /** \brief  Get an upper bound of the given percentile, i.e., the upper limit of the bucket containing it
+             * \param p the percentile, in [0, 1]
+             * \return   the upper bound in microseconds */
+            uint64_t getPercentile(double p) const
+            {
+                uint64_t nb    = m_nbSamples;
+                uint64_t count = 0;
+                for(uint32_t i = 0; i < VFV_TIMING_HISTOGRAM_NB_BUCKETS; i++)
+                {
+                    count += m_buckets[i];
+                    if(count > 0 && count >= p*nb)
+                        return (i == VFV_TIMING_HISTOGRAM_NB_BUCKETS-1 ? getMax() : ((uint64_t)1 << i));
+                }
+                return getMax();
+            }
+
+            /** \brief  Summarize this histogram in a human readable way
+             * \return   the summary (samples, mean, p50, p99, max) */
+            std::string toString() const
+            {
+                std::ostringstream oss;
+                oss << getNbSamples() << " samples, mean " << getMean() << "us, p50 <= " << getPercentile(0.5)
+                    << "us, p99 <= " << getPercentile(0.99) << "us, max " << getMax() << "us";
+                return oss.str();
+            }
+        private:
+            std::atomic<uint64_t> m_buckets[VFV_TIMING_HISTOGRAM_NB_BUCKETS] = {}; /*!< The number of samples per bucket*/
+            std::atomic<uint64_t> m_nbSamples{0};                                  /*!< The total number of samples*/
+            std::atomic<uint64_t> m_sum{0};                                        /*!< The sum of all the samples*/
+            std::atomic<uint64_t> m_max{0};                                        /*!< The longest sample*/
+    };
+}
+
+#endif
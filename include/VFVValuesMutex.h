@@ -0,0 +1,56 @@
+#ifndef  VFVVALUESMUTEX_INC
+#define  VFVVALUESMUTEX_INC
+
+#include <mutex>
+#include <condition_variable>
+
+namespace sereno
+{
+    /** \brief  The mutex protecting the values of a dataset (see DatasetMetaData::valuesMutex). Usable with std::unique_lock and std::lock_guard.
+     * Unlike std::mutex, any thread may unlock it: the values of a dataset being loaded are locked by the thread publishing the dataset,
+     * and unlocked by the completion callback of the loader */
+    class VFVValuesMutex
+    {
+        public:
+            VFVValuesMutex() {}
+
+            /* Explicitly disallow copying. */
+            VFVValuesMutex(const VFVValuesMutex&)            = delete;
+            VFVValuesMutex& operator=(const VFVValuesMutex&) = delete;
+
+            /** \brief  Lock the values, waiting for them to be unlocked */
+            void lock()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this]() {return !m_locked;});
+                m_locked = true;
+            }
+
+            /** \brief  Lock the values if they are not locked already
+             * \return   true if the caller now owns the values, false otherwise */
+            bool try_lock()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(m_locked)
+                    return false;
+                m_locked = true;
+                return true;
+            }
+
+            /** \brief  Unlock the values. Any thread may call it */
+            void unlock()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_locked = false;
+                }
+                m_cond.notify_one();
+            }
+        private:
+            std::mutex              m_mutex;          /*!< Protect m_locked*/
+            std::condition_variable m_cond;           /*!< Notified when the values are unlocked*/
+            bool                    m_locked = false; /*!< Are the values locked?*/
+    };
+}
+
+#endif
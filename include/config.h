@@ -7,7 +7,33 @@
 //#define LOG_UPDATE_HEAD
 #define UPDATE_VRPN_FRAMERATE     60
 #define UPDATE_THREAD_FRAMERATE   20
-#define MAX_NB_HEADSETS           10
 #define MAX_OWNER_TIME            1.e6
 
+//Maximum number of headsets connected at once. 0 == no limit. Beyond the number of distinguishable colors, headsets share colors
+#define MAX_NB_HEADSETS           0
+
+//Maximum size in bytes of a message received in the framed protocol. Larger frames disconnect the client
+#define MAX_FRAME_SIZE            (64u << 20)
+
+//Frequency at which the latest rotation/position/scale received for each SubDataset are applied and broadcast
+#define TRANSFORM_FLUSH_FRAMERATE 30
+
+//Number of threads running heavy computations. 0 == one per hardware thread, minus one
+#define COMPUTE_POOL_NB_THREADS   0
+
+//Maximum number of heavy computations waiting for a thread. Further requests wait for room
+#define COMPUTE_POOL_MAX_TASKS    64
+
+//Maximum frequency at which the live preview of a volumetric selection is sent to its headset
+#define SELECTION_PREVIEW_FRAMERATE  5
+
+//Maximum number of points (sub-sampled) sent per live preview of a volumetric selection
+#define SELECTION_PREVIEW_MAX_POINTS 65536
+
+//Size in bytes of the volumetric mask bricks. Only the bricks a selection changed are sent to the clients supporting it
+#define VOLUMETRIC_MASK_BRICK_SIZE   65536
+
+//Maximum number of VTK timesteps parsed at once when opening a time series. Bounds the memory of the parsed timesteps not added yet. 0 == no limit
+#define VTK_TIMESTEP_PARSING_MAX_THREADS 4
+
 #endif
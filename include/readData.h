@@ -0,0 +1,44 @@
+#ifndef  READDATA_INC
+#define  READDATA_INC
+
+#include <cstdint>
+
+namespace sereno
+{
+    /* \brief Read a big endian uint32_t value
+     * \param buf the buffer to read (at least 4 bytes)
+     * \return the value read */
+    inline uint32_t readUint32(const uint8_t* buf)
+    {
+        return ((uint32_t)buf[0] << 24) +
+               ((uint32_t)buf[1] << 16) +
+               ((uint32_t)buf[2] << 8)  +
+               buf[3];
+    }
+
+    /* \brief Read a big endian uint16_t value
+     * \param buf the buffer to read (at least 2 bytes)
+     * \return the value read */
+    inline uint16_t readUint16(const uint8_t* buf)
+    {
+        return (buf[0] << 8) + buf[1];
+    }
+
+    /* \brief Read a big endian float value
+     * \param buf the buffer to read (at least 4 bytes)
+     * \return the value read */
+    inline float readFloat(const uint8_t* buf)
+    {
+        union u
+        {
+            uint32_t i;
+            float    f;
+        };
+
+        u val;
+        val.i = readUint32(buf);
+        return val.f;
+    }
+}
+
+#endif
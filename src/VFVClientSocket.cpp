@@ -1,4 +1,7 @@
 #include "VFVClientSocket.h"
+#include "config.h"
+#include <cstring>
+#include <algorithm>
 
 namespace sereno
 {
@@ -15,32 +18,18 @@ namespace sereno
         size--;\
     }
 
-#define PUSH_FLOAT \
+#define PUSH_BUFFER(_buffer) \
     {\
-        while(!floatBuffer.isFull() && size) \
-        {\
-            floatBuffer.pushValue(message[0]);\
-            ADVANCE_BUFFER\
-        }\
+        uint32_t _nbPushed = (_buffer).pushValues(message, size);\
+        message += _nbPushed;\
+        size    -= _nbPushed;\
     }
 
-#define PUSH_UINT16 \
-    {\
-        while(!uint16Buffer.isFull() && size) \
-        {\
-            uint16Buffer.pushValue(message[0]);\
-            ADVANCE_BUFFER\
-        }\
-    }
+#define PUSH_FLOAT  PUSH_BUFFER(floatBuffer)
 
-#define PUSH_UINT32 \
-    {\
-        while(!uint32Buffer.isFull() && size) \
-        {\
-            uint32Buffer.pushValue(message[0]);\
-            ADVANCE_BUFFER\
-        }\
-    }
+#define PUSH_UINT16 PUSH_BUFFER(uint16Buffer)
+
+#define PUSH_UINT32 PUSH_BUFFER(uint32Buffer)
 
 #define PUSH_STRING \
     {\
@@ -56,22 +45,16 @@ namespace sereno
             }\
         }\
         if(stringBuffer.maxSize >= 0) \
-        {\
-            while(!stringBuffer.isFull() && size)\
-            {\
-                stringBuffer.pushValue(message[0]);\
-                ADVANCE_BUFFER\
-            }\
-        }\
+            PUSH_BUFFER(stringBuffer)\
     }
 
 #define FILL_BYTE_ARRAY\
     {\
-        while(arrBufferIdx < uint32Buffer.getValue() && size)\
-        {\
-            arrBuffer[arrBufferIdx++] = message[0];\
-            ADVANCE_BUFFER\
-        }\
+        uint32_t _nbCopied = std::min(uint32Buffer.getValue() - arrBufferIdx, size);\
+        memcpy(arrBuffer+arrBufferIdx, message, _nbCopied);\
+        arrBufferIdx += _nbCopied;\
+        message      += _nbCopied;\
+        size         -= _nbCopied;\
     }\
 
 #define PUSH_BYTE_ARRAY \
@@ -90,6 +73,20 @@ namespace sereno
             FILL_BYTE_ARRAY\
     }\
 
+/* \brief Fast path: decode a fixed-size value directly from the received message
+ * if it is not split between two received segments (i.e., nothing is pending in _buffer).
+ * Break the current switch on success. */
+#define FAST_PUSH(_buffer, _type, _readFunc) \
+    if((_buffer).buffer.empty() && size >= sizeof(_type)) \
+    {\
+        if(!info->pushValue(m_cursor, _readFunc(message)))\
+            ERROR_VALUE\
+        message += sizeof(_type);\
+        size    -= sizeof(_type);\
+        m_cursor++;\
+        break;\
+    }
+
 #define ERROR_VALUE \
     {\
         ERROR << "Could not push a value... type: " << m_curMsg.type << std::endl;\
@@ -102,6 +99,22 @@ namespace sereno
             m_tablet.~VFVTabletData();
         else if(isHeadset())
             m_headset.~VFVHeadsetData();
+
+        if(m_frameBuffer)
+            free(m_frameBuffer);
+    }
+
+    void VFVClientSocket::pushCurrentMessage()
+    {
+        if(m_curMsg.type == IDENT_HEADSET_FRAMED || m_curMsg.type == IDENT_TABLET_FRAMED)
+        {
+            INFO << "Client switching to the framed protocol" << std::endl;
+            m_framed = true;
+        }
+
+        m_messages.push(m_curMsg);
+        m_cursor = -1;
+        m_curMsg.type = NOTHING;
     }
 
     bool VFVClientSocket::feedMessage(uint8_t* message, uint32_t size)
@@ -113,6 +126,9 @@ namespace sereno
         if(size == 0)
             return true;
 
+        if(m_framed)
+            return feedFramedMessage(message, size);
+
         while(size != 0)
         {
             //Get the type of the message
@@ -128,9 +144,9 @@ namespace sereno
                         //Check if this is an "empty" message
                         if(0 >= m_curMsg.curMsg->getMaxCursor()+1)
                         {
-                            m_messages.push(m_curMsg);
-                            m_cursor = -1;
-                            m_curMsg.type = NOTHING;
+                            pushCurrentMessage();
+                            if(m_framed)
+                                return feedFramedMessage(message, size);
                         }
                         else
                             m_cursor = 0;
@@ -156,6 +172,21 @@ namespace sereno
                     {
                         case 's':
                         {
+                            //Fast path: the string size and its content are both available
+                            if(stringBuffer.maxSize < 0 && uint32Buffer.buffer.empty() && size >= sizeof(uint32_t))
+                            {
+                                int32_t strSize = readUint32(message);
+                                if(strSize >= 0 && size - sizeof(uint32_t) >= (uint32_t)strSize)
+                                {
+                                    if(!info->pushValue(m_cursor, std::string((const char*)message+sizeof(uint32_t), strSize)))
+                                        ERROR_VALUE
+                                    message += sizeof(uint32_t) + strSize;
+                                    size    -= sizeof(uint32_t) + strSize;
+                                    m_cursor++;
+                                    break;
+                                }
+                            }
+
                             PUSH_STRING
                             if(stringBuffer.isFull() && stringBuffer.maxSize >= 0)
                             {
@@ -170,6 +201,7 @@ namespace sereno
 
                         case 'I':
                         {
+                            FAST_PUSH(uint32Buffer, uint32_t, readUint32)
                             PUSH_UINT32
                             if(uint32Buffer.isFull())
                             {
@@ -183,6 +215,7 @@ namespace sereno
 
                         case 'i':
                         {
+                            FAST_PUSH(uint16Buffer, uint16_t, readUint16)
                             PUSH_UINT16
                             if(uint16Buffer.isFull())
                             {
@@ -196,6 +229,7 @@ namespace sereno
 
                         case 'f':
                         {
+                            FAST_PUSH(floatBuffer, float, readFloat)
                             PUSH_FLOAT
                             if(floatBuffer.isFull())
                             {
@@ -217,6 +251,23 @@ namespace sereno
                         }
                         case 'a':
                         {
+                            //Fast path: the whole array is available. Copy it at once
+                            if(!arrBuffer && uint32Buffer.buffer.empty() && size >= sizeof(uint32_t))
+                            {
+                                uint32_t arrSize = readUint32(message);
+                                if(size - sizeof(uint32_t) >= arrSize)
+                                {
+                                    uint8_t* arr = (uint8_t*)malloc(sizeof(uint8_t)*arrSize);
+                                    memcpy(arr, message+sizeof(uint32_t), arrSize);
+                                    message += sizeof(uint32_t) + arrSize;
+                                    size    -= sizeof(uint32_t) + arrSize;
+                                    if(!info->pushValue(m_cursor, std::shared_ptr<uint8_t>(arr, free), arrSize))
+                                        ERROR_VALUE
+                                    m_cursor++;
+                                    break;
+                                }
+                            }
+
                             PUSH_BYTE_ARRAY
                             if(arrBufferIdx == uint32Buffer.getValue() && arrBuffer)
                             {
@@ -239,9 +290,9 @@ namespace sereno
                     //Full message received
                     if(m_cursor >= info->getMaxCursor()+1)
                     {
-                        m_messages.push(m_curMsg);
-                        m_cursor = -1;
-                        m_curMsg.type = NOTHING;
+                        pushCurrentMessage();
+                        if(m_framed)
+                            return feedFramedMessage(message, size);
                     }
                 }
             }
@@ -249,6 +300,180 @@ namespace sereno
         return true;
     }
 
+    bool VFVClientSocket::feedFramedMessage(uint8_t* message, uint32_t size)
+    {
+        while(size != 0)
+        {
+            //Fast path: the whole frame is in the receive buffer. Keep a view over it
+            if(m_frameSizeBuffer.buffer.empty() && size >= sizeof(uint32_t))
+            {
+                uint32_t frameSize = readUint32(message);
+                if(frameSize > MAX_FRAME_SIZE)
+                {
+                    ERROR << "Framed message too large: " << frameSize << " bytes (maximum: " << MAX_FRAME_SIZE << ")" << std::endl;
+                    return false;
+                }
+                if(size - sizeof(uint32_t) >= frameSize)
+                {
+                    VFVFrame frame;
+                    frame.data = message + sizeof(uint32_t);
+                    frame.size = frameSize;
+                    m_frames.push(frame);
+
+                    message += sizeof(uint32_t) + frameSize;
+                    size    -= sizeof(uint32_t) + frameSize;
+                    continue;
+                }
+            }
+
+            //The frame spans several received segments. Copy it
+            if(!m_frameSizeBuffer.isFull())
+            {
+                PUSH_BUFFER(m_frameSizeBuffer)
+                if(!m_frameSizeBuffer.isFull())
+                    break;
+
+                if(m_frameSizeBuffer.getValue() > MAX_FRAME_SIZE)
+                {
+                    ERROR << "Framed message too large: " << m_frameSizeBuffer.getValue() << " bytes (maximum: " << MAX_FRAME_SIZE << ")" << std::endl;
+                    return false;
+                }
+
+                m_frameBufferIdx = 0;
+                m_frameBuffer    = (uint8_t*)malloc(sizeof(uint8_t)*m_frameSizeBuffer.getValue());
+            }
+
+            uint32_t frameSize = m_frameSizeBuffer.getValue();
+            uint32_t nbCopied  = std::min(frameSize - m_frameBufferIdx, size);
+            memcpy(m_frameBuffer+m_frameBufferIdx, message, nbCopied);
+            m_frameBufferIdx += nbCopied;
+            message          += nbCopied;
+            size             -= nbCopied;
+
+            if(m_frameBufferIdx == frameSize)
+            {
+                VFVFrame frame;
+                frame.owner = std::shared_ptr<uint8_t>(m_frameBuffer, free);
+                frame.data  = m_frameBuffer;
+                frame.size  = frameSize;
+                m_frames.push(frame);
+
+                m_frameBuffer = NULL;
+                m_frameSizeBuffer.clear();
+            }
+        }
+        return true;
+    }
+
+    void VFVClientSocket::detachFrames()
+    {
+        size_t nbFrames = m_frames.size();
+        for(size_t i = 0; i < nbFrames; i++)
+        {
+            VFVFrame frame = m_frames.front();
+            m_frames.pop();
+
+            if(!frame.owner)
+            {
+                uint8_t* data = (uint8_t*)malloc(sizeof(uint8_t)*frame.size);
+                memcpy(data, frame.data, frame.size);
+                frame.owner = std::shared_ptr<uint8_t>(data, free);
+                frame.data  = data;
+            }
+            m_frames.push(frame);
+        }
+    }
+
+    bool VFVClientSocket::decodeFrame(const VFVFrame& frame, VFVMessage* msg)
+    {
+        const uint8_t* data = frame.data;
+        uint32_t       size = frame.size;
+
+        if(size < sizeof(uint16_t) || !msg->setType((VFVMessageType)readUint16(data)))
+            return false;
+        data += sizeof(uint16_t);
+        size -= sizeof(uint16_t);
+
+        VFVDataInformation* info = msg->curMsg;
+        if(info == NULL)
+            return false;
+
+        //The maximum cursor may depend on the values already pushed (e.g., arrays)
+        for(int32_t cursor = 0; cursor <= info->getMaxCursor(); cursor++)
+        {
+            switch(info->getTypeAt(cursor))
+            {
+                case 's':
+                {
+                    if(size < sizeof(uint32_t))
+                        return false;
+                    uint32_t strSize = readUint32(data);
+                    if(size - sizeof(uint32_t) < strSize)
+                        return false;
+                    if(!info->pushValue(cursor, std::string((const char*)data+sizeof(uint32_t), strSize)))
+                        return false;
+                    data += sizeof(uint32_t) + strSize;
+                    size -= sizeof(uint32_t) + strSize;
+                    break;
+                }
+                case 'I':
+                {
+                    if(size < sizeof(uint32_t) || !info->pushValue(cursor, readUint32(data)))
+                        return false;
+                    data += sizeof(uint32_t);
+                    size -= sizeof(uint32_t);
+                    break;
+                }
+                case 'i':
+                {
+                    if(size < sizeof(uint16_t) || !info->pushValue(cursor, readUint16(data)))
+                        return false;
+                    data += sizeof(uint16_t);
+                    size -= sizeof(uint16_t);
+                    break;
+                }
+                case 'f':
+                {
+                    if(size < sizeof(float) || !info->pushValue(cursor, readFloat(data)))
+                        return false;
+                    data += sizeof(float);
+                    size -= sizeof(float);
+                    break;
+                }
+                case 'b':
+                {
+                    if(size < sizeof(uint8_t) || !info->pushValue(cursor, data[0]))
+                        return false;
+                    data++;
+                    size--;
+                    break;
+                }
+                case 'a':
+                {
+                    if(size < sizeof(uint32_t))
+                        return false;
+                    uint32_t arrSize = readUint32(data);
+                    if(size - sizeof(uint32_t) < arrSize)
+                        return false;
+                    uint8_t* arr = (uint8_t*)malloc(sizeof(uint8_t)*arrSize);
+                    memcpy(arr, data+sizeof(uint32_t), arrSize);
+                    if(!info->pushValue(cursor, std::shared_ptr<uint8_t>(arr, free), arrSize))
+                        return false;
+                    data += sizeof(uint32_t) + arrSize;
+                    size -= sizeof(uint32_t) + arrSize;
+                    break;
+                }
+                default:
+                    WARNING << "Buffer typed '" << info->getTypeAt(cursor) << "' not handled yet at cursor = " << cursor << std::endl;
+                    return false;
+            }
+        }
+
+        if(size != 0)
+            WARNING << "Ignoring " << size << " trailing bytes in a framed message of type " << msg->type << std::endl;
+        return true;
+    }
+
     bool VFVClientSocket::setAsTablet(const std::string& headsetIP, VFVHandedness handedness)
     {
         new (&m_tablet) VFVTabletData;
@@ -290,12 +515,24 @@ namespace sereno
 
     bool VFVClientSocket::pullMessage(VFVMessage* msg)
     {
-        if(m_messages.empty())
-            return false;
+        if(!m_messages.empty())
+        {
+            *msg = m_messages.front();
+            m_messages.pop();
+            return true;
+        }
 
-        *msg = m_messages.front();
-        m_messages.pop();
-        return true;
+        //Framed messages are decoded only when they are dispatched. Invalid frames are skipped
+        while(!m_frames.empty())
+        {
+            VFVFrame frame = m_frames.front();
+            m_frames.pop();
+
+            if(decodeFrame(frame, msg))
+                return true;
+            WARNING << "Skipping an invalid framed message of " << frame.size << " bytes" << std::endl;
+        }
+        return false;
     }
 
     void VFVHeadsetData::setCurrentAction(VFVHeadsetCurrentActionType action)
@@ -373,6 +610,40 @@ namespace sereno
         isClosed = true;
     }
 
+    size_t VFVTangibleBrushMesh::getNbSlices() const
+    {
+        if(lasso.size() < 3 || points.size() < 2*lasso.size())
+            return 0;
+        return points.size()/lasso.size() - 1;
+    }
+
+    void VFVTangibleBrushMesh::getSlice(size_t sliceID, VFVTangibleBrushSlice& slice) const
+    {
+        const uint32_t nbLasso = lasso.size();
+        slice.points.assign(points.begin() + sliceID*nbLasso, points.begin() + (sliceID+2)*nbLasso);
+        slice.triangles.clear();
+
+        //The sides, as generated by VFVVolumetricData::pushLocation
+        for(uint32_t i = 0; i < nbLasso; i++)
+        {
+            uint32_t next = (i+1)%nbLasso;
+            slice.triangles.push_back(nbLasso + i);
+            slice.triangles.push_back(nbLasso + next);
+            slice.triangles.push_back(i);
+
+            slice.triangles.push_back(nbLasso + next);
+            slice.triangles.push_back(next);
+            slice.triangles.push_back(i);
+        }
+
+        //The caps, as generated by close()
+        std::vector<int> tri = triangulate(lasso);
+        for(int i : tri)
+            slice.triangles.push_back(i);
+        for(int i : tri)
+            slice.triangles.push_back(i+nbLasso);
+    }
+
     void VFVVolumetricData::closeCurrentMesh()
     {
         if(meshes.size())
@@ -391,5 +662,7 @@ namespace sereno
 #undef PUSH_UINT32
 #undef PUSH_UINT16
 #undef PUSH_FLOAT
+#undef PUSH_BUFFER
+#undef FAST_PUSH
 #undef ADVANCE_BUFFER
 }
@@ -0,0 +1,106 @@
+#include "VFVCloudPointFile.h"
+#include <vector>
+#include <algorithm>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "readData.h"
+#include "utils.h"
+
+/* \brief The number of points read at once */
+#define VFV_CLOUD_POINT_FILE_CHUNK 65536
+
+namespace sereno
+{
+    VFVCloudPointReader::~VFVCloudPointReader()
+    {
+        if(m_fd >= 0)
+            close(m_fd);
+    }
+
+    bool VFVCloudPointReader::open(const std::string& path)
+    {
+        if(m_fd >= 0)
+            close(m_fd);
+        m_path     = path;
+        m_nbPoints = 0;
+        m_fd       = ::open(path.c_str(), O_RDONLY);
+        if(m_fd < 0)
+        {
+            ERROR << "Could not open the cloud point file " << path << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        uint8_t header[4];
+        if(fstat(m_fd, &st) != 0 || st.st_size < 4 || pread(m_fd, header, 4, 0) != 4)
+        {
+            ERROR << "The cloud point file " << path << " is too small" << std::endl;
+            return false;
+        }
+
+        //The header is written in the native byte order of the generator: check both against the file size (4 floats per point)
+        uint64_t fileSize   = st.st_size;
+        uint32_t nbPoints   = readUint32(header);
+        uint32_t nbPointsLE = header[0] + (header[1] << 8) + ((uint32_t)header[2] << 16) + ((uint32_t)header[3] << 24);
+        if(4 + 16*(uint64_t)nbPoints != fileSize)
+        {
+            if(4 + 16*(uint64_t)nbPointsLE != fileSize)
+            {
+                ERROR << "The cloud point file " << path << " has an unexpected size" << std::endl;
+                return false;
+            }
+            nbPoints = nbPointsLE;
+        }
+
+        m_nbPoints = nbPoints;
+        return true;
+    }
+
+    bool VFVCloudPointReader::readPositions(uint32_t begin, uint32_t end, float* xyz) const
+    {
+        std::vector<uint8_t> buffer(12*std::min(end-begin, (uint32_t)VFV_CLOUD_POINT_FILE_CHUNK));
+        for(uint32_t i = begin; i < end; i += VFV_CLOUD_POINT_FILE_CHUNK)
+        {
+            uint32_t nbRead = std::min(end-i, (uint32_t)VFV_CLOUD_POINT_FILE_CHUNK);
+            if(pread(m_fd, buffer.data(), 12*nbRead, 4 + 12*(uint64_t)i) != (ssize_t)(12*nbRead))
+            {
+                ERROR << "Could not read the cloud point file " << m_path << std::endl;
+                return false;
+            }
+
+            float* dst = xyz + 3*(size_t)(i-begin);
+            for(uint32_t j = 0; j < 3*nbRead; j++)
+                dst[j] = readFloat(&buffer[4*j]);
+        }
+        return true;
+    }
+
+    uint32_t VFVCloudPointReader::readDecimatedPositions(size_t maxPoints, VFVPointCloud& points) const
+    {
+        if(maxPoints == 0)
+            return 0;
+
+        uint32_t stride   = (uint32_t)std::max<size_t>(1, (m_nbPoints + maxPoints-1) / maxPoints);
+        uint32_t nbPoints = (m_nbPoints + stride-1) / stride;
+        float*   xyz      = points.allocate(nbPoints);
+
+        if(stride == 1)
+            return (readPositions(0, m_nbPoints, xyz) ? 1 : 0);
+
+        //The kept points are far apart: read them one by one instead of the whole file
+        for(uint32_t i = 0; i < nbPoints; i++)
+        {
+            uint8_t buffer[12];
+            if(pread(m_fd, buffer, 12, 4 + 12*(uint64_t)i*stride) != 12)
+            {
+                ERROR << "Could not read the cloud point file " << m_path << std::endl;
+                return 0;
+            }
+            xyz[3*i+0] = readFloat(buffer);
+            xyz[3*i+1] = readFloat(buffer+4);
+            xyz[3*i+2] = readFloat(buffer+8);
+        }
+        return stride;
+    }
+}
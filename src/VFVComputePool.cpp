@@ -0,0 +1,244 @@
+#include "VFVComputePool.h"
+#include <algorithm>
+
+namespace sereno
+{
+    /** \brief  The pool owning the calling thread, if any */
+    static thread_local const VFVComputePool* t_currentPool = NULL;
+
+    /** \brief  The ID of the calling thread in t_currentPool */
+    static thread_local int32_t t_currentWorkerID = -1;
+
+    VFVComputePool::VFVComputePool(uint32_t maxTasks) : m_maxTasks(maxTasks)
+    {}
+
+    VFVComputePool::~VFVComputePool()
+    {
+        close();
+        wait();
+    }
+
+    bool VFVComputePool::launch(uint32_t nbThreads)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_launched || m_closed)
+            return false;
+
+        if(nbThreads == 0)
+        {
+            uint32_t hwThreads = std::thread::hardware_concurrency();
+            nbThreads = (hwThreads > 1 ? hwThreads-1 : 1);
+        }
+
+        //Create every worker before starting them: they look at the deques of each other.
+        //A worker may already exist if tasks were pushed before the launch
+        while(m_workers.size() < nbThreads)
+            m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        for(uint32_t i = 0; i < m_workers.size(); i++)
+            m_workers[i]->thread = std::thread(&VFVComputePool::workerThread, this, i);
+
+        m_launched = true;
+        return true;
+    }
+
+    void VFVComputePool::close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_workCond.notify_all();
+        m_spaceCond.notify_all();
+    }
+
+    void VFVComputePool::wait()
+    {
+        for(auto& w : m_workers)
+            if(w->thread.joinable())
+                w->thread.join();
+    }
+
+    void VFVComputePool::parallelFor(size_t nbIterations, const std::function<void(size_t)>& f, VFVTaskPriority priority, size_t maxParallelism)
+    {
+        /** \brief  The state shared between the caller and the helpers. Helpers starting late may outlive the call */
+        struct ParallelFor
+        {
+            std::function<void(size_t)> f;
+            size_t                      nbIterations;
+            std::atomic<size_t>         next{0};
+            std::atomic<size_t>         nbDone{0};
+            std::mutex                  mutex;
+            std::condition_variable     cond;
+
+            /** \brief  Run iterations until there is no more to take */
+            void run()
+            {
+                size_t i;
+                while((i = next++) < nbIterations)
+                {
+                    f(i);
+                    if(++nbDone == nbIterations)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        cond.notify_all();
+                    }
+                }
+            }
+        };
+
+        if(nbIterations == 0)
+            return;
+
+        std::shared_ptr<ParallelFor> state = std::make_shared<ParallelFor>();
+        state->f            = f;
+        state->nbIterations = nbIterations;
+
+        size_t nbHelpers = std::min(nbIterations-1, (size_t)getNbThreads());
+        if(maxParallelism > 0)
+            nbHelpers = std::min(nbHelpers, maxParallelism-1);
+        for(size_t i = 0; i < nbHelpers; i++)
+            if(!tryPush([state]() {state->run();}, priority))
+                break;
+
+        state->run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cond.wait(lock, [&]() {return state->nbDone == nbIterations;});
+    }
+
+    bool VFVComputePool::push(const std::function<void(void)>& f, VFVTaskPriority priority)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if(getCurrentWorkerID() < 0 && m_nbQueued >= m_maxTasks && !m_closed)
+            {
+                m_nbBlockedPushes++;
+                m_spaceCond.wait(lock, [&]() {return m_closed || m_nbQueued < m_maxTasks;});
+            }
+
+            if(m_closed)
+                return false;
+            pushLocked(f, priority);
+        }
+        m_workCond.notify_one();
+        return true;
+    }
+
+    bool VFVComputePool::tryPush(const std::function<void(void)>& f, VFVTaskPriority priority)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_closed || m_nbQueued >= m_maxTasks)
+                return false;
+            pushLocked(f, priority);
+        }
+        m_workCond.notify_one();
+        return true;
+    }
+
+    void VFVComputePool::pushLocked(const std::function<void(void)>& f, VFVTaskPriority priority)
+    {
+        //Not launched yet: keep the task in the first deque, the first worker will take it
+        uint32_t workerID = 0;
+        if(m_launched)
+        {
+            int32_t currentID = getCurrentWorkerID();
+            if(currentID >= 0)
+                workerID = currentID;
+            else
+            {
+                workerID     = m_nextWorker;
+                m_nextWorker = (m_nextWorker+1) % m_workers.size();
+            }
+        }
+        else if(m_workers.size() == 0)
+            m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+        {
+            std::lock_guard<std::mutex> lockWorker(m_workers[workerID]->mutex);
+            m_workers[workerID]->tasks[priority].push_back(f);
+        }
+
+        m_nbQueued++;
+        if(m_nbQueued > m_maxQueued)
+            m_maxQueued = m_nbQueued;
+    }
+
+    bool VFVComputePool::pop(uint32_t workerID, std::function<void(void)>& f)
+    {
+        bool found = false;
+        for(uint32_t p = 0; p < TASK_PRIORITY_COUNT && !found; p++)
+        {
+            //Our own deque first, newest task first (its data is more likely in the cache)
+            {
+                Worker* w = m_workers[workerID].get();
+                std::lock_guard<std::mutex> lockWorker(w->mutex);
+                if(!w->tasks[p].empty())
+                {
+                    f = std::move(w->tasks[p].back());
+                    w->tasks[p].pop_back();
+                    found = true;
+                    break;
+                }
+            }
+
+            //Then steal the oldest task of the other workers
+            for(uint32_t i = 1; i < m_workers.size(); i++)
+            {
+                Worker* w = m_workers[(workerID+i) % m_workers.size()].get();
+                std::lock_guard<std::mutex> lockWorker(w->mutex);
+                if(!w->tasks[p].empty())
+                {
+                    f = std::move(w->tasks[p].front());
+                    w->tasks[p].pop_front();
+                    m_nbStolen++;
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if(found)
+        {
+            bool closed;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_nbQueued--;
+                closed = m_closed;
+            }
+            m_spaceCond.notify_one();
+
+            //The tasks not started before the pool closed are discarded
+            if(closed)
+                return false;
+        }
+        return found;
+    }
+
+    void VFVComputePool::workerThread(uint32_t workerID)
+    {
+        t_currentPool     = this;
+        t_currentWorkerID = workerID;
+
+        while(true)
+        {
+            std::function<void(void)> f;
+            if(pop(workerID, f))
+            {
+                f();
+                m_nbExecuted++;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCond.wait(lock, [&]() {return m_closed || m_nbQueued > 0;});
+            if(m_closed)
+                return;
+        }
+    }
+
+    int32_t VFVComputePool::getCurrentWorkerID() const
+    {
+        return (t_currentPool == this ? t_currentWorkerID : -1);
+    }
+}
@@ -0,0 +1,87 @@
+#include "VFVMaskBricks.h"
+#include <cstring>
+#include <algorithm>
+
+namespace sereno
+{
+    VFVMaskBricks::VFVMaskBricks(size_t brickSize) : m_brickSize(brickSize)
+    {}
+
+    VFVMaskBricks::VFVMaskBricks(const VFVMaskBricks& copy) : m_brickSize(copy.m_brickSize)
+    {
+        *this = copy;
+    }
+
+    VFVMaskBricks& VFVMaskBricks::operator=(const VFVMaskBricks& copy)
+    {
+        if(this == &copy)
+            return *this;
+
+        m_brickSize = copy.m_brickSize;
+        m_size      = copy.m_size;
+        m_nbBricks  = copy.m_nbBricks;
+        m_updated   = copy.m_updated;
+        m_hashes    = copy.m_hashes;
+        m_dirty.reset(new std::atomic<uint8_t>[m_nbBricks]);
+        for(size_t i = 0; i < m_nbBricks; i++)
+            m_dirty[i].store(copy.m_dirty[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_allDirty.store(copy.m_allDirty.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    uint64_t VFVMaskBricks::hashBrick(const uint8_t* data, size_t size)
+    {
+        //FNV-1a like, 8 bytes at a time. The masks are made of 0s and 1s: the multiplication spreads every bit over the hash
+        const uint64_t prime = 0x100000001b3ull;
+        uint64_t hash = 0xcbf29ce484222325ull ^ size;
+        size_t i = 0;
+        for(; i+sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, data+i, sizeof(uint64_t));
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 29;
+        }
+        for(; i < size; i++)
+            hash = (hash ^ data[i]) * prime;
+        return hash;
+    }
+
+    bool VFVMaskBricks::update(const uint8_t* mask, size_t size, std::vector<uint32_t>& changed)
+    {
+        bool allDirty = m_allDirty.exchange(false, std::memory_order_relaxed);
+
+        //New mask: hash everything, the caller sends it whole
+        if(!m_updated || size != m_size)
+        {
+            m_updated  = true;
+            m_size     = size;
+            m_nbBricks = (size + m_brickSize-1) / m_brickSize;
+            m_hashes.resize(m_nbBricks);
+            m_dirty.reset(new std::atomic<uint8_t>[m_nbBricks]);
+            for(size_t i = 0; i < m_nbBricks; i++)
+            {
+                size_t begin = i*m_brickSize;
+                m_hashes[i]  = hashBrick(mask+begin, std::min(m_brickSize, size-begin));
+                m_dirty[i].store(0, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        //Rehash the marked bricks only
+        for(size_t i = 0; i < m_nbBricks; i++)
+        {
+            if(!m_dirty[i].exchange(0, std::memory_order_relaxed) && !allDirty)
+                continue;
+
+            size_t   begin = i*m_brickSize;
+            uint64_t hash  = hashBrick(mask+begin, std::min(m_brickSize, size-begin));
+            if(hash != m_hashes[i])
+            {
+                m_hashes[i] = hash;
+                changed.push_back(i);
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,176 @@
+#include "VFVMaskEncoding.h"
+#include <cstring>
+
+namespace sereno
+{
+    /** \brief  Get the number of bytes of a LEB128 varint
+     * \param value the value to encode
+     * \return   the number of bytes */
+    static inline size_t getVarintSize(uint64_t value)
+    {
+        size_t size = 1;
+        while(value >= 0x80)
+        {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    /** \brief  Write a LEB128 varint
+     * \param out where to write
+     * \param value the value to encode
+     * \return   the number of bytes written */
+    static inline size_t writeVarint(uint8_t* out, uint64_t value)
+    {
+        size_t size = 0;
+        while(value >= 0x80)
+        {
+            out[size++] = (value & 0x7f) | 0x80;
+            value >>= 7;
+        }
+        out[size++] = value;
+        return size;
+    }
+
+    /** \brief  Is a mask made of 0s and 1s only?
+     * \param mask the mask
+     * \param size the mask size in bytes
+     * \return   true if yes, false otherwise */
+    static bool isBinaryMask(const uint8_t* mask, size_t size)
+    {
+        uint64_t bits = 0;
+        size_t   i    = 0;
+        for(uint64_t word; i+8 <= size; i += 8)
+        {
+            memcpy(&word, mask+i, 8);
+            bits |= word;
+        }
+        for(; i < size; i++)
+            bits |= mask[i];
+        return (bits & 0xfefefefefefefefeull) == 0;
+    }
+
+    VFVMaskEncoding chooseMaskEncoding(const uint8_t* mask, size_t size, size_t* encodedSize)
+    {
+        bool   binary        = true; //Only 0s and 1s?
+        bool   restChecked   = false; //Has the end of the mask been checked by isBinaryMask?
+        size_t bitsRLESize   = 0;
+        size_t bytesRLESize  = 0;
+        const size_t bitsSize = (size+7)/8;
+
+        //The first run of BITS_RLE is a run of 0s. It is empty if the mask starts with a 1
+        if(size > 0 && mask[0] != 0)
+            bitsRLESize++;
+
+        size_t i = 0;
+        while(i < size)
+        {
+            uint8_t value = mask[i];
+            size_t  start = i;
+
+            //Skip 8 equal bytes at once: selections are made of long runs
+            uint64_t pattern = 0x0101010101010101ull * value;
+            uint64_t word;
+            while(i+8 <= size && (memcpy(&word, mask+i, 8), word == pattern))
+                i += 8;
+            while(i < size && mask[i] == value)
+                i++;
+
+            if(value > 1)
+                binary = false;
+            bitsRLESize  += getVarintSize(i-start);
+            bytesRLESize += 1 + getVarintSize(i-start);
+
+            //Only RAW can win now: stop scanning
+            if(!binary && bytesRLESize >= size)
+                break;
+
+            //Scattered selections: neither RLE can beat BITS anymore. Only check that the rest is made of 0s and 1s, without counting its runs
+            if(binary && !restChecked && bitsRLESize >= bitsSize && bytesRLESize >= bitsSize)
+            {
+                restChecked = true;
+                if(isBinaryMask(mask+i, size-i))
+                    break;
+            }
+        }
+
+        VFVMaskEncoding encoding = VFV_MASK_ENCODING_RAW;
+        size_t          best     = size;
+        if(binary && bitsSize < best)
+        {
+            encoding = VFV_MASK_ENCODING_BITS;
+            best     = bitsSize;
+        }
+        if(binary && bitsRLESize < best)
+        {
+            encoding = VFV_MASK_ENCODING_BITS_RLE;
+            best     = bitsRLESize;
+        }
+        if(bytesRLESize < best)
+        {
+            encoding = VFV_MASK_ENCODING_BYTES_RLE;
+            best     = bytesRLESize;
+        }
+
+        if(encodedSize)
+            *encodedSize = best;
+        return encoding;
+    }
+
+    size_t encodeMask(const uint8_t* mask, size_t size, VFVMaskEncoding encoding, uint8_t* out)
+    {
+        size_t offset = 0;
+        switch(encoding)
+        {
+            case VFV_MASK_ENCODING_RAW:
+                memcpy(out, mask, size);
+                return size;
+
+            case VFV_MASK_ENCODING_BITS:
+            {
+                //Pack 8 bytes at once: for 0s and 1s, the multiplication gathers the byte k of the little endian word in the bit k of the top byte
+                size_t i = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                for(uint64_t word; i+8 <= size; i += 8)
+                {
+                    memcpy(&word, mask+i, 8);
+                    out[i/8] = (word * 0x0102040810204080ull) >> 56;
+                }
+#endif
+                if(i < size)
+                    memset(out+i/8, 0, (size-i+7)/8);
+                for(; i < size; i++)
+                    out[i/8] |= (mask[i] << (i%8));
+                return (size+7)/8;
+            }
+
+            case VFV_MASK_ENCODING_BITS_RLE:
+            case VFV_MASK_ENCODING_BYTES_RLE:
+            {
+                if(encoding == VFV_MASK_ENCODING_BITS_RLE && size > 0 && mask[0] != 0)
+                    offset += writeVarint(out+offset, 0);
+
+                size_t i = 0;
+                while(i < size)
+                {
+                    uint8_t value = mask[i];
+                    size_t  start = i;
+
+                    uint64_t pattern = 0x0101010101010101ull * value;
+                    uint64_t word;
+                    while(i+8 <= size && (memcpy(&word, mask+i, 8), word == pattern))
+                        i += 8;
+                    while(i < size && mask[i] == value)
+                        i++;
+
+                    if(encoding == VFV_MASK_ENCODING_BYTES_RLE)
+                        out[offset++] = value;
+                    offset += writeVarint(out+offset, i-start);
+                }
+                return offset;
+            }
+        }
+        return 0;
+    }
+}
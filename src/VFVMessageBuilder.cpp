@@ -0,0 +1,68 @@
+#include "VFVMessageBuilder.h"
+#include <algorithm>
+
+namespace sereno
+{
+    std::shared_ptr<uint8_t> VFVBufferPool::acquire(size_t size, size_t* capacity)
+    {
+        m_nbAcquisitions++;
+
+        //Search the size class
+        uint32_t sizeClass = VFV_BUFFER_POOL_MIN_CLASS;
+        while(sizeClass <= VFV_BUFFER_POOL_MAX_CLASS && ((size_t)1 << sizeClass) < size)
+            sizeClass++;
+
+        //Too big: do not pool it
+        if(sizeClass > VFV_BUFFER_POOL_MAX_CLASS)
+        {
+            m_nbAllocations++;
+            if(capacity)
+                *capacity = size;
+            return std::shared_ptr<uint8_t>((uint8_t*)malloc(size), free);
+        }
+
+        size_t classSize = (size_t)1 << sizeClass;
+        if(capacity)
+            *capacity = classSize;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            SizeClass& sc = m_classes[sizeClass - VFV_BUFFER_POOL_MIN_CLASS];
+
+            //Look for a buffer not referenced anymore by any message
+            for(size_t i = 0; i < sc.buffers.size(); i++)
+            {
+                size_t idx = (sc.next + i) % sc.buffers.size();
+                if(sc.buffers[idx].use_count() == 1)
+                {
+                    //Synchronize with the writes done by the previous owners
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    sc.next = (idx+1) % sc.buffers.size();
+                    return sc.buffers[idx];
+                }
+            }
+
+            m_nbAllocations++;
+            std::shared_ptr<uint8_t> buf((uint8_t*)malloc(classSize), free);
+            if(sc.buffers.size() < VFV_BUFFER_POOL_MAX_PER_CLASS)
+                sc.buffers.push_back(buf);
+            return buf;
+        }
+    }
+
+    uint8_t* VFVMessageBuilder::reserve(size_t size)
+    {
+        if(m_size + size > m_capacity)
+        {
+            size_t newCapacity = 0;
+            std::shared_ptr<uint8_t> newData = m_pool.acquire(std::max(2*m_capacity, m_size + size), &newCapacity);
+            memcpy(newData.get(), m_data.get(), m_size);
+            m_data     = newData;
+            m_capacity = newCapacity;
+        }
+
+        uint8_t* ptr = m_data.get() + m_size;
+        m_size += size;
+        return ptr;
+    }
+}
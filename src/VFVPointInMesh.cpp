@@ -0,0 +1,395 @@
+#include "VFVPointInMesh.h"
+#include <cmath>
+#include <cfloat>
+#include <utility>
+#include <algorithm>
+
+/* The edge functions must be exactly 0 at the triangle vertices: do not let the compiler fuse their multiply and subtract operations */
+#pragma GCC optimize ("fp-contract=off")
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VFV_POINT_IN_MESH_X86
+#include <immintrin.h>
+#endif
+
+namespace sereno
+{
+    VFVSIMDLevel getSIMDLevel()
+    {
+#ifdef VFV_POINT_IN_MESH_X86
+        static const VFVSIMDLevel level = []()
+        {
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx2"))
+                return VFV_SIMD_AVX2;
+            if(__builtin_cpu_supports("sse2"))
+                return VFV_SIMD_SSE2;
+            return VFV_SIMD_SCALAR;
+        }();
+        return level;
+#else
+        return VFV_SIMD_SCALAR;
+#endif
+    }
+
+    const char* getSIMDLevelName(VFVSIMDLevel level)
+    {
+        switch(level)
+        {
+            case VFV_SIMD_AVX2:
+                return "AVX2";
+            case VFV_SIMD_SSE2:
+                return "SSE2";
+            default:
+                return "scalar";
+        }
+    }
+
+    uint32_t VFVPointCloud::decimate(size_t maxPoints, VFVPointCloud& subset) const
+    {
+        uint32_t stride   = (uint32_t)std::max<size_t>(1, (m_nbPoints + maxPoints - 1)/maxPoints);
+        size_t   nbKept   = (m_nbPoints + stride - 1)/stride;
+        float*   dst      = subset.allocate(nbKept);
+        for(size_t i = 0; i < nbKept; i++)
+            std::copy(m_xyz+3*i*stride, m_xyz+3*i*stride+3, dst+3*i);
+        return stride;
+    }
+
+    void VFVPointInMesh::clear()
+    {
+        for(auto& c : m_coefs)
+            c.clear();
+        m_triangleBounds.clear();
+        m_surfaceBounds.clear();
+        m_cellStart.clear();
+        m_cellTriangles.clear();
+        m_gridRes = 0;
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            m_min[i] =  FLT_MAX;
+            m_max[i] = -FLT_MAX;
+        }
+    }
+
+    void VFVPointInMesh::addTriangle(const float a[3], const float b[3], const float c[3])
+    {
+        //Normal of the triangle. Ignore the triangles the ray (+X) cannot cross
+        float u[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+        float v[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+        float n[3] = {u[1]*v[2] - u[2]*v[1],
+                      u[2]*v[0] - u[0]*v[2],
+                      u[0]*v[1] - u[1]*v[0]};
+        float nNorm = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        if(nNorm == 0.0f)
+            return;
+
+        //Every triangle bounds the inside of the mesh, even the ones the ray cannot cross
+        for(uint32_t i = 0; i < 3; i++)
+            m_surfaceBounds.push_back(std::min(a[i], std::min(b[i], c[i])));
+        for(uint32_t i = 0; i < 3; i++)
+            m_surfaceBounds.push_back(std::max(a[i], std::max(b[i], c[i])));
+
+        if(std::abs(n[0]) <= 1.e-7f*nNorm)
+            return;
+
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            m_min[i] = std::min(m_min[i], std::min(a[i], std::min(b[i], c[i])));
+            m_max[i] = std::max(m_max[i], std::max(a[i], std::max(b[i], c[i])));
+        }
+        m_triangleBounds.push_back(std::min(a[1], std::min(b[1], c[1])));
+        m_triangleBounds.push_back(std::max(a[1], std::max(b[1], c[1])));
+        m_triangleBounds.push_back(std::min(a[2], std::min(b[2], c[2])));
+        m_triangleBounds.push_back(std::max(a[2], std::max(b[2], c[2])));
+
+        //Edge functions in the YZ plane, oriented so that they are positive inside the projected triangle (n[0] is its signed area).
+        //Compute them from the lexicographically smallest vertex so that the triangles sharing an edge get exactly the same (or opposite) values.
+        //e = DY*(pz-EZ) - DZ*(py-EY) is exactly 0 at both ends of the edge, so that rays passing through a vertex are handled consistently as well
+        const float  orientation = (n[0] > 0.0f ? 1.0f : -1.0f);
+        const float* vertices[3] = {a, b, c};
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            const float* p0 = vertices[i];
+            const float* p1 = vertices[(i+1)%3];
+            float sign = orientation;
+            if(p1[1] < p0[1] || (p1[1] == p0[1] && p1[2] < p0[2]))
+            {
+                std::swap(p0, p1);
+                sign = -sign;
+            }
+
+            float dy = sign*(p1[1]-p0[1]);
+            float dz = sign*(p1[2]-p0[2]);
+            m_coefs[COEF_EY0 +COEF_EDGE_STRIDE*i].push_back(p0[1]);
+            m_coefs[COEF_EZ0 +COEF_EDGE_STRIDE*i].push_back(p0[2]);
+            m_coefs[COEF_EDY0+COEF_EDGE_STRIDE*i].push_back(dy);
+            m_coefs[COEF_EDZ0+COEF_EDGE_STRIDE*i].push_back(dz);
+
+            //Points lying exactly on the edge: consider them inside if a tiny move along (-eps^2, eps) would bring them inside,
+            //i.e., depending on the edge direction when traversed with the interior on its left
+            m_coefs[COEF_ETL0+COEF_EDGE_STRIDE*i].push_back((dy > 0.0f || (dy == 0.0f && dz > 0.0f)) ? 1.0f : 0.0f);
+        }
+
+        //Plane equation solved for X
+        m_coefs[COEF_PX0].push_back((n[0]*a[0] + n[1]*a[1] + n[2]*a[2])/n[0]);
+        m_coefs[COEF_PXY].push_back(-n[1]/n[0]);
+        m_coefs[COEF_PXZ].push_back(-n[2]/n[0]);
+    }
+
+    void VFVPointInMesh::build()
+    {
+        const uint32_t nbTriangles = getNbTriangles();
+
+        //About sqrt(nbTriangles) cells per axis
+        m_gridRes = std::max(1u, std::min((uint32_t)VFV_POINT_IN_MESH_MAX_GRID_RES, (uint32_t)std::sqrt((float)nbTriangles)));
+        for(uint32_t i = 0; i < 2; i++)
+        {
+            float extent     = m_max[i+1] - m_min[i+1];
+            m_invCellSize[i] = (extent > 0.0f ? m_gridRes/extent : 0.0f);
+        }
+
+        //Register each triangle in every cell its projected bounding box overlaps (two passes: count, then fill)
+        m_cellStart.assign(m_gridRes*m_gridRes+1, 0);
+        m_cellTriangles.clear();
+        for(uint32_t pass = 0; pass < 2; pass++)
+        {
+            for(uint32_t t = 0; t < nbTriangles; t++)
+            {
+                const float* bounds = &m_triangleBounds[4*t];
+                uint32_t minY = getCell(bounds[0], 0), maxY = getCell(bounds[1], 0);
+                uint32_t minZ = getCell(bounds[2], 1), maxZ = getCell(bounds[3], 1);
+                for(uint32_t z = minZ; z <= maxZ; z++)
+                    for(uint32_t y = minY; y <= maxY; y++)
+                    {
+                        if(pass == 0)
+                            m_cellStart[z*m_gridRes+y+1]++;
+                        else
+                            m_cellTriangles[m_cellStart[z*m_gridRes+y]++] = t;
+                    }
+            }
+
+            if(pass == 0)
+            {
+                for(uint32_t c = 0; c < m_gridRes*m_gridRes; c++)
+                    m_cellStart[c+1] += m_cellStart[c];
+                m_cellTriangles.resize(m_cellStart.back());
+            }
+            else
+            {
+                //The fill pass moved each cell start to the start of the next cell
+                for(uint32_t c = m_gridRes*m_gridRes; c > 0; c--)
+                    m_cellStart[c] = m_cellStart[c-1];
+                m_cellStart[0] = 0;
+            }
+        }
+    }
+
+    uint32_t VFVPointInMesh::getCell(float v, uint32_t axis) const
+    {
+        //Same computation for the triangle bounds and the points:
+        //a point inside the bounding box of a triangle falls in a cell this triangle is registered in
+        float c = (v - m_min[axis+1])*m_invCellSize[axis];
+        if(!(c > 0.0f))
+            return 0;
+        return std::min((uint32_t)c, m_gridRes-1);
+    }
+
+    void VFVPointInMesh::compute(const VFVPointCloud& cloud, size_t begin, size_t end, uint8_t* inside, VFVSIMDLevel level) const
+    {
+        const size_t   nbPoints = end-begin;
+        const uint32_t nbCells  = m_gridRes*m_gridRes;
+
+        //Reject the points outside the mesh bounding box, and sort the other ones per cell
+        std::vector<uint32_t> pointCells(nbPoints);
+        std::vector<uint32_t> cellStart(nbCells+1, 0);
+        for(size_t i = 0; i < nbPoints; i++)
+        {
+            const float* p = cloud[begin+i];
+            const float  x = p[0], y = p[1], z = p[2];
+            inside[i] = 0;
+            if(nbCells == 0 || x < m_min[0] || x > m_max[0] || y < m_min[1] || y > m_max[1] || z < m_min[2] || z > m_max[2])
+            {
+                pointCells[i] = nbCells;
+                continue;
+            }
+
+            pointCells[i] = getCell(z, 1)*m_gridRes + getCell(y, 0);
+            cellStart[pointCells[i]+1]++;
+        }
+
+        if(nbCells == 0)
+            return;
+        for(uint32_t c = 0; c < nbCells; c++)
+            cellStart[c+1] += cellStart[c];
+
+        const size_t nbCandidates = cellStart[nbCells];
+        if(nbCandidates == 0)
+            return;
+
+        std::vector<float>    xs(nbCandidates), ys(nbCandidates), zs(nbCandidates);
+        std::vector<uint32_t> ids(nbCandidates);
+        std::vector<uint8_t>  candidatesInside(nbCandidates);
+        {
+            std::vector<uint32_t> cellOffset(cellStart.begin(), cellStart.end()-1);
+            for(size_t i = 0; i < nbPoints; i++)
+            {
+                if(pointCells[i] == nbCells)
+                    continue;
+                uint32_t o = cellOffset[pointCells[i]]++;
+                const float* p = cloud[begin+i];
+                xs[o]  = p[0];
+                ys[o]  = p[1];
+                zs[o]  = p[2];
+                ids[o] = i;
+            }
+        }
+
+        //Test the points of each cell against the triangles registered in it only
+        for(uint32_t c = 0; c < nbCells; c++)
+        {
+            const size_t    o           = cellStart[c];
+            const size_t    nbCellPts   = cellStart[c+1] - o;
+            const uint32_t* triangles   = m_cellTriangles.data() + m_cellStart[c];
+            const size_t    nbTriangles = m_cellStart[c+1] - m_cellStart[c];
+            if(nbCellPts == 0 || nbTriangles == 0)
+                continue;
+
+            switch(level)
+            {
+#ifdef VFV_POINT_IN_MESH_X86
+                case VFV_SIMD_AVX2:
+                    computeAVX2(&xs[o], &ys[o], &zs[o], nbCellPts, triangles, nbTriangles, &candidatesInside[o]);
+                    break;
+                case VFV_SIMD_SSE2:
+                    computeSSE2(&xs[o], &ys[o], &zs[o], nbCellPts, triangles, nbTriangles, &candidatesInside[o]);
+                    break;
+#endif
+                default:
+                    computeScalar(&xs[o], &ys[o], &zs[o], nbCellPts, triangles, nbTriangles, &candidatesInside[o]);
+                    break;
+            }
+
+            for(size_t i = o; i < o+nbCellPts; i++)
+                inside[ids[i]] = candidatesInside[i];
+        }
+    }
+
+    void VFVPointInMesh::computeScalar(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                                       const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const
+    {
+        for(size_t i = 0; i < nbPoints; i++)
+        {
+            const float px = xs[i];
+            const float py = ys[i];
+            const float pz = zs[i];
+            uint8_t parity = 0;
+
+            for(size_t k = 0; k < nbTriangles; k++)
+            {
+                const uint32_t t = triangles[k];
+                bool in = true;
+                for(uint32_t edge = 0; edge < 3; edge++)
+                {
+                    const uint32_t o = COEF_EDGE_STRIDE*edge;
+                    float e = m_coefs[COEF_EDY0+o][t]*(pz - m_coefs[COEF_EZ0+o][t]) - m_coefs[COEF_EDZ0+o][t]*(py - m_coefs[COEF_EY0+o][t]);
+                    in = in && (e > 0.0f || (e == 0.0f && m_coefs[COEF_ETL0+o][t] != 0.0f));
+                }
+                float x = m_coefs[COEF_PX0][t] + m_coefs[COEF_PXY][t]*py + m_coefs[COEF_PXZ][t]*pz;
+                parity ^= (in && x > px);
+            }
+            inside[i] = parity;
+        }
+    }
+
+#ifdef VFV_POINT_IN_MESH_X86
+    void VFVPointInMesh::computeSSE2(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                                     const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const
+    {
+        const __m128 zero = _mm_setzero_ps();
+        size_t i = 0;
+        for(; i+4 <= nbPoints; i+=4)
+        {
+            const __m128 px = _mm_loadu_ps(xs+i);
+            const __m128 py = _mm_loadu_ps(ys+i);
+            const __m128 pz = _mm_loadu_ps(zs+i);
+            __m128 parity = _mm_setzero_ps();
+
+            for(size_t k = 0; k < nbTriangles; k++)
+            {
+                const uint32_t t = triangles[k];
+#define VFV_EDGE_SSE2(_i) _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(m_coefs[COEF_EDY##_i][t]), _mm_sub_ps(pz, _mm_set1_ps(m_coefs[COEF_EZ##_i][t]))), \
+                                     _mm_mul_ps(_mm_set1_ps(m_coefs[COEF_EDZ##_i][t]), _mm_sub_ps(py, _mm_set1_ps(m_coefs[COEF_EY##_i][t]))))
+#define VFV_INSIDE_SSE2(_e, _i) _mm_or_ps(_mm_cmpgt_ps(_e, zero), \
+                                          _mm_and_ps(_mm_cmpeq_ps(_e, zero), _mm_cmpneq_ps(_mm_set1_ps(m_coefs[COEF_ETL##_i][t]), zero)))
+                __m128 e0  = VFV_EDGE_SSE2(0);
+                __m128 e1  = VFV_EDGE_SSE2(1);
+                __m128 e2  = VFV_EDGE_SSE2(2);
+                __m128 in  = _mm_and_ps(_mm_and_ps(VFV_INSIDE_SSE2(e0, 0), VFV_INSIDE_SSE2(e1, 1)), VFV_INSIDE_SSE2(e2, 2));
+#undef VFV_INSIDE_SSE2
+#undef VFV_EDGE_SSE2
+                __m128 x   = _mm_add_ps(_mm_add_ps(_mm_set1_ps(m_coefs[COEF_PX0][t]), _mm_mul_ps(_mm_set1_ps(m_coefs[COEF_PXY][t]), py)),
+                                        _mm_mul_ps(_mm_set1_ps(m_coefs[COEF_PXZ][t]), pz));
+                parity = _mm_xor_ps(parity, _mm_and_ps(in, _mm_cmpgt_ps(x, px)));
+            }
+
+            int bits = _mm_movemask_ps(parity);
+            for(uint32_t j = 0; j < 4; j++)
+                inside[i+j] = (bits >> j) & 1;
+        }
+
+        computeScalar(xs+i, ys+i, zs+i, nbPoints-i, triangles, nbTriangles, inside+i);
+    }
+
+    __attribute__((target("avx2")))
+    void VFVPointInMesh::computeAVX2(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                                     const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = 0;
+        for(; i+8 <= nbPoints; i+=8)
+        {
+            const __m256 px = _mm256_loadu_ps(xs+i);
+            const __m256 py = _mm256_loadu_ps(ys+i);
+            const __m256 pz = _mm256_loadu_ps(zs+i);
+            __m256 parity = _mm256_setzero_ps();
+
+            for(size_t k = 0; k < nbTriangles; k++)
+            {
+                const uint32_t t = triangles[k];
+#define VFV_EDGE_AVX2(_i) _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(m_coefs[COEF_EDY##_i][t]), _mm256_sub_ps(pz, _mm256_set1_ps(m_coefs[COEF_EZ##_i][t]))), \
+                                        _mm256_mul_ps(_mm256_set1_ps(m_coefs[COEF_EDZ##_i][t]), _mm256_sub_ps(py, _mm256_set1_ps(m_coefs[COEF_EY##_i][t]))))
+#define VFV_INSIDE_AVX2(_e, _i) _mm256_or_ps(_mm256_cmp_ps(_e, zero, _CMP_GT_OQ), \
+                                             _mm256_and_ps(_mm256_cmp_ps(_e, zero, _CMP_EQ_OQ), \
+                                                           _mm256_cmp_ps(_mm256_set1_ps(m_coefs[COEF_ETL##_i][t]), zero, _CMP_NEQ_OQ)))
+                __m256 e0  = VFV_EDGE_AVX2(0);
+                __m256 e1  = VFV_EDGE_AVX2(1);
+                __m256 e2  = VFV_EDGE_AVX2(2);
+                __m256 in  = _mm256_and_ps(_mm256_and_ps(VFV_INSIDE_AVX2(e0, 0), VFV_INSIDE_AVX2(e1, 1)), VFV_INSIDE_AVX2(e2, 2));
+#undef VFV_INSIDE_AVX2
+#undef VFV_EDGE_AVX2
+                __m256 x   = _mm256_add_ps(_mm256_add_ps(_mm256_set1_ps(m_coefs[COEF_PX0][t]), _mm256_mul_ps(_mm256_set1_ps(m_coefs[COEF_PXY][t]), py)),
+                                           _mm256_mul_ps(_mm256_set1_ps(m_coefs[COEF_PXZ][t]), pz));
+                parity = _mm256_xor_ps(parity, _mm256_and_ps(in, _mm256_cmp_ps(x, px, _CMP_GT_OQ)));
+            }
+
+            int bits = _mm256_movemask_ps(parity);
+            for(uint32_t j = 0; j < 8; j++)
+                inside[i+j] = (bits >> j) & 1;
+        }
+
+        computeScalar(xs+i, ys+i, zs+i, nbPoints-i, triangles, nbTriangles, inside+i);
+    }
+#else
+    void VFVPointInMesh::computeSSE2(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                                     const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const
+    {
+        computeScalar(xs, ys, zs, nbPoints, triangles, nbTriangles, inside);
+    }
+
+    void VFVPointInMesh::computeAVX2(const float* xs, const float* ys, const float* zs, size_t nbPoints,
+                                     const uint32_t* triangles, size_t nbTriangles, uint8_t* inside) const
+    {
+        computeScalar(xs, ys, zs, nbPoints, triangles, nbTriangles, inside);
+    }
+#endif
+}
@@ -0,0 +1,369 @@
+#include "VFVPointOctree.h"
+#include <algorithm>
+#include <numeric>
+#include <deque>
+#include <cfloat>
+
+namespace sereno
+{
+    /** \brief  The state of a traversal classifying the points of an octree against a closed mesh */
+    struct VFVPointOctreeInsideQuery
+    {
+        const std::vector<VFVPointOctree::Node>& nodes;      /*!< The octree nodes*/
+        const std::vector<uint32_t>&             pointIDs;   /*!< The octree point IDs*/
+        const VFVPointCloud&                     points;     /*!< The points*/
+        const VFVPointInMesh&                    mesh;       /*!< The mesh*/
+        std::vector<std::vector<uint32_t>>       triangles;  /*!< The surface triangles which may cross the node being visited, per depth*/
+        VFVPointCloud                            candidates; /*!< The points of the node being tested*/
+        std::vector<uint8_t>                     inside;     /*!< The parities of "candidates"*/
+    };
+
+    /** \brief  Do two boxes overlap?
+     * \param minA the minimum corner of the first box
+     * \param maxA the maximum corner of the first box
+     * \param minB the minimum corner of the second box
+     * \param maxB the maximum corner of the second box
+     * \return   true if they overlap (touching counts), false otherwise */
+    static inline bool boxesOverlap(const float* minA, const float* maxA, const float* minB, const float* maxB)
+    {
+        return minA[0] <= maxB[0] && minB[0] <= maxA[0] &&
+               minA[1] <= maxB[1] && minB[1] <= maxA[1] &&
+               minA[2] <= maxB[2] && minB[2] <= maxA[2];
+    }
+
+    /** \brief  Test the points of a node one by one
+     * \param query the traversal state
+     * \param begin the first point to test in query.pointIDs
+     * \param end the point after the last one to test in query.pointIDs
+     * \param visitor receives visitor.tested(begin, end, inside), inside[i] being the parity of the point query.pointIDs[begin+i] */
+    template<typename Visitor>
+    static void testOctreePoints(VFVPointOctreeInsideQuery& query, uint32_t begin, uint32_t end, Visitor& visitor)
+    {
+        const size_t nbPoints = end-begin;
+        float* candidates = query.candidates.allocate(nbPoints);
+        for(size_t i = 0; i < nbPoints; i++)
+        {
+            const float* p = query.points[query.pointIDs[begin+i]];
+            std::copy(p, p+3, candidates+3*i);
+        }
+
+        query.inside.resize(nbPoints);
+        query.mesh.compute(query.candidates, 0, nbPoints, query.inside.data());
+        visitor.tested(begin, end, query.inside.data());
+    }
+
+    /** \brief  Classify the points of a node against the mesh. Whole nodes are accepted or rejected when the mesh surface does not cross them
+     * \param query the traversal state. query.triangles[depth] contains the surface triangles which may cross the parent node
+     * \param nodeID the node to visit
+     * \param depth the depth of the node, relative to the first visited node
+     * \param visitor receives visitor.whole(begin, end, inside) for the points query.pointIDs[begin, end) all inside (or all outside) the mesh,
+     * and the points tested one by one (see testOctreePoints) */
+    template<typename Visitor>
+    static void visitInsideOctreeNode(VFVPointOctreeInsideQuery& query, uint32_t nodeID, uint32_t depth, Visitor& visitor)
+    {
+        const VFVPointOctree::Node& node = query.nodes[nodeID];
+
+        //The ray casting considers the points outside the mesh bounding box outside the mesh
+        if(!boxesOverlap(node.min, node.max, query.mesh.getMin(), query.mesh.getMax()))
+        {
+            visitor.whole(node.begin, node.end, false);
+            return;
+        }
+
+        const float* bounds = query.mesh.getSurfaceBounds();
+        const std::vector<uint32_t>& parentTriangles = query.triangles[depth];
+        std::vector<uint32_t>& triangles = query.triangles[depth+1];
+        triangles.clear();
+        for(uint32_t t : parentTriangles)
+            if(boxesOverlap(node.min, node.max, bounds+6*t, bounds+6*t+3))
+                triangles.push_back(t);
+
+        //The surface does not cross the node: all its points are on the same side. Test the first one only
+        if(triangles.empty())
+        {
+            uint8_t inside = 0;
+            query.mesh.compute(VFVPointCloud(query.points[query.pointIDs[node.begin]], 1), 0, 1, &inside);
+            visitor.whole(node.begin, node.end, inside != 0);
+            return;
+        }
+
+        if(node.nbChildren == 0)
+        {
+            testOctreePoints(query, node.begin, node.end, visitor);
+            return;
+        }
+
+        for(uint32_t i = 0; i < node.nbChildren; i++)
+            visitInsideOctreeNode(query, node.firstChild+i, depth+1, visitor);
+    }
+
+    /** \brief  Classify the points of a subtree against a closed mesh
+     * \param query the traversal state
+     * \param nodeID the root of the subtree
+     * \param visitor see visitInsideOctreeNode */
+    template<typename Visitor>
+    static void visitInsideOctree(VFVPointOctreeInsideQuery& query, uint32_t nodeID, Visitor& visitor)
+    {
+        query.triangles.resize(VFV_POINT_OCTREE_MAX_DEPTH+2);
+        query.triangles[0].resize(query.mesh.getNbSurfaceTriangles());
+        std::iota(query.triangles[0].begin(), query.triangles[0].end(), 0);
+        visitInsideOctreeNode(query, nodeID, 0, visitor);
+    }
+
+    void VFVPointOctree::build(const VFVPointCloud& points, const std::vector<float>* values)
+    {
+        const size_t nbPoints = points.size();
+        m_nodes.clear();
+        m_pointIDs.clear();
+        if(nbPoints == 0)
+            return;
+        if(values && values->size() != nbPoints)
+            values = NULL;
+
+        m_pointIDs.resize(nbPoints);
+        std::iota(m_pointIDs.begin(), m_pointIDs.end(), 0);
+
+        /** \brief  A node to subdivide, and its cubic cell. The children of a node split its cell in 8 equal octants */
+        struct Cell
+        {
+            uint32_t nodeID; /*!< The node*/
+            float    min[3]; /*!< The minimum corner of the cell*/
+            float    size;   /*!< The size of the cell*/
+            uint32_t depth;  /*!< The depth of the node*/
+        };
+
+        Node root;
+        root.begin = 0;
+        root.end   = nbPoints;
+        m_nodes.push_back(root);
+
+        //The root cell is the cube enclosing every point
+        Cell  rootCell{0, {FLT_MAX, FLT_MAX, FLT_MAX}, 0.0f, 0};
+        float rootMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        for(size_t i = 0; i < nbPoints; i++)
+        {
+            const float* p = points[i];
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                rootCell.min[j] = std::min(rootCell.min[j], p[j]);
+                rootMax[j]      = std::max(rootMax[j], p[j]);
+            }
+        }
+        for(uint32_t j = 0; j < 3; j++)
+            rootCell.size = std::max(rootCell.size, rootMax[j] - rootCell.min[j]);
+
+        std::vector<Cell>     cells = {rootCell};
+        std::vector<uint32_t> sorted;
+        std::vector<uint8_t>  octants;
+
+        while(!cells.empty())
+        {
+            Cell cell = cells.back();
+            cells.pop_back();
+
+            //Bounding box and value range of the node
+            Node& node = m_nodes[cell.nodeID];
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                node.min[j] =  FLT_MAX;
+                node.max[j] = -FLT_MAX;
+            }
+            node.valueMin =  FLT_MAX;
+            node.valueMax = -FLT_MAX;
+            for(uint32_t i = node.begin; i < node.end; i++)
+            {
+                uint32_t id = m_pointIDs[i];
+                const float* p = points[id];
+                for(uint32_t j = 0; j < 3; j++)
+                {
+                    node.min[j] = std::min(node.min[j], p[j]);
+                    node.max[j] = std::max(node.max[j], p[j]);
+                }
+                if(values)
+                {
+                    node.valueMin = std::min(node.valueMin, (*values)[id]);
+                    node.valueMax = std::max(node.valueMax, (*values)[id]);
+                }
+            }
+            if(!values)
+                node.valueMin = node.valueMax = 0;
+
+            const uint32_t begin = node.begin;
+            const uint32_t count = node.end - node.begin;
+            if(count <= VFV_POINT_OCTREE_LEAF_SIZE || cell.depth >= VFV_POINT_OCTREE_MAX_DEPTH)
+                continue;
+
+            //Counting sort of the points per octant
+            const float half      = cell.size/2.0f;
+            const float center[3] = {cell.min[0]+half, cell.min[1]+half, cell.min[2]+half};
+            uint32_t octantStart[9] = {0};
+            octants.resize(count);
+            for(uint32_t i = 0; i < count; i++)
+            {
+                const float* p = points[m_pointIDs[begin+i]];
+                uint8_t octant = (p[0] >= center[0] ? 1 : 0) |
+                                 (p[1] >= center[1] ? 2 : 0) |
+                                 (p[2] >= center[2] ? 4 : 0);
+                octants[i] = octant;
+                octantStart[octant+1]++;
+            }
+            for(uint32_t o = 0; o < 8; o++)
+                octantStart[o+1] += octantStart[o];
+
+            uint32_t cursor[8];
+            std::copy(octantStart, octantStart+8, cursor);
+            sorted.resize(count);
+            for(uint32_t i = 0; i < count; i++)
+                sorted[cursor[octants[i]]++] = m_pointIDs[begin+i];
+            std::copy(sorted.begin(), sorted.end(), m_pointIDs.begin()+begin);
+
+            //One child per non empty octant. "node" is invalidated by the insertions
+            const uint32_t firstChild = m_nodes.size();
+            uint32_t nbChildren = 0;
+            for(uint32_t o = 0; o < 8; o++)
+            {
+                if(octantStart[o] == octantStart[o+1])
+                    continue;
+
+                Node child;
+                child.begin = begin + octantStart[o];
+                child.end   = begin + octantStart[o+1];
+                m_nodes.push_back(child);
+
+                Cell childCell;
+                childCell.nodeID = firstChild + nbChildren;
+                childCell.min[0] = (o & 1 ? center[0] : cell.min[0]);
+                childCell.min[1] = (o & 2 ? center[1] : cell.min[1]);
+                childCell.min[2] = (o & 4 ? center[2] : cell.min[2]);
+                childCell.size   = half;
+                childCell.depth  = cell.depth+1;
+                cells.push_back(childCell);
+                nbChildren++;
+            }
+
+            m_nodes[cell.nodeID].firstChild = firstChild;
+            m_nodes[cell.nodeID].nbChildren = nbChildren;
+        }
+    }
+
+    void VFVPointOctree::getRepresentatives(uint32_t nodeID, size_t nbPoints, std::vector<uint32_t>& ids) const
+    {
+        const Node& node  = m_nodes[nodeID];
+        const size_t count = node.end - node.begin;
+        nbPoints = std::min(nbPoints, count);
+        for(size_t i = 0; i < nbPoints; i++)
+            ids.push_back(m_pointIDs[node.begin + i*count/nbPoints]);
+    }
+
+    void VFVPointOctree::getSubset(size_t maxPoints, std::vector<uint32_t>& ids) const
+    {
+        ids.clear();
+        if(m_nodes.empty() || maxPoints == 0)
+            return;
+
+        auto getNbRepresentatives = [this](uint32_t nodeID)
+        {
+            return std::min((size_t)VFV_POINT_OCTREE_REPRESENTATIVES, (size_t)(m_nodes[nodeID].end - m_nodes[nodeID].begin));
+        };
+
+        //Replace a node by its children while the budget allows it, breadth first so that the whole cloud is refined evenly
+        std::deque<uint32_t>  queue = {0};
+        std::vector<uint32_t> cut;
+        size_t total = getNbRepresentatives(0);
+        while(!queue.empty())
+        {
+            uint32_t nodeID = queue.front();
+            queue.pop_front();
+            const Node& node = m_nodes[nodeID];
+
+            size_t childrenTotal = 0;
+            for(uint32_t i = 0; i < node.nbChildren; i++)
+                childrenTotal += getNbRepresentatives(node.firstChild+i);
+
+            if(node.nbChildren == 0 || total - getNbRepresentatives(nodeID) + childrenTotal > maxPoints)
+            {
+                cut.push_back(nodeID);
+                continue;
+            }
+
+            total = total - getNbRepresentatives(nodeID) + childrenTotal;
+            for(uint32_t i = 0; i < node.nbChildren; i++)
+                queue.push_back(node.firstChild+i);
+        }
+
+        for(uint32_t nodeID : cut)
+            getRepresentatives(nodeID, std::min(maxPoints, getNbRepresentatives(nodeID)), ids);
+        std::sort(ids.begin(), ids.end());
+    }
+
+    void VFVPointOctree::getSubtrees(size_t maxPoints, std::vector<uint32_t>& nodeIDs) const
+    {
+        nodeIDs.clear();
+        if(m_nodes.empty())
+            return;
+
+        std::vector<uint32_t> stack = {0};
+        while(!stack.empty())
+        {
+            uint32_t nodeID = stack.back();
+            stack.pop_back();
+            const Node& node = m_nodes[nodeID];
+            if(node.nbChildren == 0 || node.end - node.begin <= maxPoints)
+            {
+                nodeIDs.push_back(nodeID);
+                continue;
+            }
+
+            //Reversed, so that the subtrees come in the order of getPointIDs()
+            for(uint32_t i = node.nbChildren; i > 0; i--)
+                stack.push_back(node.firstChild+i-1);
+        }
+    }
+
+    void VFVPointOctree::classifyInside(const VFVPointCloud& points, const VFVPointInMesh& mesh, uint32_t nodeID, uint8_t* inside) const
+    {
+        const uint32_t offset = m_nodes[nodeID].begin;
+        if(mesh.getNbTriangles() == 0)
+        {
+            std::fill(inside, inside + m_nodes[nodeID].end - offset, 0);
+            return;
+        }
+
+        struct
+        {
+            uint8_t* inside;
+            uint32_t offset;
+            void whole(uint32_t begin, uint32_t end, bool in)           {std::fill(inside+begin-offset, inside+end-offset, in ? 1 : 0);}
+            void tested(uint32_t begin, uint32_t end, const uint8_t* in) {std::copy(in, in+end-begin, inside+begin-offset);}
+        } visitor{inside, offset};
+
+        VFVPointOctreeInsideQuery query{m_nodes, m_pointIDs, points, mesh, {}, {}, {}};
+        visitInsideOctree(query, nodeID, visitor);
+    }
+
+    void VFVPointOctree::queryInside(const VFVPointCloud& points, const VFVPointInMesh& mesh, std::vector<uint32_t>& ids) const
+    {
+        if(m_nodes.empty() || mesh.getNbTriangles() == 0)
+            return;
+
+        struct
+        {
+            const std::vector<uint32_t>& pointIDs;
+            std::vector<uint32_t>&       ids;
+            void whole(uint32_t begin, uint32_t end, bool in)
+            {
+                if(in)
+                    ids.insert(ids.end(), pointIDs.begin()+begin, pointIDs.begin()+end);
+            }
+            void tested(uint32_t begin, uint32_t end, const uint8_t* in)
+            {
+                for(uint32_t i = begin; i < end; i++)
+                    if(in[i-begin])
+                        ids.push_back(pointIDs[i]);
+            }
+        } visitor{m_pointIDs, ids};
+
+        VFVPointOctreeInsideQuery query{m_nodes, m_pointIDs, points, mesh, {}, {}, {}};
+        visitInsideOctree(query, 0, visitor);
+    }
+}
@@ -0,0 +1,89 @@
+#include "VFVSelectionEvaluator.h"
+#include <algorithm>
+
+namespace sereno
+{
+    /** \brief  Evaluate the selection chain on one tile
+     * \param points the points
+     * \param steps the steps to apply
+     * \param begin the first point of the tile
+     * \param end the point after the last one of the tile
+     * \param mask[in, out] the mask of the whole cloud, one byte per point */
+    static void evaluateSelectionTile(const VFVPointCloud& points, const std::vector<VFVSelectionStep>& steps, size_t begin, size_t end, uint8_t* mask)
+    {
+        uint8_t inside[VFV_SELECTION_TILE_SIZE];
+        for(const VFVSelectionStep& step : steps)
+        {
+            step.mesh->compute(points, begin, end, inside);
+            combineSelection(step.op, inside, end-begin, mask+begin);
+        }
+    }
+
+    bool evaluateSelection(const VFVPointCloud& points, const std::vector<VFVSelectionStep>& steps, uint8_t* mask,
+                           VFVComputePool* pool, const std::atomic<bool>* cancelled, VFVMaskBricks* bricks)
+    {
+        const size_t nbTiles = (points.size() + VFV_SELECTION_TILE_SIZE-1) / VFV_SELECTION_TILE_SIZE;
+        auto evaluateTile = [&](size_t tile)
+        {
+            if(cancelled && *cancelled)
+                return;
+            size_t begin = tile*VFV_SELECTION_TILE_SIZE;
+            size_t end   = std::min(begin+VFV_SELECTION_TILE_SIZE, points.size());
+            evaluateSelectionTile(points, steps, begin, end, mask);
+            if(bricks)
+                bricks->markDirty(begin, end);
+        };
+
+        if(pool)
+            pool->parallelFor(nbTiles, evaluateTile, TASK_PRIORITY_HIGH);
+        else
+            for(size_t i = 0; i < nbTiles; i++)
+                evaluateTile(i);
+
+        return !(cancelled && *cancelled);
+    }
+
+    bool evaluateSelection(const VFVPointCloud& points, const VFVPointOctree& octree, const std::vector<VFVSelectionStep>& steps, uint8_t* mask,
+                           VFVComputePool* pool, const std::atomic<bool>* cancelled, VFVMaskBricks* bricks)
+    {
+        std::vector<uint32_t> subtrees;
+        octree.getSubtrees(VFV_SELECTION_TILE_SIZE, subtrees);
+
+        auto evaluateSubtree = [&](size_t i)
+        {
+            if(cancelled && *cancelled)
+                return;
+
+            //Gather the mask of the subtree points, evaluate every step, then scatter it back. Subtrees do not share points
+            const VFVPointOctree::Node& node     = octree.getNodes()[subtrees[i]];
+            const uint32_t*             pointIDs = octree.getPointIDs().data() + node.begin;
+            const size_t                nbPoints = node.end - node.begin;
+            std::vector<uint8_t> selected(nbPoints);
+            std::vector<uint8_t> inside(nbPoints);
+
+            for(size_t j = 0; j < nbPoints; j++)
+                selected[j] = mask[pointIDs[j]];
+            for(const VFVSelectionStep& step : steps)
+            {
+                octree.classifyInside(points, *step.mesh, subtrees[i], inside.data());
+                combineSelection(step.op, inside.data(), nbPoints, selected.data());
+            }
+            for(size_t j = 0; j < nbPoints; j++)
+            {
+                if(mask[pointIDs[j]] == selected[j])
+                    continue;
+                mask[pointIDs[j]] = selected[j];
+                if(bricks)
+                    bricks->markPoint(pointIDs[j]);
+            }
+        };
+
+        if(pool)
+            pool->parallelFor(subtrees.size(), evaluateSubtree, TASK_PRIORITY_HIGH);
+        else
+            for(size_t i = 0; i < subtrees.size(); i++)
+                evaluateSubtree(i);
+
+        return !(cancelled && *cancelled);
+    }
+}
@@ -0,0 +1,139 @@
+#include "VFVSelectionPreview.h"
+#include <algorithm>
+
+namespace sereno
+{
+    /** \brief  Combine one byte of a mesh with one byte of a mask
+     * \param op the boolean operation
+     * \param mask the mask byte
+     * \param inside the mesh byte
+     * \return   the new mask byte */
+    static inline uint8_t combineSelectionByte(VFVSelectionOp op, uint8_t mask, uint8_t inside)
+    {
+        switch(op)
+        {
+            case VFV_SELECTION_OP_REPLACE:
+                return inside;
+            case VFV_SELECTION_OP_UNION:
+                return mask | inside;
+            case VFV_SELECTION_OP_INTERSECTION:
+                return mask & inside;
+            case VFV_SELECTION_OP_MINUS:
+                return mask & ~inside;
+        }
+        return mask;
+    }
+
+    VFVSelectionPreview::VFVSelectionPreview(std::shared_ptr<const VFVPointCloud> points, std::shared_ptr<const VFVPointOctree> octree,
+                                             uint32_t pointStride, size_t nbDatasetPoints) :
+        m_points(points), m_octree(octree), m_pointStride(pointStride), m_nbDatasetPoints(nbDatasetPoints ? nbDatasetPoints : points->size())
+    {}
+
+    void VFVSelectionPreview::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_meshes.clear();
+        m_pending.clear();
+        m_generation++;
+        m_version++;
+    }
+
+    void VFVSelectionPreview::beginMesh(VFVSelectionOp op)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_meshes.push_back({op, std::vector<uint8_t>((m_points->size()+7)/8, 0)});
+        m_version++;
+    }
+
+    void VFVSelectionPreview::pushSlice(std::shared_ptr<const VFVPointInMesh> slice)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_meshes.empty() || slice->getNbTriangles() == 0)
+            return;
+        m_pending.push_back({slice, m_meshes.size()-1, m_generation});
+    }
+
+    void VFVSelectionPreview::processPending()
+    {
+        std::lock_guard<std::mutex> lockProcess(m_processMutex);
+
+        std::vector<uint32_t> ids;
+
+        while(true)
+        {
+            PendingSlice pending;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(m_pending.empty())
+                    return;
+                pending = m_pending.front();
+                m_pending.pop_front();
+            }
+
+            ids.clear();
+            m_octree->queryInside(*m_points, *pending.slice, ids);
+
+            //clear() may have been called meanwhile: the slice is then outdated
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(pending.generation != m_generation)
+                continue;
+
+            std::vector<uint8_t>& meshInside = m_meshes[pending.meshID].inside;
+            for(uint32_t id : ids)
+                meshInside[id/8] ^= (1 << (id%8));
+            m_version++;
+        }
+    }
+
+    bool VFVSelectionPreview::hasPending() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_pending.empty();
+    }
+
+    size_t VFVSelectionPreview::getNbMeshes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_meshes.size();
+    }
+
+    uint64_t VFVSelectionPreview::getVersion() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_version;
+    }
+
+    void VFVSelectionPreview::applyOnMask(uint8_t* mask) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        //Unpack the meshes tile per tile, and apply them while the tile is in cache
+        const size_t nbPoints = m_points->size();
+        uint8_t inside[VFV_SELECTION_TILE_SIZE];
+        for(size_t begin = 0; begin < nbPoints; begin += VFV_SELECTION_TILE_SIZE)
+        {
+            const size_t nbTilePoints = std::min((size_t)VFV_SELECTION_TILE_SIZE, nbPoints-begin);
+            for(const Mesh& mesh : m_meshes)
+            {
+                for(size_t i = 0; i < nbTilePoints; i++)
+                    inside[i] = (mesh.inside[(begin+i)/8] >> ((begin+i)%8)) & 1;
+                combineSelection(mesh.op, inside, nbTilePoints, mask+begin);
+            }
+        }
+    }
+
+    void VFVSelectionPreview::getPreview(const std::vector<uint32_t>& subset, std::vector<uint8_t>& preview) const
+    {
+        preview.assign((subset.size()+7)/8, 0);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(size_t i = 0; i < subset.size(); i++)
+        {
+            uint32_t id = subset[i];
+            uint8_t selected = 0;
+            for(const Mesh& mesh : m_meshes)
+                selected = combineSelectionByte(mesh.op, selected, (mesh.inside[id/8] >> (id%8)) & 1) & 1;
+            preview[i/8] |= (selected << (i%8));
+        }
+    }
+}
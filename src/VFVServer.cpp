@@ -2,10 +2,15 @@
 #include "TransferFunction/GTF.h"
 #include "TransferFunction/TriangularGTF.h"
 #include "TransferFunction/MergeTF.h"
+#include "VFVMaskEncoding.h"
+#include "VFVTimeSeries.h"
+#include "VFVCloudPointFile.h"
 #include <random>
+#include <cmath>
 #include <algorithm>
 #include <iostream>
 #include <filesystem>
+#include <cstring>
 
 #ifndef TEST
 //#define TEST
@@ -301,39 +306,169 @@ namespace sereno
         return tfMD;
     } 
 
-    static std::shared_ptr<uint8_t> generateVolumetricMaskEvent(const SubDataset* sd, uint32_t datasetID, size_t* dataSize=NULL)
+    /** \brief  Generate the message containing the volumetric mask of a SubDataset. Its dataset values have to be locked
+     * \param pool the pool to take the message buffer from
+     * \param sd the SubDataset
+     * \param datasetID the ID of its dataset
+     * \param dataSize[out] the message size
+     * \param encoded true to generate a VFV_SEND_VOLUMETRIC_MASK_ENCODED message (see CLIENT_FEATURE_ENCODED_VOLUMETRIC_MASK), false for VFV_SEND_VOLUMETRIC_MASK
+     * \return   the message */
+    static std::shared_ptr<uint8_t> generateVolumetricMaskEvent(VFVBufferPool& pool, const SubDataset* sd, uint32_t datasetID, size_t* dataSize=NULL, bool encoded=false)
     {
-        size_t volDataSize = 2 + 2*4 + 4 + sd->getVolumetricMaskSize() + 1;
-        uint8_t* volData   = (uint8_t*)malloc(volDataSize);
-        size_t offset = 0;
+        const uint8_t* mask     = sd->getVolumetricMask();
+        const size_t   maskSize = sd->getVolumetricMaskSize();
 
-        writeUint16(volData + offset, VFV_SEND_VOLUMETRIC_MASK);
-        offset += sizeof(uint16_t);
+        if(encoded)
+        {
+            size_t encodedSize       = 0;
+            VFVMaskEncoding encoding = chooseMaskEncoding(mask, maskSize, &encodedSize);
+
+            VFVMessageBuilder msg(pool, VFV_SEND_VOLUMETRIC_MASK_ENCODED, 4*sizeof(uint32_t) + 2*sizeof(uint8_t) + encodedSize);
+            msg.pushUint32(datasetID).pushUint32(sd->getID()).pushUint32(maskSize)
+               .pushByte(encoding).pushUint32(encodedSize);
+            encodeMask(mask, maskSize, encoding, msg.reserve(encodedSize));
+            msg.pushByte(sd->isVolumetricMaskEnabled());
 
-        //DatasetID
-        writeUint32(volData+offset, datasetID);
-        offset += sizeof(uint32_t);
+            if(dataSize)
+                *dataSize = msg.getSize();
+            return msg.getData();
+        }
 
-        //SubDatasetID
-        writeUint32(volData+offset, sd->getID());
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(pool, VFV_SEND_VOLUMETRIC_MASK, 3*sizeof(uint32_t) + sizeof(uint8_t) + maskSize);
+        msg.pushUint32(datasetID).pushUint32(sd->getID())
+           .pushUint32(maskSize).pushBytes(mask, maskSize)
+           .pushByte(sd->isVolumetricMaskEnabled());
 
-        //Mask byte array
-        writeUint32(volData+offset, sd->getVolumetricMaskSize());
-        offset += sizeof(uint32_t);
-        for(size_t i = 0; i < sd->getVolumetricMaskSize(); i++, offset++)
-            volData[offset] = sd->getVolumetricMask()[i];
+        if(dataSize)
+            *dataSize = msg.getSize();
+        return msg.getData();
+    }
+
+    /* \brief The base sequence number of a VFV_SEND_VOLUMETRIC_MASK_DELTA message carrying the whole mask */
+#define VOLUMETRIC_MASK_SEQUENCE_RESYNC 0xffffffff
+
+    /** \brief  Generate a VFV_SEND_VOLUMETRIC_MASK_DELTA message
+     * \param pool the pool to take the message buffer from
+     * \param datasetID the dataset ID
+     * \param sdID the SubDataset ID
+     * \param mask the volumetric mask
+     * \param maskSize the size of the volumetric mask
+     * \param enabled is the volumetric mask enabled?
+     * \param baseSequence the sequence number the bricks apply to. VOLUMETRIC_MASK_SEQUENCE_RESYNC == a mask full of 0s
+     * \param sequence the sequence number of the resulting mask
+     * \param bricks the bricks to send
+     * \param dataSize[out] the message size
+     * \return   the message */
+    static std::shared_ptr<uint8_t> generateVolumetricMaskDeltaEvent(VFVBufferPool& pool, uint32_t datasetID, uint32_t sdID, const uint8_t* mask, size_t maskSize, bool enabled,
+                                                                     uint32_t baseSequence, uint32_t sequence, const std::vector<uint32_t>& bricks, size_t* dataSize)
+    {
+        std::vector<VFVMaskEncoding> encodings(bricks.size());
+        std::vector<size_t>          encodedSizes(bricks.size());
+        size_t capacity = 7*sizeof(uint32_t) + sizeof(uint8_t);
+        for(size_t i = 0; i < bricks.size(); i++)
+        {
+            size_t begin    = (size_t)bricks[i]*VOLUMETRIC_MASK_BRICK_SIZE;
+            encodings[i]    = chooseMaskEncoding(mask + begin, std::min((size_t)VOLUMETRIC_MASK_BRICK_SIZE, maskSize-begin), &encodedSizes[i]);
+            capacity       += 2*sizeof(uint32_t) + sizeof(uint8_t) + encodedSizes[i];
+        }
 
-        volData[offset] = sd->isVolumetricMaskEnabled(); 
-        offset++;
+        VFVMessageBuilder msg(pool, VFV_SEND_VOLUMETRIC_MASK_DELTA, capacity);
+        msg.pushUint32(datasetID).pushUint32(sdID).pushUint32(baseSequence).pushUint32(sequence)
+           .pushUint32(maskSize).pushUint32(VOLUMETRIC_MASK_BRICK_SIZE).pushUint32(bricks.size());
 
-        std::shared_ptr<uint8_t> sharedVolData(volData, free);
+        for(size_t i = 0; i < bricks.size(); i++)
+        {
+            size_t begin = (size_t)bricks[i]*VOLUMETRIC_MASK_BRICK_SIZE;
+            msg.pushUint32(bricks[i]).pushByte(encodings[i]).pushUint32(encodedSizes[i]);
+            encodeMask(mask + begin, std::min((size_t)VOLUMETRIC_MASK_BRICK_SIZE, maskSize-begin), encodings[i], msg.reserve(encodedSizes[i]));
+        }
+        msg.pushByte(enabled);
 
         if(dataSize)
-            *dataSize = offset;
-        return sharedVolData;
+            *dataSize = msg.getSize();
+        return msg.getData();
+    }
+
+
+    /* \brief  Build the point-in-mesh test of a selection mesh in the local space of a SubDataset
+     * \param mesh the mesh, in world space
+     * \param position the SubDataset position
+     * \param invRotation the inverse of the SubDataset global rotation
+     * \param scale the SubDataset scale
+     * \return   the point-in-mesh test of the mesh, expressed in the SubDataset local space */
+    static VFVPointInMesh getSubDatasetPointInMesh(const VolumetricMesh& mesh, const glm::vec3& position, const Quaternionf& invRotation, const glm::vec3& scale)
+    {
+        VolumetricMesh localMesh = mesh;
+        for(glm::vec3& p : localMesh.points)
+            p = (invRotation * (p - position)) / scale;
+        return VFVPointInMesh(localMesh);
+    }
+
+    /* \brief  Read the status of a headset to send to the other clients
+     * \param headsetData the headset data to read
+     * \param status[out] the status to fill */
+    static void readHeadsetStatus(VFVHeadsetData& headsetData, VFVHeadsetStatus& status)
+    {
+        status.color         = headsetData.color;
+        status.currentAction = headsetData.currentAction;
+
+        for(uint32_t i = 0; i < 3; i++)
+            status.position[i] = headsetData.position[i];
+        for(uint32_t i = 0; i < 4; i++)
+            status.rotation[i] = headsetData.rotation[i];
+
+        status.pointingIT           = headsetData.pointingData.pointingIT;
+        status.pointingDatasetID    = headsetData.pointingData.datasetID;
+        status.pointingSubDatasetID = headsetData.pointingData.subDatasetID;
+        status.pointingInPublic     = headsetData.pointingData.pointingInPublic;
+
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            status.pointingPosition[i]   = headsetData.pointingData.localSDPosition[i];
+            status.pointingPosition[3+i] = headsetData.pointingData.headsetStartPosition[i];
+        }
+        for(uint32_t i = 0; i < 4; i++)
+            status.pointingPosition[6+i] = headsetData.pointingData.headsetStartOrientation[i];
+    }
+
+    /* \brief  Quantize a unit quaternion using the "smallest three" encoding:
+     * the largest component (in absolute value) is dropped and the three others, which lie in [-1/sqrt(2), 1/sqrt(2)], are stored on 16 bits.
+     * The quaternion is negated beforehand if needed so that the dropped component is positive.
+     * \param q the quaternion to quantize
+     * \param largestIdx[out] the index of the dropped component
+     * \param values[out] the three other components, quantized */
+    static void quantizeQuaternion(const float q[4], uint8_t* largestIdx, int16_t values[3])
+    {
+        uint8_t largest = 0;
+        for(uint8_t i = 1; i < 4; i++)
+            if(fabs(q[i]) > fabs(q[largest]))
+                largest = i;
+
+        float sign = (q[largest] < 0 ? -1.0f : 1.0f);
+        for(uint8_t i = 0, j = 0; i < 4; i++)
+        {
+            if(i == largest)
+                continue;
+            float v = std::min(1.0f, std::max(-1.0f, sign*q[i]*std::sqrt(2.0f)));
+            values[j++] = (int16_t)lroundf(v*32767.0f);
+        }
+        *largestIdx = largest;
     }
 
+    /* \brief  Fill the pointing data of a headset status
+     * \param msg the message to fill
+     * \param status the headset status to read */
+    static void writeHeadsetPointingStatus(VFVMessageBuilder& msg, const VFVHeadsetStatus& status)
+    {
+        msg.pushUint32(status.pointingIT)                  //Pointing IT
+           .pushUint32(status.pointingDatasetID)           //Pointing Dataset ID
+           .pushUint32(status.pointingSubDatasetID)        //Pointing SubDataset ID
+           .pushByte(status.pointingInPublic ? 1 : 0);     //Pointing done in public space?
+
+        //Pointing local SD position, headset starting position and headset starting orientation
+        for(uint32_t i = 0; i < 10; i++)
+            msg.pushFloat(status.pointingPosition[i]);
+    }
 
     VFVServer::VFVServer(uint32_t nbThread, uint32_t port) : Server(nbThread, port)
     {
@@ -363,7 +498,7 @@ namespace sereno
         m_log << ",\n";
         m_log << std::flush;
 #endif
-        addVTKDataset(NULL, vtkInfo);
+        addVTKDataset(NULL, vtkInfo, false);
 
         m_vtkDatasets[0].dataset->loadValues([](Dataset* dataset, uint32_t status, void* data)
         {
@@ -391,9 +526,9 @@ namespace sereno
 
     VFVServer::VFVServer(VFVServer&& mvt) : Server(std::move(mvt))
     {
-        m_updateThread     = mvt.m_updateThread;
-        m_computeThread    = mvt.m_computeThread;
-        mvt.m_updateThread = mvt.m_computeThread = NULL;
+        m_updateThread        = mvt.m_updateThread;
+        m_transformThread     = mvt.m_transformThread;
+        mvt.m_updateThread    = mvt.m_transformThread = NULL;
     }
 
     VFVServer::~VFVServer()
@@ -436,8 +571,10 @@ namespace sereno
             m_availableHeadsetColors.push(SCIVIS_DISTINGUISHABLE_COLORS[i]);
 
         bool ret = Server::launch();
-        m_updateThread  = new std::thread(&VFVServer::updateThread, this);
-        m_computeThread = new std::thread(&VFVServer::computeThread, this);
+        m_updateThread    = new std::thread(&VFVServer::updateThread, this);
+        m_transformThread = new std::thread(&VFVServer::transformThread, this);
+        m_computePool.launch(COMPUTE_POOL_NB_THREADS);
+        INFO << "Compute pool: " << m_computePool.getNbThreads() << " threads" << std::endl;
 
         return ret;
     }
@@ -445,11 +582,11 @@ namespace sereno
     void VFVServer::cancel()
     {
         Server::cancel();
-        m_computeCond.notify_all();
+        m_computePool.close();
         if(m_updateThread && m_updateThread->joinable())
             pthread_cancel(m_updateThread->native_handle());
-//        if(m_computeThread && m_computeThread->joinable())
-//            pthread_cancel(m_computeThread->native_handle());
+        if(m_transformThread && m_transformThread->joinable())
+            pthread_cancel(m_transformThread->native_handle());
     }
 
     void VFVServer::wait()
@@ -457,28 +594,38 @@ namespace sereno
         Server::wait();
         if(m_updateThread && m_updateThread->joinable())
             m_updateThread->join();
-        if(m_computeThread && m_computeThread->joinable())
-            m_computeThread->join();
+        if(m_transformThread && m_transformThread->joinable())
+            m_transformThread->join();
+        m_computePool.wait();
     }
 
     void VFVServer::closeServer()
     {
         Server::closeServer();
+        INFO << "Outgoing message buffers: " << m_bufferPool.getNbAllocations() << " allocations for " 
+             << m_bufferPool.getNbAcquisitions() << " messages" << std::endl;
+        INFO << "HEADSETS_STATUS ticks: " << m_headsetsStatusTiming.toString() << std::endl;
+        INFO << "Dataset lock: " << m_datasetLockStats.toString() << std::endl;
+        INFO << "Dataset shared lock: " << m_datasetSharedLockStats.toString() << std::endl;
+        INFO << "Client table lock: " << m_mapLockStats.toString() << std::endl;
+        INFO << "Compute pool: " << m_computePool.getNbExecuted() << " tasks executed, " << m_computePool.getNbStolen() << " stolen, "
+             << m_computePool.getNbBlockedPushes() << " blocked pushes, at most " << m_computePool.getMaxQueued() << " tasks queued" << std::endl;
+        INFO << "Transformations: " << m_nbCoalescedTransforms << " coalesced out of " << m_nbReceivedTransforms << " received" << std::endl;
         if(m_updateThread != NULL)
         {
             delete m_updateThread;
             m_updateThread = 0;
         }
-        if(m_computeThread != NULL)
+        if(m_transformThread != NULL)
         {
-            delete m_computeThread;
-            m_computeThread = 0;
+            delete m_transformThread;
+            m_transformThread = 0;
         }
     }
 
     void VFVServer::updateLocationTabletDebug(const glm::vec3& pos, const Quaternionf& rot)
     {
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
         for(auto it: m_clientTable)
             if(it.second->isTablet())
                 sendLocationTablet(pos, rot, it.second);
@@ -486,7 +633,7 @@ namespace sereno
 
     void VFVServer::pushTabletVRPNPosition(const glm::vec3& pos, const Quaternionf& rot, int tabletID)
     {
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
         for(auto it : m_clientTable)
         {
             VFVClientSocket* clt = it.second;
@@ -501,7 +648,7 @@ namespace sereno
 
     void VFVServer::pushHeadsetVRPNPosition(const glm::vec3& pos, const Quaternionf& rot, int tabletID)
     {
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
         for(auto it : m_clientTable)
         {
             VFVClientSocket* clt = it.second;
@@ -517,7 +664,7 @@ namespace sereno
 
     void VFVServer::commitAllVRPNPositions()
     {
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
 
         //Search for every tablets
         for(auto it : m_clientTable)
@@ -584,12 +731,48 @@ namespace sereno
 
 
         INFO << "Disconnecting a client...\n";
+
+        //The selections this client confirmed keep being computed, but their results are not sent back to it
+        {
+            std::lock_guard<std::mutex> lockJobs(m_selectionJobsMutex);
+            for(auto& it : m_selectionJobs)
+                if(it.second->headset == c)
+                    it.second->headset = NULL;
+        }
+
+        //Stop its live selection preview. Tasks computing it keep their own reference
+        m_selectionPreviews.erase(c);
+
+        //Discard the transformations this client sent and which are not applied yet (including the ones flushTransforms is about to apply)
+        {
+            std::lock_guard<std::mutex> lockTransforms(m_pendingTransformsMutex);
+            for(auto* transforms : {&m_pendingTransforms, &m_flushedTransforms})
+            {
+                for(auto it = transforms->begin(); it != transforms->end();)
+                {
+                    VFVPendingTransform& pending = it->second;
+                    if(pending.rotateClient == c)
+                        pending.hasRotate = false;
+                    if(pending.moveClient == c)
+                        pending.hasMove = false;
+                    if(pending.scaleClient == c)
+                        pending.hasScale = false;
+
+                    if(!pending.hasRotate && !pending.hasMove && !pending.hasScale)
+                        it = transforms->erase(it);
+                    else
+                        it++;
+                }
+            }
+        }
         //Handle headset disconnections
         if(c->isHeadset())
         {
             INFO << "Disconnecting a headset client\n";
 
-            auto f = [c,this](DatasetMetaData& mtData) 
+            //Collect the SubDatasets this headset owns first: removeSubDataset erases their meta data
+            std::vector<VFVRemoveSubDataset> removeEvents;
+            auto f = [c, &removeEvents](DatasetMetaData& mtData)
             {
                 for(SubDatasetMetaData& sdMT : mtData.sdMetaData)
                     if(sdMT.owner == c)
@@ -597,7 +780,7 @@ namespace sereno
                         VFVRemoveSubDataset removeEvent;
                         removeEvent.datasetID    = sdMT.datasetID;
                         removeEvent.subDatasetID = sdMT.sdID;
-                        removeSubDataset(removeEvent);
+                        removeEvents.push_back(removeEvent);
                     }
             };
 
@@ -605,9 +788,15 @@ namespace sereno
                 f(it.second);
             for(auto& it : m_binaryDatasets)
                 f(it.second);
+            for(auto& it : m_cloudPointDatasets)
+                f(it.second);
 
-            //Put available that color
-            m_availableHeadsetColors.push(c->getHeadsetData().color);
+            for(auto& removeEvent : removeEvents)
+                removeSubDataset(removeEvent);
+
+            //Put available that color, unless it is shared with another headset
+            if(c->getHeadsetData().ownColor)
+                m_availableHeadsetColors.push(c->getHeadsetData().color);
             m_nbConnectedHeadsets--;
 
             VFVClientSocket* tablet = c->getHeadsetData().tablet;
@@ -648,43 +837,34 @@ namespace sereno
 
     Dataset* VFVServer::getDataset(uint32_t datasetID, uint32_t sdID, SubDataset** sd)
     {
-        auto it = m_datasets.find(datasetID);
-        if(it == m_datasets.end())
+        auto it = m_datasetEntries.find(datasetID);
+        if(it == m_datasetEntries.end())
         {
             WARNING << "The dataset id 'datasetID' is not found\n";
             return NULL;
         }
 
-        if(it->second->getSubDataset(sdID) == NULL)
+        if(it->second.dataset->getSubDataset(sdID) == NULL)
         {
             WARNING << "The subdataset ID 'sdID' in dataset ID 'datasetID' is not found\n";
             return NULL;
         }
 
         if(sd)
-            *sd = it->second->getSubDataset(sdID);
+            *sd = it->second.dataset->getSubDataset(sdID);
 
-        return it->second;
+        return it->second.dataset;
     }
 
     DatasetMetaData* VFVServer::getMetaData(uint32_t datasetID, uint32_t sdID, SubDatasetMetaData** sdMTPtr)
     {
         DatasetMetaData* mt = NULL;
         SubDatasetMetaData* sdMT = NULL;
-        auto it = m_vtkDatasets.find(datasetID);
-        if(it != m_vtkDatasets.end())
-        {
-            sdMT = it->second.getSDMetaDataByID(sdID);
-            mt = &it->second;
-        }
-        else
+        auto it = m_datasetEntries.find(datasetID);
+        if(it != m_datasetEntries.end())
         {
-            auto it2 = m_cloudPointDatasets.find(datasetID);
-            if(it2 != m_cloudPointDatasets.end())
-            {
-                sdMT = it2->second.getSDMetaDataByID(sdID);
-                mt = &it2->second;
-            }
+            mt   = it->second.metaData;
+            sdMT = mt->getSDMetaDataByID(sdID);
         }
 
         if(sdMTPtr)
@@ -693,19 +873,20 @@ namespace sereno
         return mt;
     }
 
-    DatasetType VFVServer::getDatasetType(const Dataset* d) const
+    std::shared_ptr<VFVValuesMutex> VFVServer::getDatasetValuesMutex(uint32_t datasetID)
     {
-        for(auto& it : m_vtkDatasets)
-            if(it.second.dataset == d)
-                return DATASET_TYPE_VTK;
+        auto it = m_datasetEntries.find(datasetID);
+        if(it != m_datasetEntries.end())
+            return it->second.metaData->valuesMutex;
 
-        for(auto& it : m_binaryDatasets)
-            if(it.second.dataset == d)
-                return DATASET_TYPE_VECTOR_FIELD;
+        return nullptr;
+    }
 
-        for(auto& it : m_cloudPointDatasets)
-            if(it.second.dataset == d)
-                return DATASET_TYPE_CLOUD_POINT;
+    DatasetType VFVServer::getDatasetType(const Dataset* d) const
+    {
+        auto it = m_datasetEntriesByPointer.find(d);
+        if(it != m_datasetEntriesByPointer.end())
+            return it->second->type;
 
         return DATASET_TYPE_NOT_FOUND;
     }
@@ -814,13 +995,23 @@ namespace sereno
         return true;
     }
 
+    void VFVServer::registerDataset(uint32_t datasetID, Dataset* dataset, DatasetType type, DatasetMetaData* metaData)
+    {
+        m_datasets.insert(std::pair<uint32_t, Dataset*>(datasetID, dataset));
+
+        VFVDatasetEntry& entry = m_datasetEntries[datasetID];
+        entry.datasetID = datasetID;
+        entry.type      = type;
+        entry.dataset   = dataset;
+        entry.metaData  = metaData;
+        m_datasetEntriesByPointer[dataset] = &entry;
+    }
+
     uint32_t VFVServer::getDatasetID(Dataset* dataset)
     {
-        for(auto& it : m_datasets)
-            if(it.second == dataset)
-            {
-                return it.first;
-            }
+        auto it = m_datasetEntriesByPointer.find(dataset);
+        if(it != m_datasetEntriesByPointer.end())
+            return it->second->datasetID;
 
         return -1;
     }
@@ -878,8 +1069,8 @@ namespace sereno
 
     void VFVServer::loginTablet(VFVClientSocket* client, const VFVIdentTabletInformation& identTablet)
     {
-        std::lock_guard<std::mutex> lockDataset(m_datasetMutex);
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
 
         bool alreadyConnected = client->isTablet();
 
@@ -927,12 +1118,12 @@ namespace sereno
 
     void VFVServer::loginHeadset(VFVClientSocket* client)
     {
-        std::lock_guard<std::mutex> lockDataset(m_datasetMutex);
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
 
         bool alreadyConnected = client->isHeadset();
 
-        if(m_nbConnectedHeadsets >= MAX_NB_HEADSETS)
+        if(MAX_NB_HEADSETS > 0 && m_nbConnectedHeadsets >= MAX_NB_HEADSETS)
         {
             WARNING << "Too much headsets connected... Disconnecting this one\n";
             closeClient(client->socket);
@@ -947,8 +1138,15 @@ namespace sereno
         //Set visualizable color
         if(!alreadyConnected)
         {
-            client->getHeadsetData().color = m_availableHeadsetColors.top();
-            m_availableHeadsetColors.pop();
+            //More headsets than distinguishable colors (see MAX_NB_HEADSETS): colors are shared
+            if(m_availableHeadsetColors.empty())
+                client->getHeadsetData().color = SCIVIS_DISTINGUISHABLE_COLORS[client->getHeadsetData().id % (sizeof(SCIVIS_DISTINGUISHABLE_COLORS)/sizeof(SCIVIS_DISTINGUISHABLE_COLORS[0]))];
+            else
+            {
+                client->getHeadsetData().color    = m_availableHeadsetColors.top();
+                client->getHeadsetData().ownColor = true;
+                m_availableHeadsetColors.pop();
+            }
             onLoginSendCurrentStatus(client);
         }
 
@@ -974,38 +1172,52 @@ namespace sereno
         INFO << "End Connection" << std::endl;
     }
 
-    void VFVServer::addVTKDataset(VFVClientSocket* client, const VFVVTKDatasetInformation& dataset)
+    void VFVServer::addVTKDataset(VFVClientSocket* client, const VFVVTKDatasetInformation& dataset, bool async)
     {
         if(client != NULL && !client->isTablet())
         {
-            std::lock_guard<std::mutex> lock(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
             VFVSERVER_NOT_A_TABLET
             return;
         }
 
-        //Open the dataset asked
-        VTKParser*  parser = new VTKParser(DATASET_DIRECTORY+dataset.name);
-        if(!parser->parse())
+        //Reserve the dataset ID and tell everyone that it is being loaded
+        uint32_t datasetID;
         {
-            ERROR << "Could not parse the VTK Dataset " << dataset.name << std::endl;
-            delete parser;
-            return;
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+            datasetID = m_currentDataset++;
+
+            VFVDatasetLoading& loading = m_loadingDatasets[datasetID];
+            loading.name = dataset.name;
+            for(auto clt : m_clientTable)
+                sendDatasetLoadingStatus(clt.second, datasetID, loading, DATASET_LOADING_STATUS_LOADING);
         }
 
-        //Determine VTKFieldValues to use
-        std::vector<const VTKFieldValue*> ptFieldValues;
-        std::vector<const VTKFieldValue*> cellFieldValues;
+        //Parse the files without blocking the client's thread. Do not hold any lock here: pushHeavy may wait for room in the queue
+        if(async && pushHeavy([this, datasetID, dataset]() {loadVTKDataset(datasetID, dataset);}, TASK_PRIORITY_LOW))
+            return;
+        loadVTKDataset(datasetID, dataset);
+    }
 
-        std::vector<const VTKFieldValue*> parserPtValues   = parser->getPointFieldValueDescriptors();
-        std::vector<const VTKFieldValue*> parserCellValues = parser->getCellFieldValueDescriptors();
+    /* \brief  Get the field values of a parsed VTK file a dataset asks for
+     * \param parser the parsed file
+     * \param dataset the dataset information
+     * \param ptFieldValues[out] the point field values asked
+     * \param cellFieldValues[out] the cell field values asked
+     * \return   false if a field index is not valid, true otherwise */
+    static bool getVTKFieldValues(VTKParser& parser, const VFVVTKDatasetInformation& dataset,
+                                  std::vector<const VTKFieldValue*>& ptFieldValues, std::vector<const VTKFieldValue*>& cellFieldValues)
+    {
+        std::vector<const VTKFieldValue*> parserPtValues   = parser.getPointFieldValueDescriptors();
+        std::vector<const VTKFieldValue*> parserCellValues = parser.getCellFieldValueDescriptors();
 
         for(auto i : dataset.ptFields)
         {
             if(i >= parserPtValues.size())
             {
                 ERROR << "Indice " << i << " is not a valid indice for Point Field Value in the dataset " << dataset.name << std::endl;
-                delete parser;
-                return;
+                return false;
             }
             ptFieldValues.push_back(parserPtValues[i]);
         }
@@ -1015,73 +1227,184 @@ namespace sereno
             if(i >= parserCellValues.size())
             {
                 ERROR << "Indice " << i << " is not a valid indice for Cell Field Value in the dataset " << dataset.name << std::endl;
-                delete parser;
-                return;
+                return false;
             }
             cellFieldValues.push_back(parserCellValues[i]);
         }
+        return true;
+    }
 
-        INFO << "Opening VTK Dataset " << dataset.name << std::endl;
+    void VFVServer::loadVTKDataset(uint32_t datasetID, const VFVVTKDatasetInformation& dataset)
+    {
+        //Follow the parsing of the files: this opening may join the parsing of another client opening the same dataset.
+        //A joining opening returns at once, its dataset being built from the timesteps as they are published (see subscribeVTKSource)
+        bool owner = false;
+        std::shared_ptr<VFVVTKSource> source = getVTKSource(dataset, owner);
+        subscribeVTKSource(datasetID, dataset, source);
+        if(!owner)
+        {
+            INFO << "VTK Dataset " << dataset.name << " is already opened with the same fields. Sharing its parsed files" << std::endl;
+            return;
+        }
 
-        //Create the dataset
-        std::shared_ptr<VTKParser> sharedParser(parser);
-        VTKDataset* vtk = new VTKDataset(sharedParser, ptFieldValues, cellFieldValues);
+        //Open the dataset asked. Check the fields before publishing it: every opening of this source asks the same fields
+        std::shared_ptr<VTKParser> parser = std::make_shared<VTKParser>(DATASET_DIRECTORY+dataset.name);
+        std::vector<const VTKFieldValue*> ptFieldValues;
+        std::vector<const VTKFieldValue*> cellFieldValues;
+        if(!parser->parse() || !getVTKFieldValues(*parser, dataset, ptFieldValues, cellFieldValues))
+        {
+            ERROR << "Could not parse the VTK Dataset " << dataset.name << std::endl;
+            removeVTKSource(dataset);
+            source->finish();
+            return;
+        }
 
-        //Search for other VTK subfiles part of this serie (time serie data)
+        //Search for other VTK subfiles part of this serie (time serie data), in timestep order
         std::vector<std::string> suffixes;
-        for(const auto& entry : std::filesystem::directory_iterator(DATASET_DIRECTORY))
+        if(!getTimeSeriesSuffixes(DATASET_DIRECTORY, dataset.name, suffixes))
+            WARNING << "Could not look for the other timesteps of the VTK Dataset " << dataset.name << std::endl;
+        uint32_t nbTimesteps = suffixes.size()+1;
+        source->setNbTimesteps(nbTimesteps);
+        source->publish(parser);
+
+        //Parse the other timesteps in parallel, by windows of VTK_TIMESTEP_PARSING_MAX_THREADS files (bounding the memory of the parsers not added yet),
+        //and publish them in order, the datasets being usable meanwhile
+        size_t windowSize = (VTK_TIMESTEP_PARSING_MAX_THREADS > 0 ? VTK_TIMESTEP_PARSING_MAX_THREADS : std::max<size_t>(1, m_computePool.getNbThreads()+1));
+        for(size_t begin = 0; begin < suffixes.size(); begin += windowSize)
         {
-            std::string timePath = entry.path().filename().string();
-            if(timePath.rfind(dataset.name, 0) == 0 && timePath.size() > dataset.name.size()+1)
+            size_t end = std::min(begin+windowSize, suffixes.size());
+            std::vector<std::shared_ptr<VTKParser>> suffixParsers(end-begin);
+
+            m_computePool.parallelFor(end-begin, [&](size_t i)
             {
-                std::string suffix = timePath.substr(dataset.name.size()+1);
-                for(char c : suffix)
+                const std::string& s = suffixes[begin+i];
+                std::shared_ptr<VTKParser> suffixParser = std::make_shared<VTKParser>(DATASET_DIRECTORY+dataset.name+"."+s);
+                if(!suffixParser->parse())
                 {
-                    if(c < '0' || c > '9')
-                        goto endFor;
+                    ERROR << "Could not parse the VTK Dataset " << dataset.name + "." + s << std::endl;
+                    return;
                 }
-                suffixes.push_back(suffix);
-endFor:;
+                suffixParsers[i] = suffixParser;
+            }, TASK_PRIORITY_LOW, VTK_TIMESTEP_PARSING_MAX_THREADS);
+
+            for(auto& suffixParser : suffixParsers)
+            {
+                if(suffixParser)
+                    source->publish(suffixParser);
+                else
+                    source->setNbTimesteps(--nbTimesteps);
+                suffixParser = nullptr;
             }
         }
+        source->finish();
+    }
+
+    /** \brief  The state of a VTK dataset built from the timesteps of a VFVVTKSource (see VFVServer::subscribeVTKSource).
+     * Only used by the subscriber callbacks, whose calls never overlap */
+    struct VFVVTKDatasetBuild
+    {
+        VTKDataset*                     vtk = NULL;      /*!< The dataset. NULL until the first timestep is received, or if it could not be created*/
+        std::shared_ptr<VFVValuesMutex> valuesMutex;     /*!< The mutex of the dataset values*/
+        uint32_t                        nbTimesteps = 0; /*!< The number of timesteps added to vtk*/
+        std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now(); /*!< When the opening started*/
+    };
+
+    void VFVServer::subscribeVTKSource(uint32_t datasetID, const VFVVTKDatasetInformation& dataset, std::shared_ptr<VFVVTKSource> source)
+    {
+        std::shared_ptr<VFVVTKDatasetBuild> build = std::make_shared<VFVVTKDatasetBuild>();
+
+        //The source keeps its subscribers until it finishes: do not make it keep itself alive
+        std::weak_ptr<VFVVTKSource> weakSource = source;
 
-        //Sort the suffixes
-        if(suffixes.size())
+        auto onTimestep = [this, datasetID, dataset, build, weakSource](size_t i, std::shared_ptr<VTKParser> parser)
         {
-            std::sort(suffixes.begin(), suffixes.end());
-            for(const auto& s : suffixes)
+            //The first timestep is ready: create the dataset, add it to the list and send it to the clients
+            if(i == 0)
             {
-                VTKParser* suffixParser = new VTKParser(DATASET_DIRECTORY+dataset.name+"."+s);
-                if(!suffixParser->parse())
+                std::shared_ptr<VFVVTKSource> sharedSource = weakSource.lock();
+                if(sharedSource)
+                    build->vtk = createVTKDataset(datasetID, dataset, parser, sharedSource, &build->valuesMutex);
+                if(build->vtk)
                 {
-                    ERROR << "Could not parse the VTK Dataset " << dataset.name + "." + s << std::endl;
-                    delete suffixParser;
-                    continue;
+                    build->nbTimesteps = 1;
+                    INFO << "VTK Dataset " << dataset.name << ": first timestep ready in "
+                         << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - build->loadStart).count() << " ms" << std::endl;
                 }
-
-                std::shared_ptr<VTKParser> sharedSuffixParser(suffixParser);
-                vtk->addTimestep(sharedSuffixParser);
+                return;
             }
-        }
 
-        //Update the position
-        for(uint32_t i = 0; i < vtk->getNbSubDatasets(); i++, m_currentSubDataset++)
+            if(build->vtk == NULL)
+                return;
+
+            //A computation (e.g., a volumetric selection) may hold the values for long: wait for them before taking the global locks
+            std::lock_guard<VFVValuesMutex> lockValues(*build->valuesMutex);
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+            VFVDatasetLoading& loading = m_loadingDatasets[datasetID];
+            build->vtk->addTimestep(parser);
+            loading.nbLoadedTimesteps = ++build->nbTimesteps;
+            if(std::shared_ptr<VFVVTKSource> sharedSource = weakSource.lock())
+                loading.nbTimesteps = sharedSource->getNbTimesteps();
+
+            for(auto clt : m_clientTable)
+                sendDatasetLoadingStatus(clt.second, datasetID, loading, DATASET_LOADING_STATUS_LOADING);
+        };
+
+        auto onFinish = [this, datasetID, dataset, build]()
         {
-            SubDataset* sd = vtk->getSubDatasets()[i];
-            sd->setPosition(glm::vec3(m_currentSubDataset*2.0f, 0.0f, 0.0f));
-            sd->setScale(glm::vec3(0.5f, 0.5f, 0.5f));
-        }
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+            auto it = m_loadingDatasets.find(datasetID);
+            if(it == m_loadingDatasets.end())
+                return;
+
+            if(build->vtk)
+            {
+                it->second.nbTimesteps = build->nbTimesteps;
+                for(auto clt : m_clientTable)
+                    sendDatasetLoadingStatus(clt.second, datasetID, it->second, DATASET_LOADING_STATUS_DONE);
+                INFO << "VTK Dataset " << dataset.name << " loaded in "
+                     << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - build->loadStart).count() << " ms ("
+                     << build->nbTimesteps << " timesteps)" << std::endl;
+            }
+            else
+            {
+                for(auto clt : m_clientTable)
+                    sendDatasetLoadingStatus(clt.second, datasetID, it->second, DATASET_LOADING_STATUS_FAILED);
+            }
+            m_loadingDatasets.erase(it);
+        };
+
+        source->subscribe(onTimestep, onFinish);
+    }
+
+    VTKDataset* VFVServer::createVTKDataset(uint32_t datasetID, const VFVVTKDatasetInformation& dataset, std::shared_ptr<VTKParser> parser,
+                                            std::shared_ptr<VFVVTKSource> source, std::shared_ptr<VFVValuesMutex>* valuesMutex)
+    {
+        //Determine VTKFieldValues to use
+        std::vector<const VTKFieldValue*> ptFieldValues;
+        std::vector<const VTKFieldValue*> cellFieldValues;
+        if(!getVTKFieldValues(*parser, dataset, ptFieldValues, cellFieldValues))
+            return NULL;
+
+        INFO << "Opening VTK Dataset " << dataset.name << std::endl;
+
+        //Create the dataset
+        VTKDataset* vtk = new VTKDataset(parser, ptFieldValues, cellFieldValues);
 
         VTKMetaData metaData;
         metaData.dataset = vtk;
         metaData.name    = dataset.name;
         metaData.ptFieldValueIndices   = dataset.ptFields;
         metaData.cellFieldValueIndices = dataset.cellFields;
+        metaData.datasetID             = datasetID;
+        metaData.source                = source;
 
         for(uint32_t i = 0; i < vtk->getNbSubDatasets(); i++)
         {
             SubDatasetMetaData md;
-            md.sdID   = vtk->getSubDatasets()[i]->getID();
+            md.sdID      = vtk->getSubDatasets()[i]->getID();
+            md.datasetID = datasetID;
 
             SubDatasetTFMetaData* tfMD = new SubDatasetTFMetaData(TF_TRIANGULAR_GTF, std::make_shared<TriangularGTF>(dataset.ptFields.size()+1, RAINBOW));
             md.tf     = std::shared_ptr<SubDatasetTFMetaData>(tfMD);
@@ -1089,24 +1412,32 @@ endFor:;
             metaData.sdMetaData.push_back(md);
         }
 
-        //Add it to the list
+        //Add the dataset to the list and send it to the clients
+        *valuesMutex = metaData.valuesMutex;
         {
-            std::lock_guard<std::mutex> lock(m_datasetMutex);
-            metaData.datasetID = m_currentDataset;
-            for(auto& it : metaData.sdMetaData)
-                it.datasetID = m_currentDataset;
-            m_vtkDatasets.insert(std::pair<uint32_t, VTKMetaData>(m_currentDataset, metaData));
-            m_datasets.insert(std::pair<uint32_t, VTKDataset*>(m_currentDataset, vtk));
-            m_currentDataset++;
-        }
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+
+            //Update the position
+            for(uint32_t i = 0; i < vtk->getNbSubDatasets(); i++, m_currentSubDataset++)
+            {
+                SubDataset* sd = vtk->getSubDatasets()[i];
+                sd->setPosition(glm::vec3(m_currentSubDataset*2.0f, 0.0f, 0.0f));
+                sd->setScale(glm::vec3(0.5f, 0.5f, 0.5f));
+            }
+
+            auto itMetaData = m_vtkDatasets.insert(std::pair<uint32_t, VTKMetaData>(datasetID, metaData)).first;
+            registerDataset(datasetID, vtk, DATASET_TYPE_VTK, &itMetaData->second);
+
+            VFVDatasetLoading& loading = m_loadingDatasets[datasetID];
+            loading.nbLoadedTimesteps  = 1;
+            loading.nbTimesteps        = source->getNbTimesteps();
 
-        //Send it to the other clients
-        {
-            std::lock_guard<std::mutex> lock2(m_mapMutex);
             for(auto clt : m_clientTable)
             {
-                sendAddVTKDatasetEvent(clt.second, dataset, metaData.datasetID);
-                sendDatasetStatus(clt.second, vtk, metaData.datasetID);
+                sendAddVTKDatasetEvent(clt.second, dataset, datasetID);
+                sendDatasetStatus(clt.second, vtk, datasetID);
+                sendDatasetLoadingStatus(clt.second, datasetID, loading, DATASET_LOADING_STATUS_LOADING);
             }
         }
 
@@ -1115,83 +1446,245 @@ endFor:;
            vtk->getPtFieldValues().size() != 0)
         {
             VFVAddSubDataset addSubDataset;
-            addSubDataset.datasetID = metaData.datasetID;
+            addSubDataset.datasetID = datasetID;
             onAddSubDataset(NULL, addSubDataset);
         }
+
+        return vtk;
+    }
+
+    std::shared_ptr<VFVVTKSource> VFVServer::getVTKSource(const VFVVTKDatasetInformation& dataset, bool& owner)
+    {
+        std::lock_guard<std::mutex> lock(m_vtkSourcesMutex);
+        std::weak_ptr<VFVVTKSource>& entry = m_vtkSources[VFVVTKSourceKey(dataset.name, dataset.ptFields, dataset.cellFields)];
+        std::shared_ptr<VFVVTKSource> source = entry.lock();
+
+        owner = (source == nullptr);
+        if(owner)
+        {
+            source = std::make_shared<VFVVTKSource>();
+            entry  = source;
+        }
+        return source;
+    }
+
+    void VFVServer::removeVTKSource(const VFVVTKDatasetInformation& dataset)
+    {
+        std::lock_guard<std::mutex> lock(m_vtkSourcesMutex);
+        m_vtkSources.erase(VFVVTKSourceKey(dataset.name, dataset.ptFields, dataset.cellFields));
     }
 
-    void VFVServer::addCloudPointDataset(VFVClientSocket* client, const VFVCloudPointDatasetInformation& dataset)
+    void VFVServer::addCloudPointDataset(VFVClientSocket* client, const VFVCloudPointDatasetInformation& dataset, bool async)
     {
         if(client != NULL && !client->isTablet())
         {
-            std::lock_guard<std::mutex> lock(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
             VFVSERVER_NOT_A_TABLET
             return;
         }
 
-        CloudPointDataset* cloudPoint = new CloudPointDataset(DATASET_DIRECTORY+dataset.name);
+        //Reserve the dataset ID and tell everyone that it is being loaded
+        uint32_t datasetID;
+        {
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+            datasetID = m_currentDataset++;
+
+            VFVDatasetLoading& loading = m_loadingDatasets[datasetID];
+            loading.name        = dataset.name;
+            loading.nbTimesteps = 1;
+            for(auto clt : m_clientTable)
+                sendDatasetLoadingStatus(clt.second, datasetID, loading, DATASET_LOADING_STATUS_LOADING);
+        }
 
-        //We do need to load t at this stage
-        std::thread* t = cloudPoint->loadValues(NULL, NULL);
-        if(t && t->joinable()) 
-            t->join();
+        //Read the file without blocking the client's thread. Do not hold any lock here: pushHeavy may wait for room in the queue
+        if(async && pushHeavy([this, datasetID, dataset]() {loadCloudPointDataset(datasetID, dataset);}, TASK_PRIORITY_LOW))
+            return;
+        loadCloudPointDataset(datasetID, dataset);
+    }
 
-        //Update the position
-        for(uint32_t i = 0; i < cloudPoint->getNbSubDatasets(); i++, m_currentSubDataset++)
+    void VFVServer::loadCloudPointDataset(uint32_t datasetID, const VFVCloudPointDatasetInformation& dataset)
+    {
+        std::shared_ptr<VFVCloudPointLoad> load = std::make_shared<VFVCloudPointLoad>();
+        load->server    = this;
+        load->datasetID = datasetID;
+        load->name      = dataset.name;
+
+        //Read a decimated copy of the positions ourselves for the live previews: the library gives its positions only once every value is loaded
+        std::shared_ptr<VFVPointCloud>  subset       = std::make_shared<VFVPointCloud>();
+        std::shared_ptr<VFVPointOctree> subsetOctree = std::make_shared<VFVPointOctree>();
+        uint32_t stride = 0;
+        VFVCloudPointReader reader;
+        if(reader.open(DATASET_DIRECTORY+dataset.name))
+            stride = reader.readDecimatedPositions(SELECTION_PREVIEW_MAX_POINTS, *subset);
+        if(stride == 0)
+            WARNING << "Cloud point dataset " << dataset.name << ": no preview of the positions until the library loads them" << std::endl;
+        else
         {
-            SubDataset* sd = cloudPoint->getSubDatasets()[i];
-            sd->setPosition(glm::vec3(m_currentSubDataset*2.0f, 0.0f, 0.0f));
-            sd->setScale(glm::vec3(0.5f, 0.5f, 0.5f));
+            subsetOctree->build(*subset);
+            load->hasPreview = true;
         }
 
+        load->cloudPoint = new CloudPointDataset(DATASET_DIRECTORY+dataset.name);
+        CloudPointDataset* cloudPoint = load->cloudPoint;
+
         CloudPointMetaData metaData;
-        metaData.dataset = cloudPoint;
-        metaData.name    = dataset.name;
+        metaData.dataset   = cloudPoint;
+        metaData.name      = dataset.name;
+        metaData.datasetID = datasetID;
+        if(load->hasPreview)
+        {
+            metaData.points      = subset;
+            metaData.pointOctree = subsetOctree;
+            metaData.pointStride = stride;
+            metaData.nbPoints    = reader.getNbPoints();
+        }
 
         for(uint32_t i = 0; i < cloudPoint->getNbSubDatasets(); i++)
         {
             SubDatasetMetaData md;
-            md.sdID   = cloudPoint->getSubDatasets()[i]->getID();
+            md.sdID      = cloudPoint->getSubDatasets()[i]->getID();
+            md.datasetID = datasetID;
             SubDatasetTFMetaData* tfMD = new SubDatasetTFMetaData(TF_GTF, std::make_shared<GTF>(1, RAINBOW));
             md.tf     = std::shared_ptr<SubDatasetTFMetaData>(tfMD);
             cloudPoint->getSubDatasets()[i]->setTransferFunction(md.tf->getTF());
             metaData.sdMetaData.push_back(md);
         }
 
-        //Add it to the list
+        //The values are pending while the library loads them: keep them locked meanwhile. finishCloudPointDataset unlocks them from the completion callback.
+        //The functions needing them wait for them, or retry once they are free (see deferUntilValuesFree)
+        load->valuesMutex = metaData.valuesMutex;
+        load->valuesMutex->lock();
+
+        //Add it to the list and tell the clients at once: they open the file on their side meanwhile
         {
-            std::lock_guard<std::mutex> lock(m_datasetMutex);
-            metaData.datasetID = m_currentDataset;
-            for(auto& it : metaData.sdMetaData)
-                it.datasetID = m_currentDataset;
-            m_cloudPointDatasets.insert(std::pair<uint32_t, CloudPointMetaData>(m_currentDataset, metaData));
-            m_datasets.insert(std::pair<uint32_t, CloudPointDataset*>(m_currentDataset, cloudPoint));
-            m_currentDataset++;
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+
+            //Update the position
+            for(uint32_t i = 0; i < cloudPoint->getNbSubDatasets(); i++, m_currentSubDataset++)
+            {
+                SubDataset* sd = cloudPoint->getSubDatasets()[i];
+                sd->setPosition(glm::vec3(m_currentSubDataset*2.0f, 0.0f, 0.0f));
+                sd->setScale(glm::vec3(0.5f, 0.5f, 0.5f));
+            }
+
+            auto itMetaData = m_cloudPointDatasets.insert(std::pair<uint32_t, CloudPointMetaData>(datasetID, metaData)).first;
+            registerDataset(datasetID, cloudPoint, DATASET_TYPE_CLOUD_POINT, &itMetaData->second);
+
+            for(auto clt : m_clientTable)
+                sendAddCloudPointDatasetEvent(clt.second, dataset, datasetID);
         }
+        INFO << "Cloud point dataset " << dataset.name << " published in "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - load->loadStart).count() << " ms" << std::endl;
 
-        //Send it to the other clients
+        //The library reads the values in its own thread and calls us back once done: do not hold this compute thread meanwhile.
+        //The callback owns a reference to the load state, released once it ran
+        std::thread* t = cloudPoint->loadValues([](Dataset*, uint32_t, void* data)
         {
-            std::lock_guard<std::mutex> lock2(m_mapMutex);
-            for(auto clt : m_clientTable)
+            std::shared_ptr<VFVCloudPointLoad>* clbkLoad = (std::shared_ptr<VFVCloudPointLoad>*)data;
+            std::shared_ptr<VFVCloudPointLoad>  ptr      = *clbkLoad;
+            delete clbkLoad;
+
+            //Build the octree over every point in the compute pool, not in the thread of the library
+            if(!ptr->server->pushHeavy([ptr]() {ptr->server->finishCloudPointDataset(ptr);}, TASK_PRIORITY_LOW))
+            {
+                //Closing: only release whoever waits for the values
+                if(!ptr->finished.exchange(true))
+                    ptr->valuesMutex->unlock();
+            }
+        }, new std::shared_ptr<VFVCloudPointLoad>(load));
+
+        if(t)
+            t->detach();
+        else //No loading thread was started: the values are as loaded as they will be
+            finishCloudPointDataset(load);
+    }
+
+    void VFVServer::finishCloudPointDataset(std::shared_ptr<VFVCloudPointLoad> load)
+    {
+        if(load->finished.exchange(true))
+            return;
+
+        //The selections now work on the positions the library loaded, without copying them.
+        //Building the octree over every point takes a while: meanwhile, the live previews keep using the decimated copy of at most SELECTION_PREVIEW_MAX_POINTS points
+        CloudPointDataset* cloudPoint = load->cloudPoint;
+        std::shared_ptr<VFVPointCloud>  points = std::make_shared<VFVPointCloud>(cloudPoint->getPointPositions(), cloudPoint->getNbPoints());
+        std::shared_ptr<VFVPointOctree> octree = std::make_shared<VFVPointOctree>();
+        {
+            //The file could not be read before the library: decimate the positions it loaded instead
+            std::shared_ptr<VFVPointCloud>  subset       = NULL;
+            std::shared_ptr<VFVPointOctree> subsetOctree = NULL;
+            uint32_t stride = 1;
+            if(!load->hasPreview)
+            {
+                subset = points;
+                if(points->size() > SELECTION_PREVIEW_MAX_POINTS)
+                {
+                    subset = std::make_shared<VFVPointCloud>();
+                    stride = points->decimate(SELECTION_PREVIEW_MAX_POINTS, *subset);
+                }
+                subsetOctree = (stride == 1 ? octree : std::make_shared<VFVPointOctree>());
+                subsetOctree->build(*subset);
+            }
+
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+            auto it = m_cloudPointDatasets.find(load->datasetID);
+            if(subset)
             {
-                sendAddCloudPointDatasetEvent(clt.second, dataset, metaData.datasetID);
-                sendDatasetStatus(clt.second, cloudPoint, metaData.datasetID);
+                it->second.points      = subset;
+                it->second.pointOctree = subsetOctree;
+                it->second.pointStride = stride;
             }
+            it->second.nbPoints = points->size();
+
+            //The values are loaded
+            load->valuesMutex->unlock();
+            for(auto clt : m_clientTable)
+                sendDatasetStatus(clt.second, cloudPoint, load->datasetID);
         }
+        INFO << "Cloud point dataset " << load->name << " usable in "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - load->loadStart).count() << " ms" << std::endl;
 
         //Add a SubDataset if no one is registered yet
         if(cloudPoint->getNbSubDatasets() == 0)
         {
             VFVAddSubDataset addSubDataset;
-            addSubDataset.datasetID = metaData.datasetID;
+            addSubDataset.datasetID = load->datasetID;
             onAddSubDataset(NULL, addSubDataset);
         }
+
+        //Build the octree over every point. It replaces the decimated copy: the previews started from now on use it
+        if(octree->getNodes().empty() && points->size() > 0)
+        {
+            octree->build(*points);
+            INFO << "Cloud point dataset " << load->name << ": octree of " << octree->getNodes().size() << " nodes over " << points->size() << " points" << std::endl;
+
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            auto it = m_cloudPointDatasets.find(load->datasetID);
+            it->second.points      = points;
+            it->second.pointOctree = octree;
+            it->second.pointStride = 1;
+        }
+
+        {
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
+            auto it = m_loadingDatasets.find(load->datasetID);
+            it->second.nbLoadedTimesteps = 1;
+            for(auto clt : m_clientTable)
+                sendDatasetLoadingStatus(clt.second, load->datasetID, it->second, DATASET_LOADING_STATUS_DONE);
+            m_loadingDatasets.erase(it);
+        }
+        INFO << "Cloud point dataset " << load->name << " loaded in "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - load->loadStart).count() << " ms" << std::endl;
     }
 
     SubDataset* VFVServer::onAddSubDataset(VFVClientSocket* client, const VFVAddSubDataset& dataset)
     {
         INFO << "OnAddSubDataset" << std::endl;
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
         auto it = m_datasets.find(dataset.datasetID);
         if(it == m_datasets.end())
         {
@@ -1220,7 +1713,7 @@ endFor:;
         sd->setTransferFunction(md.tf->getTF());
         mt->sdMetaData.push_back(md);
 
-        std::lock_guard<std::mutex> lock2(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
         for(auto& clt : m_clientTable)
         {
             sendAddSubDataset(clt.second, sd);
@@ -1230,7 +1723,7 @@ endFor:;
         return sd;
     }
 
-    void VFVServer::removeSubDataset(const VFVRemoveSubDataset& remove)
+    void VFVServer::removeSubDataset(const VFVRemoveSubDataset& remove, bool valuesLocked)
     {
         Dataset* dataset = getDataset(remove.datasetID, remove.subDatasetID);
         if(dataset == NULL)
@@ -1239,6 +1732,25 @@ endFor:;
             return;
         }
 
+        //A computation (e.g., a volumetric selection) may be using this dataset's values: do not wait for it while holding the global locks.
+        //Cancel the selection of this SubDataset, and retry once the values are free
+        std::unique_lock<VFVValuesMutex> lockValues;
+        if(!valuesLocked)
+        {
+            lockValues = std::unique_lock<VFVValuesMutex>(*getDatasetValuesMutex(remove.datasetID), std::try_to_lock);
+            if(!lockValues.owns_lock())
+            {
+                {
+                    std::lock_guard<std::mutex> lockJobs(m_selectionJobsMutex);
+                    auto itJob = m_selectionJobs.find(std::make_pair((uint32_t)remove.datasetID, (uint32_t)remove.subDatasetID));
+                    if(itJob != m_selectionJobs.end())
+                        itJob->second->cancelled = true;
+                }
+                deferUntilValuesFree([this, remove]() {removeSubDataset(remove);});
+                return;
+            }
+        }
+
         SubDatasetMetaData* sdMT = nullptr;
         SubDataset* sd = dataset->getSubDataset(remove.subDatasetID);
         DatasetMetaData* mtData = getMetaData(remove.datasetID, remove.subDatasetID, &sdMT);
@@ -1248,21 +1760,14 @@ endFor:;
             return;
         }
 
-        for(auto it = mtData->sdMetaData.begin(); it != mtData->sdMetaData.end();)
-        {
-            if(it->datasetID == remove.datasetID && it->sdID == remove.subDatasetID)
-            {
-                it = mtData->sdMetaData.erase(it);
-                break;
-            }
-            else
-                it++;
-        }
+        //sdMT is destroyed by the erase: keep what is needed afterwards
+        int32_t sdgID = sdMT->sdgID;
+        mtData->sdMetaData.erase(mtData->sdMetaData.find(remove.subDatasetID));
 
         //There might be extra steps on removing a subdataset based on its group
-        if(sdMT->sdgID != -1)
+        if(sdgID != -1)
         {
-            auto sdgIT = m_sdGroups.find(sdMT->sdgID);
+            auto sdgIT = m_sdGroups.find(sdgID);
             if(sdgIT == m_sdGroups.end())
             {
                 ERROR << "The Subdataset is registered as having a subdatasetgroup, but the subdataset group meta data is unavailable" << std::endl;
@@ -1287,7 +1792,6 @@ endFor:;
                     auto subjViews = svg->getLinkedSubDataset(sd);
                     if(subjViews.first != nullptr && subjViews.second != nullptr)
                     {
-                        sdMT->sdgID = -1;
                         svg->removeSubDataset(sd); //This removes the counter part as well
 
                         SubDataset* counterPart = subjViews.first;
@@ -1301,7 +1805,7 @@ endFor:;
 
                         VFVRemoveSubDataset removeCounter = remove;
                         removeCounter.subDatasetID = counterPart->getID();
-                        removeSubDataset(removeCounter);
+                        removeSubDataset(removeCounter, true);
                     }
                 }
             }
@@ -1323,7 +1827,7 @@ endFor:;
     {
         if(client != NULL && !client->isTablet())
         {
-            std::lock_guard<std::mutex> lock(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
             VFVSERVER_NOT_A_TABLET
             return;
         }
@@ -1331,11 +1835,17 @@ endFor:;
         client->getTabletData().volSelMethod = (VolumetricSelectionMethod)method.method;
     }
 
+    void VFVServer::onClientFeatures(VFVClientSocket* client, const VFVClientFeatures& features)
+    {
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
+        client->setFeatures(features.features);
+    }
+
     void VFVServer::addLogData(VFVClientSocket* client, const VFVOpenLogData& logData)
     {
         if(client != NULL && !client->isTablet())
         {
-            std::lock_guard<std::mutex> lock(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
             VFVSERVER_NOT_A_TABLET
             return;
         }
@@ -1369,7 +1879,7 @@ endFor:;
         metaData.logData = annot;
         metaData.name    = logData.fileName;
         {
-            std::lock_guard<std::mutex> lock(m_datasetMutex);
+            VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
             metaData.logID = m_currentLogData;
             m_logData.emplace(std::make_pair(metaData.logID, metaData));
             m_currentLogData++;
@@ -1377,7 +1887,7 @@ endFor:;
 
         //Send it to all clients
         {
-            std::lock_guard<std::mutex> lock2(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
             for(auto clt : m_clientTable)
                 sendAddLogData(clt.second, logData, metaData.logID);
         }
@@ -1387,13 +1897,13 @@ endFor:;
     {
         if(client != NULL && !client->isTablet())
         {
-            std::lock_guard<std::mutex> lock(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
             VFVSERVER_NOT_A_TABLET
             return;
         }
 
         //Search for the AnnotationLog object
-        std::lock_guard<std::mutex> dataLock(m_datasetMutex);
+        VFVTimedLockGuard<std::shared_mutex> dataLock(m_datasetMutex, m_datasetLockStats);
         auto it = m_logData.find(pos.annotLogID);
         if(it == m_logData.end())
         {
@@ -1405,7 +1915,7 @@ endFor:;
 
         //Send it to all clients
         {
-            std::lock_guard<std::mutex> lock2(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
             for(auto clt : m_clientTable)
             {
                 sendAddAnnotationPositionData(clt.second, posMT);
@@ -1419,13 +1929,13 @@ endFor:;
         //Check if the client is valid
         if(client != NULL && !client->isTablet())
         {
-            std::lock_guard<std::mutex> lock(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
             VFVSERVER_NOT_A_TABLET
             return;
         }
 
         //Search for the SD
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
         SubDatasetMetaData* sdMT;
         getMetaData(pos.datasetID, pos.sdID, &sdMT);
         if(sdMT == NULL)
@@ -1449,7 +1959,7 @@ endFor:;
         drawable->drawable     = std::make_shared<DrawableAnnotationPosition>(annot->logData, posIT->component);
         sdMT->pushDrawableAnnotationPosition(drawable);
         {
-            std::lock_guard<std::mutex> lock2(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
             for(auto it : m_clientTable)
                 sendAddAnnotationPositionToSD(it.second, *sdMT, *(drawable.get()));
         }
@@ -1460,7 +1970,7 @@ endFor:;
         //Check if the client is valid
         if(client != NULL && !client->isTablet())
         {
-            std::lock_guard<std::mutex> lock(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
             VFVSERVER_NOT_A_TABLET
             return;
         }
@@ -1477,7 +1987,7 @@ endFor:;
 
         //Send it to all clients
         {
-            std::lock_guard<std::mutex> lock2(m_mapMutex);
+            VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
             for(auto clt : m_clientTable)
                 sendSetAnnotationPositionIndexes(clt.second, *posIT);
         }
@@ -1485,8 +1995,8 @@ endFor:;
 
     void VFVServer::onMakeSubDatasetPublic(VFVClientSocket* client, const VFVMakeSubDatasetPublic& makePublic)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         if(client)
         {
@@ -1517,8 +2027,8 @@ endFor:;
 
     void VFVServer::onDuplicateSubDataset(VFVClientSocket* client, const VFVDuplicateSubDataset& duplicate)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
         duplicateSubDataset(client, duplicate);
     }
 
@@ -1582,8 +2092,8 @@ endFor:;
 
     void VFVServer::onMergeSubDatasets(VFVClientSocket* client, const VFVMergeSubDatasets& merge)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         INFO << "On Merge SubDatasets IDs " << merge.sd1ID << " : " << merge.sd2ID << std::endl;
 
@@ -1673,7 +2183,7 @@ endFor:;
 
     void VFVServer::onLocation(VFVClientSocket* client, const VFVLocation& location)
     {
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
         VFVClientSocket* headset = getHeadsetFromClient(client);
 
         if(headset)
@@ -1686,39 +2196,22 @@ endFor:;
                         glm::vec3(location.position[0], location.position[1], location.position[2]),
                         Quaternionf(location.rotation[1], location.rotation[2], location.rotation[3], location.rotation[0])
                     });
+                updateSelectionPreview(headset);
             }
 
             //Generate the data
-            uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(float) + 4*sizeof(float);
-            uint8_t* data = (uint8_t*)malloc(dataSize);
-            uint32_t offset = 0;
-
-            //Message ID
-            writeUint16(data, VFV_SEND_TABLET_LOCATION);
-            offset += sizeof(uint16_t);
+            VFVMessageBuilder msg(m_bufferPool, VFV_SEND_TABLET_LOCATION, 3*sizeof(float) + 4*sizeof(float));
 
             //Position
-            writeFloat(data+offset, location.position[0]);
-            offset += sizeof(float);
-            writeFloat(data+offset, location.position[1]);
-            offset += sizeof(float);
-            writeFloat(data+offset, location.position[2]);
-            offset += sizeof(float);
+            for(uint32_t i = 0; i < 3; i++)
+                msg.pushFloat(location.position[i]);
 
             //Rotation
-            writeFloat(data+offset, location.rotation[0]);
-            offset += sizeof(float);
-            writeFloat(data+offset, location.rotation[1]);
-            offset += sizeof(float);
-            writeFloat(data+offset, location.rotation[2]);
-            offset += sizeof(float);
-            writeFloat(data+offset, location.rotation[3]);
-            offset += sizeof(float);
-
-            std::shared_ptr<uint8_t> sharedData(data, free);
+            for(uint32_t i = 0; i < 4; i++)
+                msg.pushFloat(location.rotation[i]);
 
             //Send the data
-            SocketMessage<int> sm(headset->socket, sharedData, offset);
+            SocketMessage<int> sm(headset->socket, msg.getData(), msg.getSize());
             writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -1741,31 +2234,16 @@ endFor:;
         {
             headset->getHeadsetData().volumetricData.lassoScale = glm::vec3(tabletScale.scale * tabletScale.width/2.0f, tabletScale.scale, tabletScale.scale * tabletScale.height/2.0f);
 
-            //Generate the data
-            uint32_t dataSize = sizeof(uint16_t) + 5*sizeof(float);
-            uint8_t* data = (uint8_t*)malloc(dataSize);
-            uint32_t offset = 0;
-
-            //Message ID
-            writeUint16(data, VFV_SEND_TABLET_SCALE);
-            offset += sizeof(uint16_t);
-
-            //Scale information
-            writeFloat(data+offset, tabletScale.scale);
-            offset += sizeof(float);
-            writeFloat(data+offset, tabletScale.width);
-            offset += sizeof(float);
-            writeFloat(data+offset, tabletScale.height);
-            offset += sizeof(float);
-            writeFloat(data+offset, tabletScale.posx);
-            offset += sizeof(float);
-            writeFloat(data+offset, tabletScale.posy);
-            offset += sizeof(float);
-
-            std::shared_ptr<uint8_t> sharedData(data, free);
+            //Generate the data (scale information)
+            VFVMessageBuilder msg(m_bufferPool, VFV_SEND_TABLET_SCALE, 5*sizeof(float));
+            msg.pushFloat(tabletScale.scale)
+               .pushFloat(tabletScale.width)
+               .pushFloat(tabletScale.height)
+               .pushFloat(tabletScale.posx)
+               .pushFloat(tabletScale.posy);
 
             //Send the data
-            SocketMessage<int> sm(headset->socket, sharedData, offset);
+            SocketMessage<int> sm(headset->socket, msg.getData(), msg.getSize());
             writeMessage(sm);
         }
     }
@@ -1776,7 +2254,7 @@ endFor:;
         if(lasso.size % 3 != 0)
             WARNING << "The lasso is not valid. Assert fail: lasso.size % 3 == 0" << std::endl;
          
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
         VFVClientSocket* headset = getHeadsetFromClient(client);
         if(headset)
         {
@@ -1786,29 +2264,17 @@ endFor:;
                 headset->getHeadsetData().volumetricData.lasso.push_back(glm::vec2(lasso.data[i], lasso.data[i+1])); 
 
             //And send it to the headset
-            uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t) + lasso.size * sizeof(float);
-            uint8_t* data = (uint8_t*)malloc(dataSize);
-            uint32_t offset = 0;
-
-            //Message ID
-            writeUint16(data, VFV_SEND_LASSO);
-            offset += sizeof(uint16_t);
+            VFVMessageBuilder msg(m_bufferPool, VFV_SEND_LASSO, sizeof(uint32_t) + lasso.size * sizeof(float));
 
             //Size
-            writeUint32(data+offset, lasso.size);
-            offset += sizeof(uint32_t);
+            msg.pushUint32(lasso.size);
 
             //Lasso data
             for(uint32_t i = 0; i < lasso.size; i++)
-            {
-                writeFloat(data+offset, lasso.data[i]);
-                offset += sizeof(float);
-            }
-
-            std::shared_ptr<uint8_t> sharedData(data, free);
+                msg.pushFloat(lasso.data[i]);
 
             //Send the data
-            SocketMessage<int> sm(headset->socket, sharedData, offset);
+            SocketMessage<int> sm(headset->socket, msg.getData(), msg.getSize());
             writeMessage(sm);
         }
     }
@@ -1816,16 +2282,19 @@ endFor:;
     void VFVServer::onConfirmSelection(VFVClientSocket* client, const VFVConfirmSelection& confirmSelection)
     {
         INFO << "Selection confirmed" << std::endl;
-                
-        std::lock_guard<std::mutex> lockDataset(m_datasetMutex);
-        std::lock_guard<std::mutex> lock(m_mapMutex);
 
-        VFVClientSocket* headset = getHeadsetFromClient(client);
-        if(headset)
+        std::shared_ptr<VFVSelectionJob> job = std::make_shared<VFVSelectionJob>();
+        job->datasetID    = confirmSelection.datasetID;
+        job->subDatasetID = confirmSelection.subDatasetID;
+
         {
-            /*----------------------------------------------------------------------------*/
-            /*-----------------------Apply the volumetric selection-----------------------*/
-            /*----------------------------------------------------------------------------*/
+            VFVTimedSharedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetSharedLockStats);
+            VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
+
+            VFVClientSocket* headset = getHeadsetFromClient(client);
+            if(!headset)
+                return;
+
             headset->getHeadsetData().volumetricData.closeCurrentMesh();
 
             //Get the subdataset and the associated dataset
@@ -1835,75 +2304,366 @@ endFor:;
                 VFVSERVER_SUB_DATASET_NOT_FOUND(confirmSelection.datasetID, confirmSelection.subDatasetID)
                 return;
             }
-            SubDataset* sd = dataset->getSubDataset(confirmSelection.subDatasetID);
 
             //Get the type of the dataset
-            void(*applyFunc)(const VolumetricMesh&, SubDataset*) = nullptr;
             switch(getDatasetType(dataset))
             {
                 case DATASET_TYPE_VTK:
-                    applyFunc = &applyVolumetricSelection_vtk;
+                    job->applyFunc = &applyVolumetricSelection_vtk;
                     break;
 
                 case DATASET_TYPE_CLOUD_POINT:
-                    applyFunc = &applyVolumetricSelection_cloudPoint;
+                {
+                    job->applyFunc = &applyVolumetricSelection_cloudPoint;
+
+                    //Test the points ourselves once every position is available (see finishCloudPointDataset).
+                    //Snapshot the SubDataset transformation the meshes are drawn against
+                    auto itCloudPoint = m_cloudPointDatasets.find(confirmSelection.datasetID);
+                    if(itCloudPoint != m_cloudPointDatasets.end() && itCloudPoint->second.points != NULL && itCloudPoint->second.pointStride == 1)
+                    {
+                        SubDataset* sd   = dataset->getSubDataset(confirmSelection.subDatasetID);
+                        job->points      = itCloudPoint->second.points;
+                        job->pointOctree = itCloudPoint->second.pointOctree;
+                        job->position    = sd->getPosition();
+                        job->invRotation = sd->getGlobalRotate().getInverse();
+                        job->scale       = sd->getScale();
+                    }
                     break;
+                }
 
                 default:
                     break;
             }
 
-            //Apply the correct function
-            for(auto& mesh : headset->getHeadsetData().volumetricData.meshes)
-                applyFunc(mesh, sd);
+            if(job->applyFunc == nullptr)
+            {
+                WARNING << "Cannot apply a volumetric selection on the dataset ID " << confirmSelection.datasetID << std::endl;
+                return;
+            }
 
-            sd->enableVolumetricMask(true);
+            //Snapshot the meshes: the headset can start a new selection while this one is computed
+            job->headset = headset;
+            job->meshes  = headset->getHeadsetData().volumetricData.meshes;
 
-            /*----------------------------------------------------------------------------*/
-            /*---------------------Send the confirm selection message---------------------*/
-            /*----------------------------------------------------------------------------*/
-            uint32_t dataSize = sizeof(uint16_t) + 2*sizeof(uint32_t);
-            uint8_t* data = (uint8_t*)malloc(dataSize);
-            size_t offset = 0;
+            //Hand the live preview over to the job if it covers the same meshes (its pending slices are processed by the job).
+            //The headset gets a new preview: the meshes it extrudes from now on must not alter this one
+            auto itPreview = m_selectionPreviews.find(headset);
+            if(itPreview != m_selectionPreviews.end() && itPreview->second.datasetID == job->datasetID && itPreview->second.subDatasetID == job->subDatasetID &&
+               itPreview->second.preview->getNbMeshes() == job->meshes.size())
+            {
+                VFVSelectionPreviewState& state = itPreview->second;
+                job->preview   = state.preview;
+                state.preview  = std::make_shared<VFVSelectionPreview>(job->preview->getPoints(), job->preview->getOctree(),
+                                                                      job->preview->getPointStride(), job->preview->getNbDatasetPoints());
+                state.nbSlices = 0;
+            }
 
-            //Message ID
-            writeUint16(data, VFV_SEND_CONFIRM_SELECTION);
-            offset += sizeof(uint16_t);
-            
-            //DatasetID
-            writeUint32(data+offset, confirmSelection.datasetID);
-            offset += sizeof(uint32_t);
+            {
+                std::lock_guard<std::mutex> lockJobs(m_selectionJobsMutex);
+                auto key = std::make_pair(job->datasetID, job->subDatasetID);
+                if(m_selectionJobs.find(key) != m_selectionJobs.end())
+                {
+                    WARNING << "A volumetric selection is already being computed on the SubDataset " << job->datasetID << ":" << job->subDatasetID << std::endl;
+                    sendMessageToDisplay(client, "A selection is already being computed on this dataset");
+                    return;
+                }
+                m_selectionJobs[key] = job;
+            }
 
-            //SubDatasetID
-            writeUint32(data+offset, confirmSelection.subDatasetID);
-            offset += sizeof(uint32_t);
+            sendSelectionProgress(*job, SELECTION_STATUS_RUNNING);
+        }
 
-            std::shared_ptr<uint8_t> sharedData(data, free);
+        //Compute the selection in the compute pool. Do not hold any lock here: pushHeavy may wait for room in the queue
+        if(!pushHeavy([this, job]() {runSelectionJob(job);}, TASK_PRIORITY_HIGH))
+        {
+            std::lock_guard<std::mutex> lockJobs(m_selectionJobsMutex);
+            m_selectionJobs.erase(std::make_pair(job->datasetID, job->subDatasetID));
+        }
+    }
+
+    void VFVServer::runSelectionJob(std::shared_ptr<VFVSelectionJob> job)
+    {
+        /*----------------------------------------------------------------------------*/
+        /*-----------------------Apply the volumetric selection-----------------------*/
+        /*----------------------------------------------------------------------------*/
+
+        //Datasets are never removed: their values mutex stays valid
+        std::shared_ptr<VFVValuesMutex> valuesMutex;
+        {
+            VFVTimedSharedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetSharedLockStats);
+            valuesMutex = getDatasetValuesMutex(job->datasetID);
+        }
+
+        if(valuesMutex)
+        {
+            //Another computation may hold the values for long: wait for them without holding the global locks (see the mutex order)
+            std::unique_lock<VFVValuesMutex> lockValues(*valuesMutex);
+
+            //The SubDataset (and its meta data) cannot be removed while its dataset values are locked (see removeSubDataset)
+            SubDataset*         sd   = NULL;
+            SubDatasetMetaData* sdMT = NULL;
+            {
+                VFVTimedSharedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetSharedLockStats);
+                VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
+                Dataset* dataset = getDataset(job->datasetID, job->subDatasetID);
+                if(dataset != NULL)
+                {
+                    sd = dataset->getSubDataset(job->subDatasetID);
+                    getMetaData(job->datasetID, job->subDatasetID, &sdMT);
+                }
+            }
+
+            if(sd != NULL && sdMT != NULL)
+            {
+                //Keep the selection made so far: a cancelled job restores it
+                std::vector<uint8_t> maskSnapshot(sd->getVolumetricMask(), sd->getVolumetricMask() + sd->getVolumetricMaskSize());
+                bool                 maskEnabled = sd->isVolumetricMaskEnabled();
+
+                //The live preview already tested most of the points: finish it and apply it at once
+                bool applied = false;
+                if(job->preview && !job->cancelled)
+                {
+                    job->preview->processPending();
+                    if(job->preview->getPointStride() == 1 && sd->getVolumetricMaskSize() == job->preview->getNbPoints())
+                    {
+                        job->preview->applyOnMask(sd->getVolumetricMask());
+                        sdMT->volumetricMaskBricks.markAllDirty();
+                        job->nbMeshesDone = job->meshes.size();
+                        applied = true;
+                    }
+                    else
+                        WARNING << "The selection preview does not match the SubDataset " << job->datasetID << ":" << job->subDatasetID << ". Recomputing it" << std::endl;
+                }
+
+                //Test the positions against the meshes expressed in the SubDataset space, in parallel.
+                //The whole chain is evaluated subtree per subtree of the octree, whose nodes the mesh surfaces do not cross are accepted or rejected at once (see evaluateSelection)
+                if(!applied && job->points && sd->getVolumetricMaskSize() == job->points->size())
+                {
+                    std::vector<VFVPointInMesh>   pointInMeshes;
+                    std::vector<VFVSelectionStep> steps;
+                    pointInMeshes.reserve(job->meshes.size());
+                    for(auto& mesh : job->meshes)
+                    {
+                        pointInMeshes.push_back(getSubDatasetPointInMesh(mesh, job->position, job->invRotation, job->scale));
+                        steps.push_back({&pointInMeshes.back(), mesh.selectionOp});
+                    }
+
+                    if(evaluateSelection(*job->points, *job->pointOctree, steps, sd->getVolumetricMask(), &m_computePool, &job->cancelled, &sdMT->volumetricMaskBricks))
+                        job->nbMeshesDone = job->meshes.size();
+                    applied = true;
+                }
+
+                for(auto& mesh : job->meshes)
+                {
+                    if(job->cancelled || applied)
+                        break;
+                    job->applyFunc(mesh, sd);
+                    sdMT->volumetricMaskBricks.markAllDirty();
+                    job->nbMeshesDone++;
+                }
+
+                //A partially applied selection is meaningless: go back to the mask as it was before this job
+                if(job->cancelled)
+                {
+                    std::copy(maskSnapshot.begin(), maskSnapshot.end(), sd->getVolumetricMask());
+                    sdMT->volumetricMaskBricks.markAllDirty();
+                    sd->enableVolumetricMask(maskEnabled);
+                }
+                else
+                    sd->enableVolumetricMask(true);
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /*-----------------------------Send the results-------------------------------*/
+        /*----------------------------------------------------------------------------*/
+        VFVTimedSharedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetSharedLockStats);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
+
+        //The job is over: the headset pointer cannot change anymore (see closeClient)
+        {
+            std::lock_guard<std::mutex> lockJobs(m_selectionJobsMutex);
+            m_selectionJobs.erase(std::make_pair(job->datasetID, job->subDatasetID));
+        }
+
+        //The SubDataset may have been removed once its dataset values got unlocked
+        Dataset* dataset = getDataset(job->datasetID, job->subDatasetID);
+        if(dataset == NULL)
+        {
+            VFVSERVER_SUB_DATASET_NOT_FOUND(job->datasetID, job->subDatasetID)
+            sendSelectionProgress(*job, SELECTION_STATUS_FAILED);
+            return;
+        }
+        SubDataset* sd = dataset->getSubDataset(job->subDatasetID);
+
+        if(job->cancelled)
+        {
+            INFO << "Volumetric selection on " << job->datasetID << ":" << job->subDatasetID << " cancelled" << std::endl;
+
+            //The mask was restored: the clients never received the partial one. Only keep the sequence numbers of the delta clients in sync
+            sendVolumetricMaskUpdate(job->datasetID, sd, NULL, false);
+            sendSelectionProgress(*job, SELECTION_STATUS_CANCELLED);
+            return;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /*---------------------Send the confirm selection message---------------------*/
+        /*----------------------------------------------------------------------------*/
+        if(job->headset)
+        {
+            VFVMessageBuilder msg(m_bufferPool, VFV_SEND_CONFIRM_SELECTION, 2*sizeof(uint32_t));
+            msg.pushUint32(job->datasetID)      //DatasetID
+               .pushUint32(job->subDatasetID);  //SubDatasetID
 
             //Send the data
-            SocketMessage<int> sm(headset->socket, sharedData, offset);
+            SocketMessage<int> sm(job->headset->socket, msg.getData(), msg.getSize());
             writeMessage(sm);
+        }
 
-            /*----------------------------------------------------------------------------*/
-            /*----------------------Send the volumetric mask as well----------------------*/
-            /*----------------------------------------------------------------------------*/
+        /*----------------------------------------------------------------------------*/
+        /*----------------------Send the volumetric mask as well----------------------*/
+        /*----------------------------------------------------------------------------*/
 
-            std::shared_ptr<uint8_t> sharedVolData = generateVolumetricMaskEvent(sd, confirmSelection.datasetID, &offset);
+        sendVolumetricMaskUpdate(job->datasetID, sd, NULL);
 
-            for(auto it : m_clientTable)
-                sendVolumetricMaskDataset(it.second, sharedVolData, offset);
+        sendSelectionProgress(*job, SELECTION_STATUS_DONE);
+    }
+
+    void VFVServer::onCancelSelection(VFVClientSocket* client, const VFVCancelSelection& cancel)
+    {
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
+        std::lock_guard<std::mutex> lockJobs(m_selectionJobsMutex);
+
+        auto it = m_selectionJobs.find(std::make_pair((uint32_t)cancel.datasetID, (uint32_t)cancel.subDatasetID));
+        if(it == m_selectionJobs.end())
+        {
+            WARNING << "No volumetric selection is being computed on the SubDataset " << cancel.datasetID << ":" << cancel.subDatasetID << std::endl;
+            return;
+        }
+
+        if(getHeadsetFromClient(client) != it->second->headset)
+        {
+            WARNING << "Only the headset which confirmed the selection (or its tablet) can cancel it" << std::endl;
+            return;
+        }
+
+        it->second->cancelled = true;
+    }
+
+    void VFVServer::onSelectionPreview(VFVClientSocket* client, const VFVSelectionPreviewRequest& request)
+    {
+        VFVTimedSharedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetSharedLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
+
+        VFVClientSocket* headset = getHeadsetFromClient(client);
+        if(!headset)
+            return;
+
+        m_selectionPreviews.erase(headset);
+        if(request.datasetID < 0 || request.subDatasetID < 0)
+            return;
+
+        Dataset* dataset = getDataset(request.datasetID, request.subDatasetID);
+        if(dataset == NULL)
+        {
+            VFVSERVER_SUB_DATASET_NOT_FOUND(request.datasetID, request.subDatasetID)
+            return;
+        }
+
+        auto itCloudPoint = m_cloudPointDatasets.find(request.datasetID);
+        if(itCloudPoint == m_cloudPointDatasets.end() || itCloudPoint->second.points == NULL)
+        {
+            WARNING << "Cannot preview a volumetric selection on the dataset ID " << request.datasetID << std::endl;
+            return;
+        }
+
+        SubDataset* sd = dataset->getSubDataset(request.subDatasetID);
+
+        VFVSelectionPreviewState& state = m_selectionPreviews[headset];
+        state.datasetID    = request.datasetID;
+        state.subDatasetID = request.subDatasetID;
+        state.preview      = std::make_shared<VFVSelectionPreview>(itCloudPoint->second.points, itCloudPoint->second.pointOctree,
+                                                                   itCloudPoint->second.pointStride, itCloudPoint->second.nbPoints);
+        state.position     = sd->getPosition();
+        state.invRotation  = sd->getGlobalRotate().getInverse();
+        state.scale        = sd->getScale();
+
+        //Catch up with the meshes already extruded
+        updateSelectionPreview(headset, true);
+    }
+
+    void VFVServer::onVolumetricMaskResync(VFVClientSocket* client, const VFVVolumetricMaskResync& resync)
+    {
+        VFVTimedSharedLockGuard<std::shared_mutex> lockDataset(m_datasetMutex, m_datasetSharedLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
+
+        Dataset* dataset = getDataset(resync.datasetID, resync.subDatasetID);
+        if(dataset == NULL)
+        {
+            VFVSERVER_SUB_DATASET_NOT_FOUND(resync.datasetID, resync.subDatasetID)
+            return;
+        }
+
+        client->getVolumetricMaskSequences().erase(std::make_pair((uint32_t)resync.datasetID, (uint32_t)resync.subDatasetID));
+        sendVolumetricMaskUpdate(resync.datasetID, dataset->getSubDataset(resync.subDatasetID), client);
+    }
+
+    void VFVServer::updateSelectionPreview(VFVClientSocket* headset, bool restart)
+    {
+        auto it = m_selectionPreviews.find(headset);
+        if(it == m_selectionPreviews.end())
+            return;
+
+        VFVSelectionPreviewState& state = it->second;
+        const std::vector<VFVTangibleBrushMesh>& meshes = headset->getHeadsetData().volumetricData.meshes;
+
+        //At most one new mesh since the last call. Otherwise (e.g., the meshes got cleared), start again
+        size_t nbMeshes = state.preview->getNbMeshes();
+        if(restart || nbMeshes > meshes.size() || nbMeshes+1 < meshes.size() ||
+           (nbMeshes > 0 && state.nbSlices > meshes[nbMeshes-1].getNbSlices()))
+        {
+            state.preview->clear();
+            state.nbSlices = 0;
+            nbMeshes       = 0;
+        }
+
+        //Finish the last mesh of the preview, then start the new one
+        VFVTangibleBrushSlice slice;
+        for(size_t i = (nbMeshes > 0 ? nbMeshes-1 : 0); i < meshes.size(); i++)
+        {
+            if(i >= nbMeshes)
+            {
+                state.preview->beginMesh(meshes[i].selectionOp);
+                state.nbSlices = 0;
+            }
+
+            for(; state.nbSlices < meshes[i].getNbSlices(); state.nbSlices++)
+            {
+                meshes[i].getSlice(state.nbSlices, slice);
+                for(glm::vec3& p : slice.points)
+                    p = (state.invRotation * (p - state.position)) / state.scale;
+                state.preview->pushSlice(std::make_shared<VFVPointInMesh>(slice));
+            }
+        }
+
+        //Do not wait for room in the compute pool while holding m_mapMutex: the update thread retries if needed
+        if(state.preview->hasPending())
+        {
+            std::shared_ptr<VFVSelectionPreview> preview = state.preview;
+            m_computePool.tryPush([preview]() {preview->processPending();}, TASK_PRIORITY_HIGH);
         }
     }
 
     void VFVServer::onAddNewSelectionInput(VFVClientSocket* client, const VFVAddNewSelectionInput& addInput)
     {
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         VFVClientSocket* headset = getHeadsetFromClient(client);
         if(!headset)
             return;
 
         headset->getHeadsetData().volumetricData.pushMesh((BooleanSelectionOp)addInput.booleanOp);
+        updateSelectionPreview(headset);
 
         //Set the current action
         sendAddNewSelectionInput(headset, addInput);
@@ -1911,8 +2671,8 @@ endFor:;
 
     void VFVServer::onToggleMapVisibility(VFVClientSocket* client, const VFVToggleMapVisibility& visibility)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         Dataset* dataset = getDataset(visibility.datasetID, visibility.subDatasetID);
         if(dataset == NULL)
@@ -1950,8 +2710,8 @@ endFor:;
 
     void VFVServer::onRemoveSubDataset(VFVClientSocket* client, const VFVRemoveSubDataset& remove)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         //Find the subdataset meta data
         SubDatasetMetaData* sdMT = NULL;
@@ -1977,8 +2737,8 @@ endFor:;
 
     void VFVServer::onRenameSubDataset(VFVClientSocket* client, const VFVRenameSubDataset& rename)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         //Find the subdataset meta data
         SubDatasetMetaData* sdMT = NULL;
@@ -2015,9 +2775,6 @@ endFor:;
 
     void VFVServer::rotateSubDataset(VFVClientSocket* client, VFVRotationInformation& rotate)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
-
         Dataset* dataset = getDataset(rotate.datasetID, rotate.subDatasetID);
         if(dataset == NULL)
         {
@@ -2060,16 +2817,11 @@ endFor:;
         }
 
         //Send to all
-        for(auto& clt : m_clientTable)
-            if(clt.second != client)
-                sendRotateDatasetEvent(clt.second, rotate);
+        broadcastMessage(generateRotateDatasetEvent(rotate), rotate, client);
     }
 
     void VFVServer::translateSubDataset(VFVClientSocket* client, VFVMoveInformation& translate)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
-
         Dataset* dataset = getDataset(translate.datasetID, translate.subDatasetID);
         if(dataset == NULL)
         {
@@ -2110,15 +2862,137 @@ endFor:;
                 translate.headsetID = headset->getHeadsetData().id;
         }
 
-        for(auto& clt : m_clientTable)
-            if(clt.second != client)
-                sendMoveDatasetEvent(clt.second, translate);
+        //Send to all
+        broadcastMessage(generateMoveDatasetEvent(translate), translate, client);
+    }
+
+    void VFVServer::queueRotateSubDataset(VFVClientSocket* client, const VFVRotationInformation& rotate)
+    {
+        std::lock_guard<std::mutex> lock(m_pendingTransformsMutex);
+        VFVPendingTransform& pending = m_pendingTransforms[std::make_pair(rotate.datasetID, rotate.subDatasetID)];
+
+        m_nbReceivedTransforms++;
+        if(pending.hasRotate)
+            m_nbCoalescedTransforms++;
+
+        pending.hasRotate    = true;
+        pending.rotateClient = client;
+        pending.rotate       = rotate;
+    }
+
+    void VFVServer::queueTranslateSubDataset(VFVClientSocket* client, const VFVMoveInformation& translate)
+    {
+        std::lock_guard<std::mutex> lock(m_pendingTransformsMutex);
+        VFVPendingTransform& pending = m_pendingTransforms[std::make_pair(translate.datasetID, translate.subDatasetID)];
+
+        m_nbReceivedTransforms++;
+        if(pending.hasMove)
+            m_nbCoalescedTransforms++;
+
+        pending.hasMove    = true;
+        pending.moveClient = client;
+        pending.move       = translate;
+    }
+
+    void VFVServer::queueScaleSubDataset(VFVClientSocket* client, const VFVScaleInformation& scale)
+    {
+        std::lock_guard<std::mutex> lock(m_pendingTransformsMutex);
+        VFVPendingTransform& pending = m_pendingTransforms[std::make_pair(scale.datasetID, scale.subDatasetID)];
+
+        m_nbReceivedTransforms++;
+        if(pending.hasScale)
+            m_nbCoalescedTransforms++;
+
+        pending.hasScale    = true;
+        pending.scaleClient = client;
+        pending.scale       = scale;
+    }
+
+    void VFVServer::flushTransforms()
+    {
+        //Take the transformations received so far. Most ticks have none: do not take the global locks for nothing
+        {
+            std::lock_guard<std::mutex> lockTransforms(m_pendingTransformsMutex);
+            if(m_pendingTransforms.empty())
+                return;
+            m_flushedTransforms.swap(m_pendingTransforms);
+        }
+
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
+
+        //Keep the lock while applying: closeClient removes the transformations of a disconnecting client under this lock.
+        //The transformations received meanwhile wait in m_pendingTransforms for the next flush
+        std::lock_guard<std::mutex> lockTransforms(m_pendingTransformsMutex);
+
+        for(auto it = m_flushedTransforms.begin(); it != m_flushedTransforms.end();)
+        {
+            //A long computation (e.g., a volumetric selection) may be using this dataset and its transformations:
+            //keep them pending until the next flush, unless newer ones replaced them. try_lock only, as m_pendingTransformsMutex is already locked
+            std::shared_ptr<VFVValuesMutex> valuesMutex = getDatasetValuesMutex(it->first.first);
+            std::unique_lock<VFVValuesMutex> lockValues;
+            if(valuesMutex)
+            {
+                lockValues = std::unique_lock<VFVValuesMutex>(*valuesMutex, std::try_to_lock);
+                if(!lockValues.owns_lock())
+                {
+                    VFVPendingTransform& flushed = it->second;
+                    VFVPendingTransform& pending = m_pendingTransforms[it->first];
+                    if(flushed.hasRotate && !pending.hasRotate)
+                    {
+                        pending.hasRotate    = true;
+                        pending.rotateClient = flushed.rotateClient;
+                        pending.rotate       = flushed.rotate;
+                    }
+                    if(flushed.hasMove && !pending.hasMove)
+                    {
+                        pending.hasMove    = true;
+                        pending.moveClient = flushed.moveClient;
+                        pending.move       = flushed.move;
+                    }
+                    if(flushed.hasScale && !pending.hasScale)
+                    {
+                        pending.hasScale    = true;
+                        pending.scaleClient = flushed.scaleClient;
+                        pending.scale       = flushed.scale;
+                    }
+                    it = m_flushedTransforms.erase(it);
+                    continue;
+                }
+            }
+
+            VFVPendingTransform& pending = it->second;
+            if(pending.hasMove)
+                translateSubDataset(pending.moveClient, pending.move);
+            if(pending.hasRotate)
+                rotateSubDataset(pending.rotateClient, pending.rotate);
+            if(pending.hasScale)
+                scaleSubDataset(pending.scaleClient, pending.scale);
+
+            //The live selection previews of this SubDataset are expressed in its previous local space
+            Dataset* dataset = getDataset(it->first.first, it->first.second);
+            if(dataset)
+            {
+                SubDataset* sd = dataset->getSubDataset(it->first.second);
+                for(auto& itPreview : m_selectionPreviews)
+                {
+                    VFVSelectionPreviewState& state = itPreview.second;
+                    if(state.datasetID != it->first.first || state.subDatasetID != it->first.second)
+                        continue;
+                    state.position    = sd->getPosition();
+                    state.invRotation = sd->getGlobalRotate().getInverse();
+                    state.scale       = sd->getScale();
+                    updateSelectionPreview(itPreview.first, true);
+                }
+            }
+            it = m_flushedTransforms.erase(it);
+        }
     }
 
     void VFVServer::tfSubDataset(VFVClientSocket* client, VFVTransferFunctionSubDataset& tfSD)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         Dataset* dataset = getDataset(tfSD.datasetID, tfSD.subDatasetID);
         if(dataset == NULL)
@@ -2171,9 +3045,6 @@ endFor:;
 
     void VFVServer::scaleSubDataset(VFVClientSocket* client, VFVScaleInformation& scale)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
-
         Dataset* dataset = getDataset(scale.datasetID, scale.subDatasetID);
         if(dataset == NULL)
         {
@@ -2216,15 +3087,13 @@ endFor:;
         }
 
         //Send to all
-        for(auto& clt : m_clientTable)
-            if(clt.second != client)
-                sendScaleDatasetEvent(clt.second, scale);
+        broadcastMessage(generateScaleDatasetEvent(scale), scale, client);
     }
 
     void VFVServer::setSubDatasetClipping(VFVClientSocket* client, VFVSetSubDatasetClipping& clipping)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         Dataset* dataset = getDataset(clipping.datasetID, clipping.subDatasetID);
         if(dataset == NULL)
@@ -2266,7 +3135,7 @@ endFor:;
 
     void VFVServer::updateHeadset(VFVClientSocket* client, const VFVUpdateHeadset& headset)
     {
-        std::lock_guard<std::mutex> lock(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
         if(!client->isHeadset())
         {
             VFVSERVER_NOT_A_HEADSET  
@@ -2297,7 +3166,7 @@ endFor:;
 
     void VFVServer::onStartAnnotation(VFVClientSocket* client, const VFVStartAnnotation& startAnnot)
     {
-//        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+//        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
         if(!client->isTablet())
         {
             VFVSERVER_NOT_A_TABLET
@@ -2317,8 +3186,8 @@ endFor:;
 
     void VFVServer::onAnchorAnnotation(VFVClientSocket* client, VFVAnchorAnnotation& anchorAnnot)
     {
-        std::lock_guard<std::mutex> datasetLock(m_datasetMutex);
-        std::lock_guard<std::mutex> lockMap(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> datasetLock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
         uint32_t annotID = 0;
         uint32_t headsetID = -1;
@@ -2372,8 +3241,8 @@ endFor:;
 
     void VFVServer::onClearAnnotations(VFVClientSocket* client, const VFVClearAnnotations& clearAnnots)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
-        std::lock_guard<std::mutex> lock2(m_mapMutex);    //Ensute that no one is modifying the list of clients (and relevant information)
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);    //Ensute that no one is modifying the list of clients (and relevant information)
 
         Dataset* dataset = getDataset(clearAnnots.datasetID, clearAnnots.subDatasetID);
         if(dataset == NULL)
@@ -2409,8 +3278,8 @@ endFor:;
 
     void VFVServer::onResetVolumetricSelection(VFVClientSocket* client, const VFVResetVolumetricSelection& reset)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
-        std::lock_guard<std::mutex> lock2(m_mapMutex);    //Ensute that no one is modifying the list of clients (and relevant information)
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);    //Ensute that no one is modifying the list of clients (and relevant information)
 
         //Check that the dataset exists
         Dataset* dataset = getDataset(reset.datasetID, reset.subDatasetID);
@@ -2419,8 +3288,6 @@ endFor:;
             VFVSERVER_SUB_DATASET_NOT_FOUND(reset.datasetID, reset.subDatasetID)
             return;
         }
-        SubDataset* sd = dataset->getSubDataset(reset.subDatasetID);
-        sd->resetVolumetricMask(true, false);
 
         //Get the headset asking for this piece of information
         int headsetID = -1;
@@ -2434,15 +3301,46 @@ endFor:;
             headsetID = hmdClient->getHeadsetData().id;
         }
 
+        resetVolumetricSelection(reset.datasetID, reset.subDatasetID, headsetID);
+    }
+
+    void VFVServer::resetVolumetricSelection(uint32_t datasetID, uint32_t subDatasetID, int32_t headsetID)
+    {
+        Dataset* dataset = getDataset(datasetID, subDatasetID);
+        if(dataset == nullptr)
+        {
+            VFVSERVER_SUB_DATASET_NOT_FOUND(datasetID, subDatasetID)
+            return;
+        }
+        SubDataset* sd = dataset->getSubDataset(subDatasetID);
+
+        {
+            //Do not wait for a computation using the values (e.g., a volumetric selection) while holding the global locks: reset the mask after it
+            std::unique_lock<VFVValuesMutex> lockValues(*getDatasetValuesMutex(datasetID), std::try_to_lock);
+            if(!lockValues.owns_lock())
+            {
+                deferUntilValuesFree([this, datasetID, subDatasetID, headsetID]() {resetVolumetricSelection(datasetID, subDatasetID, headsetID);});
+                return;
+            }
+            sd->resetVolumetricMask(true, false);
+
+            SubDatasetMetaData* sdMT = NULL;
+            if(getMetaData(datasetID, subDatasetID, &sdMT) != NULL && sdMT != NULL)
+                sdMT->volumetricMaskBricks.markAllDirty();
+        }
+
         updateSDGroup(sd);
 
         for(auto& clt : m_clientTable)
-            sendResetVolumetricSelection(clt.second, reset.datasetID, reset.subDatasetID, headsetID);
+            sendResetVolumetricSelection(clt.second, datasetID, subDatasetID, headsetID);
+
+        //Keep the sequence numbers of the clients receiving mask deltas in sync
+        sendVolumetricMaskUpdate(datasetID, sd, NULL, false);
     }
 
     void VFVServer::setDrawableAnnotationPositionColor(VFVClientSocket* client, const VFVSetDrawableAnnotationPositionDefaultColor& color)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
 
         //Search for the meta data
         SubDatasetMetaData* sdMT = NULL;
@@ -2462,14 +3360,14 @@ endFor:;
         drawable->drawable->setColor(glm::vec4(r, g, b, a));
 
         //Send the information to every clients
-        std::lock_guard<std::mutex> lock2(m_mapMutex);    //Ensure that no one is modifying the list of clients (and relevant information)
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);    //Ensure that no one is modifying the list of clients (and relevant information)
         for(auto& clt : m_clientTable)
             sendSetDrawableAnnotationPositionColor(clt.second, color);
     }
 
     void VFVServer::setDrawableAnnotationPositionIdx(VFVClientSocket* client, const VFVSetDrawableAnnotationPositionMappedIdx& idx)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
 
         //Search for the meta data
         SubDatasetMetaData* sdMT = NULL;
@@ -2485,15 +3383,15 @@ endFor:;
         drawable->drawable->setMappedDataIndices(idx.idx);
 
         //Send the information to every clients
-        std::lock_guard<std::mutex> lock2(m_mapMutex);    //Ensure that no one is modifying the list of clients (and relevant information)
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);    //Ensure that no one is modifying the list of clients (and relevant information)
         for(auto& clt : m_clientTable)
             sendSetDrawableAnnotationPositionIdx(clt.second, idx);
     }
 
     void VFVServer::addSubjectiveViewGroup(VFVClientSocket* client, const VFVAddSubjectiveViewGroup& addSV)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
-        std::lock_guard<std::mutex> lock2(m_mapMutex);    //Ensure that no one is modifying the list of clients (and relevant information)
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);    //Ensure that no one is modifying the list of clients (and relevant information)
 
         VFVClientSocket* hmdClient = nullptr;
         if(client != NULL) //Not the server
@@ -2592,8 +3490,8 @@ endFor:;
 
     void VFVServer::onRemoveSubDatasetGroup(VFVClientSocket* client, const VFVRemoveSubDatasetGroup& removeSDGroup)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
-        std::lock_guard<std::mutex> lock2(m_mapMutex);
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
 
         //Searching for the sd group
         auto svIT = m_sdGroups.find(removeSDGroup.sdgID);
@@ -2665,7 +3563,7 @@ endFor:;
 
     void VFVServer::setSubjectiveViewStackedParameters(VFVClientSocket* client, const VFVSetSVStackedGroupGlobalParameters& params)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
 
         //Searching for the subjective group
         auto svIT = m_sdGroups.find(params.sdgID);
@@ -2703,7 +3601,7 @@ endFor:;
         //Retrieve the datasetID
         //uint32_t datasetID = getDatasetID(svg->getBase()->getParent());
 
-        std::lock_guard<std::mutex> lock2(m_mapMutex);
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);
         for(auto& clt : m_clientTable)
         {
             sendSVStackedGroupGlobalParameters(clt.second, params);
@@ -2835,8 +3733,8 @@ endFor:;
 
     void VFVServer::onAddClientToSVGroup(VFVClientSocket* client, const VFVAddClientToSVGroup& addClient)
     {
-        std::lock_guard<std::mutex> lock(m_datasetMutex); //Ensure that no one is touching the datasets
-        std::lock_guard<std::mutex> lock2(m_mapMutex);    //Ensure that no one is modifying the list of clients (and relevant information)
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //Ensure that no one is touching the datasets
+        VFVTimedLockGuard<std::mutex> lock2(m_mapMutex, m_mapLockStats);    //Ensure that no one is modifying the list of clients (and relevant information)
 
         addClientToSVGroup(client, addClient);
     }
@@ -2856,14 +3754,54 @@ endFor:;
 #endif
     }
 
+    void VFVServer::saveBroadcastMessageToJSONLog(const std::vector<VFVClientSocket*>& recipients, const VFVDataInformation& data)
+    {
+#ifdef VFV_LOG_DATA
+        {
+            std::lock_guard<std::mutex> logLock(m_logMutex);
+
+            //Remove the closing bracket to append the list of recipients
+            std::string json = data.toJson(VFV_SENDER_SERVER, "ALL:Broadcast", getTimeOffset());
+            json.pop_back();
+
+            m_log << json << ",    \"recipients\" : [";
+            for(uint32_t i = 0; i < recipients.size(); i++)
+            {
+                if(i != 0)
+                    m_log << ", ";
+                m_log << "\"" << getHeadsetIPAddr(recipients[i]) << "\"";
+            }
+            m_log << "]\n";
+            VFV_END_TO_JSON(m_log);
+            m_log << ",\n" << std::flush;
+        }
+#endif
+    }
+
+    void VFVServer::broadcastMessage(const VFVMessageBuilder& msg, const VFVDataInformation& data, VFVClientSocket* except)
+    {
+        std::vector<VFVClientSocket*> recipients;
+        recipients.reserve(m_clientTable.size());
+
+        for(auto& clt : m_clientTable)
+        {
+            if(clt.second == except)
+                continue;
+
+            SocketMessage<int> sm(clt.second->socket, msg.getData(), msg.getSize());
+            writeMessage(sm);
+            recipients.push_back(clt.second);
+        }
+
+        saveBroadcastMessageToJSONLog(recipients, data);
+    }
+
     void VFVServer::sendEmptyMessage(VFVClientSocket* client, uint16_t type)
     {
-        uint8_t* data = (uint8_t*)malloc(sizeof(uint16_t));
-        writeUint16(data, type);
+        VFVMessageBuilder msg(m_bufferPool, type);
 
         INFO << "Sending EMPTY MESSAGE Event data. Type : " << type << std::endl;
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, sizeof(uint16_t));
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         VFVNoDataInformation noData;
@@ -2873,46 +3811,23 @@ endFor:;
 
     void VFVServer::sendAddVTKDatasetEvent(VFVClientSocket* client, const VFVVTKDatasetInformation& dataset, uint32_t datasetID)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t) + 
-                            sizeof(uint8_t)*dataset.name.size() +
-                            sizeof(uint32_t)*(dataset.ptFields.size()+dataset.cellFields.size()+2);
-
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-
-        uint32_t offset=0;
-
-        writeUint16(data, VFV_SEND_ADD_VTK_DATASET); //Type
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, datasetID); //The datasetID
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, dataset.name.size()); //Dataset name size
-        offset += sizeof(uint32_t); 
-
-        memcpy(data+offset, dataset.name.data(), dataset.name.size()); //Dataset name
-        offset += dataset.name.size()*sizeof(uint8_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_VTK_DATASET, 
+                              sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint8_t)*dataset.name.size() +
+                              sizeof(uint32_t)*(dataset.ptFields.size()+dataset.cellFields.size()+2));
 
-        writeUint32(data+offset, dataset.ptFields.size()); //ptFieldValueSize
-        offset+= sizeof(uint32_t);
+        msg.pushUint32(datasetID);    //The datasetID
+        msg.pushString(dataset.name); //Dataset name
 
+        msg.pushUint32(dataset.ptFields.size()); //ptFieldValueSize
         for(int i : dataset.ptFields)
-        {
-            writeUint32(data+offset, i); //ptFieldValue[i]
-            offset += sizeof(uint32_t);
-        }
+            msg.pushUint32(i); //ptFieldValue[i]
 
-        writeUint32(data+offset, dataset.cellFields.size()); //cellFieldValueSize
-        offset+= sizeof(uint32_t);
+        msg.pushUint32(dataset.cellFields.size()); //cellFieldValueSize
         for(int i : dataset.cellFields)
-        {
-            writeUint32(data+offset, i); //cellFieldValue[i]
-            offset += sizeof(uint32_t);
-        }
+            msg.pushUint32(i); //cellFieldValue[i]
 
         INFO << "Sending ADD VTK DATASET Event data. File : " << dataset.name << "\n";
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, dataset);
@@ -2920,28 +3835,14 @@ endFor:;
 
     void VFVServer::sendAddCloudPointDatasetEvent(VFVClientSocket* client, const VFVCloudPointDatasetInformation& dataset, uint32_t datasetID)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t) + 
-                            sizeof(uint8_t)*dataset.name.size();
-
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-
-        uint32_t offset=0;
-
-        writeUint16(data, VFV_SEND_ADD_CLOUDPOINT_DATASET); //Type
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, datasetID); //The datasetID
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_CLOUDPOINT_DATASET, 
+                              sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint8_t)*dataset.name.size());
 
-        writeUint32(data+offset, dataset.name.size()); //Dataset name size
-        offset += sizeof(uint32_t); 
-
-        memcpy(data+offset, dataset.name.data(), dataset.name.size()); //Dataset name
-        offset += dataset.name.size()*sizeof(uint8_t);
+        msg.pushUint32(datasetID);    //The datasetID
+        msg.pushString(dataset.name); //Dataset name
 
         INFO << "Sending ADD CLOUD POINT DATASET Event data. File : " << dataset.name << "\n";
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, dataset);
@@ -2961,36 +3862,16 @@ endFor:;
                 if(sdMetaData && sdMetaData->owner != NULL)
                     ownerID = sdMetaData->owner->getHeadsetData().id;
 
-                uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t)*2 + sizeof(uint32_t) + sizeof(uint32_t) +
-                                    sd->getName().size()*sizeof(uint8_t);
-
-                uint8_t* data = (uint8_t*)malloc(dataSize);
-                uint32_t offset = 0;
-
-                writeUint16(data, VFV_SEND_ADD_SUBDATASET);
-                offset+=sizeof(uint16_t);
-
-                //Dataset ID
-                writeUint32(data+offset, id);
-                offset+=sizeof(uint32_t);
+                VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_SUBDATASET, 
+                                      sizeof(uint32_t)*2 + sizeof(uint32_t) + sizeof(uint32_t) + sd->getName().size()*sizeof(uint8_t));
 
-                //SubDataset ID
-                writeUint32(data+offset, sd->getID());
-                offset+=sizeof(uint32_t);
-
-                //SubDataset Name
-                writeUint32(data+offset, sd->getName().size());
-                offset+=sizeof(uint32_t);
-                memcpy(data+offset, sd->getName().c_str(), sd->getName().size());
-                offset+=sd->getName().size();
-
-                //Owner ID
-                writeUint32(data+offset, ownerID);
-                offset+=sizeof(uint32_t);
+                msg.pushUint32(id)              //Dataset ID
+                   .pushUint32(sd->getID())     //SubDataset ID
+                   .pushString(sd->getName())   //SubDataset Name
+                   .pushUint32(ownerID);        //Owner ID
 
                 INFO << "Sending ADDSUBDATASET Event data. Name : " << sd->getName() << " Owner : " << ownerID << "\n";
-                std::shared_ptr<uint8_t> sharedData(data, free);
-                SocketMessage<int> sm(client->socket, sharedData, offset);
+                SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
                 writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3012,22 +3893,12 @@ endFor:;
 
     void VFVServer::sendRemoveSubDatasetEvent(VFVClientSocket* client, const VFVRemoveSubDataset& dataset)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 2*sizeof(uint32_t);
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_DEL_SUBDATASET); //Type
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, dataset.datasetID); //The datasetID
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, dataset.subDatasetID); //SubDataset ID
-        offset += sizeof(uint32_t); 
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_DEL_SUBDATASET, 2*sizeof(uint32_t));
+        msg.pushUint32(dataset.datasetID)     //The datasetID
+           .pushUint32(dataset.subDatasetID); //SubDataset ID
 
         INFO << "Sending Remove DATASET Event data. Data : " << dataset.datasetID << " sdID : " << dataset.subDatasetID << "\n";
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, dataset);
@@ -3035,36 +3906,19 @@ endFor:;
 
     void VFVServer::sendAddLogData(VFVClientSocket* client, const VFVOpenLogData& logData, uint32_t logID)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 
-                            sizeof(uint32_t) +
-                            sizeof(uint32_t) + logData.fileName.size() +
-                            sizeof(uint8_t)  +
-                            sizeof(uint32_t);
-
-        uint8_t* data   = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_ADD_LOG_DATASET);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, logID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_LOG_DATASET, 
+                              sizeof(uint32_t) +
+                              sizeof(uint32_t) + logData.fileName.size() +
+                              sizeof(uint8_t)  +
+                              sizeof(uint32_t));
 
-        writeUint32(data+offset, logData.fileName.size());
-        offset += sizeof(uint32_t);
-
-        for(uint32_t i = 0; i < logData.fileName.size(); offset++, i++)
-            data[offset] = logData.fileName[i];
-
-        data[offset] = logData.hasHeader;
-        offset++;
-
-        writeUint32(data+offset, logData.timeID);
-        offset += sizeof(uint32_t);
+        msg.pushUint32(logID)
+           .pushString(logData.fileName)
+           .pushByte(logData.hasHeader)
+           .pushUint32(logData.timeID);
 
         INFO << "Sending ADD LOG DATASET Event data. Data : " << logData.fileName << " ID " << logID << std::endl;
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3083,23 +3937,13 @@ endFor:;
 
     void VFVServer::sendAddAnnotationPositionData(VFVClientSocket* client, const AnnotationComponentMetaData<AnnotationPosition>& posMT)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t);
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_ADD_ANNOTATION_POSITION);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, posMT.annotID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, posMT.compID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_ANNOTATION_POSITION, sizeof(uint32_t) + sizeof(uint32_t));
+        msg.pushUint32(posMT.annotID)
+           .pushUint32(posMT.compID);
 
         INFO << "Sending 'ADD ANNOTATION POSITION Event data. AnnotID: " << posMT.annotID << " PosID: " << posMT.compID << std::endl;
 
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3116,30 +3960,20 @@ endFor:;
 
     void VFVServer::sendSetAnnotationPositionIndexes(VFVClientSocket* client, const AnnotationComponentMetaData<AnnotationPosition>& posMT)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t) + 3*sizeof(uint32_t);
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_SET_ANNOTATION_POSITION_INDEXES);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, posMT.annotID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, posMT.compID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SET_ANNOTATION_POSITION_INDEXES, sizeof(uint32_t) + sizeof(uint32_t) + 3*sizeof(uint32_t));
+        msg.pushUint32(posMT.annotID)
+           .pushUint32(posMT.compID);
 
         int32_t indices[3];
         posMT.component->getPosIndices(indices);
 
-        for(uint32_t i = 0; i < 3; i++, offset+=sizeof(uint32_t))
-            writeUint32(data+offset, indices[i]);
+        for(uint32_t i = 0; i < 3; i++)
+            msg.pushUint32(indices[i]);
 
         INFO << "Sending 'SET ANNOTATION POSITION INDICES Event data. AnnotID: " << posMT.annotID << " PosID: " << posMT.compID 
              << "X: " << indices[0] << " Y: " << indices[1] << " Z: " << indices[2] << std::endl;
 
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3157,33 +3991,17 @@ endFor:;
 
     void VFVServer::sendAddAnnotationPositionToSD(VFVClientSocket* client, const SubDatasetMetaData& sdMT, const DrawableAnnotationPositionMetaData& drawable)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 5*sizeof(uint32_t);
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_ADD_ANNOTATION_POSITION_TO_SD);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, sdMT.datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, sdMT.sdID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, drawable.compMetaData->annotID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, drawable.compMetaData->compID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, drawable.drawableID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_ANNOTATION_POSITION_TO_SD, 5*sizeof(uint32_t));
+        msg.pushUint32(sdMT.datasetID)
+           .pushUint32(sdMT.sdID)
+           .pushUint32(drawable.compMetaData->annotID)
+           .pushUint32(drawable.compMetaData->compID)
+           .pushUint32(drawable.drawableID);
 
         INFO << "Sending 'ADD ANNOTATION POSITION INDICES Event data. DatasetID: " << sdMT.datasetID << " sdID: " << sdMT.sdID 
              << " AnnotID: " << drawable.compMetaData->annotID << " compID: " << drawable.compMetaData->compID << " drawableID: " << drawable.drawableID << std::endl;
 
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3201,90 +4019,75 @@ endFor:;
 #endif
     }
 
-    void VFVServer::sendRotateDatasetEvent(VFVClientSocket* client, const VFVRotationInformation& rotate)
+    VFVMessageBuilder VFVServer::generateRotateDatasetEvent(const VFVRotationInformation& rotate)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t) + 4*sizeof(float);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset=0;
-
-        writeUint16(data, VFV_SEND_ROTATE_DATASET); //Type
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, rotate.datasetID); //The datasetID
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, rotate.subDatasetID); //SubDataset ID
-        offset += sizeof(uint32_t); 
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ROTATE_DATASET, 3*sizeof(uint32_t) + 4*sizeof(float));
 
-        writeUint32(data+offset, rotate.headsetID); //The headset ID
-        offset += sizeof(uint32_t); 
+        msg.pushUint32(rotate.datasetID)     //The datasetID
+           .pushUint32(rotate.subDatasetID)  //SubDataset ID
+           .pushUint32(rotate.headsetID);    //The headset ID
 
-        for(int i = 0; i < 4; i++, offset += sizeof(float)) //Quaternion rotation
-            writeFloat(data+offset, rotate.quaternion[i]);
+        for(int i = 0; i < 4; i++) //Quaternion rotation
+            msg.pushFloat(rotate.quaternion[i]);
 
         INFO << "Sending ROTATE DATASET Event data. Data : " << rotate.datasetID << " sdID : " << rotate.subDatasetID
              << " Q = " << rotate.quaternion[0] << " " << rotate.quaternion[1] << " " << rotate.quaternion[2] << " " << rotate.quaternion[3] << "\n";
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        return msg;
+    }
+
+    void VFVServer::sendRotateDatasetEvent(VFVClientSocket* client, const VFVRotationInformation& rotate)
+    {
+        VFVMessageBuilder msg = generateRotateDatasetEvent(rotate);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, rotate);
     }
 
-    void VFVServer::sendScaleDatasetEvent(VFVClientSocket* client, const VFVScaleInformation& scale)
+    VFVMessageBuilder VFVServer::generateScaleDatasetEvent(const VFVScaleInformation& scale)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t) + 3*sizeof(float);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset=0;
-
-        writeUint16(data, VFV_SEND_SCALE_DATASET); //Type
-        offset += sizeof(uint16_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SCALE_DATASET, 3*sizeof(uint32_t) + 3*sizeof(float));
 
-        writeUint32(data+offset, scale.datasetID); //The datasetID
-        offset += sizeof(uint32_t);
+        msg.pushUint32(scale.datasetID)     //The datasetID
+           .pushUint32(scale.subDatasetID)  //SubDataset ID
+           .pushUint32(scale.headsetID);    //The headset ID
 
-        writeUint32(data+offset, scale.subDatasetID); //SubDataset ID
-        offset += sizeof(uint32_t); 
-
-        writeUint32(data+offset, scale.headsetID); //The headset ID
-        offset += sizeof(uint32_t); 
-
-        for(int i = 0; i < 3; i++, offset += sizeof(float)) //3D Scaling
-            writeFloat(data+offset, scale.scale[i]);
+        for(int i = 0; i < 3; i++) //3D Scaling
+            msg.pushFloat(scale.scale[i]);
 
         INFO << "Sending SCALE DATASET Event data DatasetID " << scale.datasetID << " SubDataset ID " << scale.subDatasetID << " ["
              << scale.scale[0] << ", " << scale.scale[1] << ", " << scale.scale[2] << "]\n";
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        return msg;
+    }
+
+    void VFVServer::sendScaleDatasetEvent(VFVClientSocket* client, const VFVScaleInformation& scale)
+    {
+        VFVMessageBuilder msg = generateScaleDatasetEvent(scale);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, scale);
     }
 
-    void VFVServer::sendMoveDatasetEvent(VFVClientSocket* client, const VFVMoveInformation& position)
+    VFVMessageBuilder VFVServer::generateMoveDatasetEvent(const VFVMoveInformation& position)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t) + 3*sizeof(float);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset=0;
-
-        writeUint16(data, VFV_SEND_MOVE_DATASET); //Type
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, position.datasetID); //The datasetID
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, position.subDatasetID); //SubDataset ID
-        offset += sizeof(uint32_t); 
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_MOVE_DATASET, 3*sizeof(uint32_t) + 3*sizeof(float));
 
-        writeUint32(data+offset, position.headsetID); //The headset ID
-        offset += sizeof(uint32_t); 
+        msg.pushUint32(position.datasetID)     //The datasetID
+           .pushUint32(position.subDatasetID)  //SubDataset ID
+           .pushUint32(position.headsetID);    //The headset ID
 
-        for(int i = 0; i < 3; i++, offset += sizeof(float)) //Vector3 position
-            writeFloat(data+offset, position.position[i]);
+        for(int i = 0; i < 3; i++) //Vector3 position
+            msg.pushFloat(position.position[i]);
 
         INFO << "Sending MOVE DATASET Event data Dataset ID " << position.datasetID << " sdID : " << position.subDatasetID << " position : [" << position.position[0] << ", " << position.position[1] << ", " << position.position[2] << "]\n";
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        return msg;
+    }
+
+    void VFVServer::sendMoveDatasetEvent(VFVClientSocket* client, const VFVMoveInformation& position)
+    {
+        VFVMessageBuilder msg = generateMoveDatasetEvent(position);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, position);
@@ -3292,27 +4095,14 @@ endFor:;
 
     void VFVServer::sendSubDatasetClippingEvent(VFVClientSocket* client, const VFVSetSubDatasetClipping& clipping)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 2*sizeof(uint32_t) + 2*sizeof(float);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset=0;
-
-        writeUint16(data, VFV_SEND_SET_SUBDATASET_CLIPPING); //Type
-        offset += sizeof(uint16_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SET_SUBDATASET_CLIPPING, 2*sizeof(uint32_t) + 2*sizeof(float));
 
-        writeUint32(data+offset, clipping.datasetID); //The datasetID
-        offset += sizeof(uint32_t);
+        msg.pushUint32(clipping.datasetID)     //The datasetID
+           .pushUint32(clipping.subDatasetID)  //SubDataset ID
+           .pushFloat(clipping.minDepthClipping)
+           .pushFloat(clipping.maxDepthClipping);
 
-        writeUint32(data+offset, clipping.subDatasetID); //SubDataset ID
-        offset += sizeof(uint32_t); 
-
-        writeFloat(data+offset, clipping.minDepthClipping);
-        offset += sizeof(float);
-
-        writeFloat(data+offset, clipping.maxDepthClipping);
-        offset += sizeof(float);
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, clipping);
@@ -3320,18 +4110,10 @@ endFor:;
 
     void VFVServer::sendCurrentAction(VFVClientSocket* client, uint32_t currentActionID)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_CURRENT_ACTION, sizeof(uint32_t));
+        msg.pushUint32(currentActionID);
 
-        writeUint16(data, VFV_SEND_CURRENT_ACTION); //Type
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, currentActionID);
-        offset += sizeof(uint32_t);
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3372,7 +4154,7 @@ endFor:;
         return size;
     }
 
-    static uint32_t fillTransferFunctionMessage(uint8_t* data, uint32_t offset, const VFVTransferFunctionSubDataset& tfSD)
+    static void fillTransferFunctionMessage(VFVMessageBuilder& msg, const VFVTransferFunctionSubDataset& tfSD)
     {
         //Write tf specific data (depends on type)
         switch(tfSD.tfID)
@@ -3380,52 +4162,35 @@ endFor:;
             case TF_GTF:
             case TF_TRIANGULAR_GTF:
             {
-                writeUint32(data+offset, tfSD.gtfData.propData.size()); //The number of properties
-                offset += sizeof(uint32_t);
+                msg.pushUint32(tfSD.gtfData.propData.size()); //The number of properties
 
                 for(auto& propData : tfSD.gtfData.propData)
                 {
-                    writeUint32(data+offset, propData.propID); //The property ID
-                    offset += sizeof(uint32_t);
-
-                    writeFloat(data+offset, propData.center); //The center
-                    offset += sizeof(float);
-
-                    writeFloat(data+offset, propData.scale); //The scale
-                    offset += sizeof(float);
+                    msg.pushUint32(propData.propID) //The property ID
+                       .pushFloat(propData.center)  //The center
+                       .pushFloat(propData.scale);  //The scale
                 }
                 break;
             }
             case TF_MERGE:
             {
-                writeFloat(data+offset, tfSD.mergeTFData.t);
-                offset += sizeof(float);
+                msg.pushFloat(tfSD.mergeTFData.t);
 
                 //TF1
-                data[offset] = tfSD.mergeTFData.tf1->tfID;
-                offset++;
-                data[offset] = tfSD.mergeTFData.tf1->colorMode;
-                offset++;
-                writeFloat(data+offset, tfSD.mergeTFData.tf1->timestep);
-                offset += sizeof(float);
-                writeFloat(data+offset, tfSD.mergeTFData.tf1->minClipping);
-                offset += sizeof(float);
-                writeFloat(data+offset, tfSD.mergeTFData.tf1->maxClipping);
-                offset += sizeof(float);
-                offset = fillTransferFunctionMessage(data, offset, *tfSD.mergeTFData.tf1.get());
+                msg.pushByte(tfSD.mergeTFData.tf1->tfID)
+                   .pushByte(tfSD.mergeTFData.tf1->colorMode)
+                   .pushFloat(tfSD.mergeTFData.tf1->timestep)
+                   .pushFloat(tfSD.mergeTFData.tf1->minClipping)
+                   .pushFloat(tfSD.mergeTFData.tf1->maxClipping);
+                fillTransferFunctionMessage(msg, *tfSD.mergeTFData.tf1.get());
 
                 //TF2
-                data[offset] = tfSD.mergeTFData.tf2->tfID;
-                offset++;
-                data[offset] = tfSD.mergeTFData.tf2->colorMode;
-                offset++;
-                writeFloat(data+offset, tfSD.mergeTFData.tf2->timestep);
-                offset += sizeof(float);
-                writeFloat(data+offset, tfSD.mergeTFData.tf2->minClipping);
-                offset += sizeof(float);
-                writeFloat(data+offset, tfSD.mergeTFData.tf2->maxClipping);
-                offset += sizeof(float);
-                offset = fillTransferFunctionMessage(data, offset, *tfSD.mergeTFData.tf2.get());
+                msg.pushByte(tfSD.mergeTFData.tf2->tfID)
+                   .pushByte(tfSD.mergeTFData.tf2->colorMode)
+                   .pushFloat(tfSD.mergeTFData.tf2->timestep)
+                   .pushFloat(tfSD.mergeTFData.tf2->minClipping)
+                   .pushFloat(tfSD.mergeTFData.tf2->maxClipping);
+                fillTransferFunctionMessage(msg, *tfSD.mergeTFData.tf2.get());
 
                 break;
             }
@@ -3433,53 +4198,30 @@ endFor:;
             default:
                 break;
         }
-
-        return offset;
     }
 
     void VFVServer::sendTransferFunctionDataset(VFVClientSocket* client, const VFVTransferFunctionSubDataset& tfSD)
     {
         //Determine the size of the packet
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t) + 2*sizeof(uint8_t) + 3*sizeof(float) + getTransferFunctionSize(tfSD);
-
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_TF_DATASET); //Type
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, tfSD.datasetID); //The datasetID
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, tfSD.subDatasetID); //SubDataset ID
-        offset += sizeof(uint32_t); 
-
-        writeUint32(data+offset, tfSD.headsetID); //The headset ID
-        offset += sizeof(uint32_t); 
-
-        data[offset] = tfSD.tfID; //The transfer function type
-        offset++;
-
-        data[offset] = tfSD.colorMode; //The color mode
-        offset++;
-
-        writeFloat(data+offset, tfSD.timestep); //the timestep
-        offset += sizeof(float);
-
-        writeFloat(data+offset, tfSD.minClipping); //the minimum clipping
-        offset += sizeof(float);
-
-        writeFloat(data+offset, tfSD.maxClipping); //the maximum clipping
-        offset += sizeof(float);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_TF_DATASET, 
+                              3*sizeof(uint32_t) + 2*sizeof(uint8_t) + 3*sizeof(float) + getTransferFunctionSize(tfSD));
+
+        msg.pushUint32(tfSD.datasetID)     //The datasetID
+           .pushUint32(tfSD.subDatasetID)  //SubDataset ID
+           .pushUint32(tfSD.headsetID)     //The headset ID
+           .pushByte(tfSD.tfID)            //The transfer function type
+           .pushByte(tfSD.colorMode)       //The color mode
+           .pushFloat(tfSD.timestep)       //the timestep
+           .pushFloat(tfSD.minClipping)    //the minimum clipping
+           .pushFloat(tfSD.maxClipping);   //the maximum clipping
 
         INFO << "Timestep: " << tfSD.timestep << std::endl;
 
         //Fill tf-specific data
-        offset = fillTransferFunctionMessage(data, offset, tfSD);
+        fillTransferFunctionMessage(msg, tfSD);
 
         INFO << "Sending TF_DATASET Event data Dataset ID " << tfSD.datasetID << " sdID : " << tfSD.subDatasetID << " tfID : " << (int)tfSD.tfID << std::endl;
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, tfSD);
@@ -3492,6 +4234,132 @@ endFor:;
         writeMessage(sm);
     }
 
+    void VFVServer::sendVolumetricMaskUpdate(uint32_t datasetID, SubDataset* sd, VFVClientSocket* client, bool sendFull)
+    {
+        SubDatasetMetaData* sdMT = NULL;
+        if(getMetaData(datasetID, sd->getID(), &sdMT) == NULL || sdMT == NULL)
+        {
+            ERROR << "Could not fetch SubDatasetMetaData of " << datasetID << ':' << sd->getID() << std::endl;
+            return;
+        }
+
+        std::vector<VFVClientSocket*> clients;
+        if(client)
+            clients.push_back(client);
+        else
+            for(auto& it : m_clientTable)
+                clients.push_back(it.second);
+
+        const std::pair<uint32_t, uint32_t> key(datasetID, sd->getID());
+        std::vector<std::pair<VFVClientSocket*, uint8_t>> recipients; //The client and the message to send to it (see below)
+        std::shared_ptr<uint8_t>* messages     = sdMT->volumetricMaskEvents; //Full, full encoded, delta, resync
+        size_t*                   messageSizes = sdMT->volumetricMaskEventSizes;
+
+        {
+            //The mask may be being computed: send it once the values are free. Do not wait for them while holding the global locks
+            std::unique_lock<VFVValuesMutex> lockValues(*getDatasetValuesMutex(datasetID), std::try_to_lock);
+            if(!lockValues.owns_lock())
+            {
+                uint32_t sdID   = sd->getID();
+                SOCKET   socket = (client ? client->socket : -1);
+                deferUntilValuesFree([this, datasetID, sdID, socket, sendFull]()
+                {
+                    SubDataset* deferredSD = NULL;
+                    if(getDataset(datasetID, sdID, &deferredSD) == NULL || deferredSD == NULL)
+                        return;
+                    VFVClientSocket* deferredClient = NULL;
+                    if(socket != -1)
+                    {
+                        auto itClient = m_clientTable.find(socket);
+                        if(itClient == m_clientTable.end())
+                            return;
+                        deferredClient = itClient->second;
+                    }
+                    sendVolumetricMaskUpdate(datasetID, deferredSD, deferredClient, sendFull);
+                });
+                return;
+            }
+
+            const uint8_t* mask     = sd->getVolumetricMask();
+            const size_t   maskSize = sd->getVolumetricMaskSize();
+            const bool     enabled  = sd->isVolumetricMaskEnabled();
+
+            //Find the bricks which changed since the last mask sent: only the bricks marked by the code writing the mask are hashed.
+            //The values stay locked until the messages are generated: they can be generated from the mask itself
+            std::vector<uint32_t> dirtyBricks;
+            bool resized = sdMT->volumetricMaskBricks.update(mask, maskSize, dirtyBricks);
+            resized = resized || sdMT->volumetricMaskSequence == 0;
+
+            //A new version: the cached messages are outdated
+            if(resized || dirtyBricks.size() > 0 || enabled != sdMT->sentVolumetricMaskEnabled)
+            {
+                sdMT->volumetricMaskSequence++;
+                if(sdMT->volumetricMaskSequence == VOLUMETRIC_MASK_SEQUENCE_RESYNC)
+                    sdMT->volumetricMaskSequence = 1;
+                sdMT->sentVolumetricMaskEnabled = enabled;
+                sdMT->volumetricMaskDirtyBricks = dirtyBricks;
+                sdMT->volumetricMaskDeltaValid  = !resized;
+                for(uint32_t i = 0; i < 4; i++)
+                {
+                    messages[i]     = NULL;
+                    messageSizes[i] = 0;
+                }
+            }
+            const uint32_t sequence = sdMT->volumetricMaskSequence;
+
+            //Generate each message once, only if a client needs it
+            for(VFVClientSocket* clt : clients)
+            {
+                uint8_t msgID;
+                if(!clt->hasFeature(CLIENT_FEATURE_VOLUMETRIC_MASK_DELTA))
+                {
+                    if(!sendFull)
+                        continue;
+                    msgID = clt->hasFeature(CLIENT_FEATURE_ENCODED_VOLUMETRIC_MASK);
+                    if(!messages[msgID])
+                        messages[msgID] = generateVolumetricMaskEvent(m_bufferPool, sd, datasetID, &messageSizes[msgID], msgID == 1);
+                }
+                else
+                {
+                    auto itSequence = clt->getVolumetricMaskSequences().find(key);
+                    if(itSequence != clt->getVolumetricMaskSequences().end() && itSequence->second == sequence)
+                        continue; //Up to date
+
+                    if(sdMT->volumetricMaskDeltaValid && itSequence != clt->getVolumetricMaskSequences().end() && itSequence->second+1 == sequence)
+                    {
+                        msgID = 2;
+                        if(!messages[msgID])
+                            messages[msgID] = generateVolumetricMaskDeltaEvent(m_bufferPool, datasetID, sd->getID(), mask, maskSize, enabled,
+                                                                               sequence-1, sequence, sdMT->volumetricMaskDirtyBricks, &messageSizes[msgID]);
+                    }
+                    else
+                    {
+                        //Missed a sequence: send every non-empty brick
+                        msgID = 3;
+                        if(!messages[msgID])
+                        {
+                            std::vector<uint32_t> bricks;
+                            for(size_t begin = 0; begin < maskSize; begin += VOLUMETRIC_MASK_BRICK_SIZE)
+                            {
+                                const uint8_t* brick = mask + begin;
+                                size_t size = std::min((size_t)VOLUMETRIC_MASK_BRICK_SIZE, maskSize-begin);
+                                if(brick[0] != 0 || memcmp(brick, brick+1, size-1) != 0)
+                                    bricks.push_back(begin / VOLUMETRIC_MASK_BRICK_SIZE);
+                            }
+                            messages[msgID] = generateVolumetricMaskDeltaEvent(m_bufferPool, datasetID, sd->getID(), mask, maskSize, enabled,
+                                                                               VOLUMETRIC_MASK_SEQUENCE_RESYNC, sequence, bricks, &messageSizes[msgID]);
+                        }
+                    }
+                    clt->getVolumetricMaskSequences()[key] = sequence;
+                }
+                recipients.push_back(std::make_pair(clt, msgID));
+            }
+        }
+
+        for(auto& it : recipients)
+            sendVolumetricMaskDataset(it.first, messages[it.second], messageSizes[it.second]);
+    }
+
     void VFVServer::sendDrawableAnnotationPositionStatus(VFVClientSocket* client, const SubDatasetMetaData& sdMT, const DrawableAnnotationPositionMetaData& drawableMT)
     {
         VFVSetDrawableAnnotationPositionDefaultColor color;
@@ -3596,6 +4464,9 @@ endFor:;
             sendDatasetStatus(client, it.second, it.first);
         }
 
+        for(auto& it : m_loadingDatasets)
+            sendDatasetLoadingStatus(client, it.first, it.second, DATASET_LOADING_STATUS_LOADING);
+
         for(auto& it : m_sdGroups)
         {
             if(it.second.isSubjectiveView())
@@ -3663,9 +4534,7 @@ endFor:;
         sendToggleMapVisibility(client, map);
 
         //The volumetric mask
-        size_t dataSize;
-        auto data = generateVolumetricMaskEvent(sd, datasetID, &dataSize);
-        sendVolumetricMaskDataset(client, data, dataSize);
+        sendVolumetricMaskUpdate(datasetID, sd, client);
 
         //The clipping plane
         VFVSetSubDatasetClipping clipping;
@@ -3734,12 +4603,7 @@ endFor:;
             tablet  = client;
         }
 
-        uint8_t* data = (uint8_t*)malloc(sizeof(uint16_t) + 2*sizeof(uint8_t) + 4*sizeof(uint32_t));
-        uint32_t offset = 0;
-
-        //Type
-        writeUint16(data+offset, VFV_SEND_HEADSET_BINDING_INFO);
-        offset+=sizeof(uint16_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_HEADSET_BINDING_INFO, 2*sizeof(uint8_t) + 4*sizeof(uint32_t));
 
         uint32_t id    = -1;
         uint32_t color = 0x000000;
@@ -3761,24 +4625,11 @@ endFor:;
             handedness      = tablet->getTabletData().handedness;
         }
 
-        //Headset ID
-        writeUint32(data+offset, id);
-        offset += sizeof(uint32_t);
-
-        //Headset Color
-        writeUint32(data+offset, color);
-        offset+=sizeof(uint32_t);
-
-        //Tablet connected
-        data[offset++] = tabletConnected;
-
-        //Handedness
-        writeUint32(data+offset, handedness);
-        offset+=sizeof(uint32_t);
-
-        //Tablet ID
-        writeUint32(data+offset, tabletID);
-        offset += sizeof(uint32_t);
+        msg.pushUint32(id)              //Headset ID
+           .pushUint32(color)           //Headset Color
+           .pushByte(tabletConnected)   //Tablet connected
+           .pushUint32(handedness)      //Handedness
+           .pushUint32(tabletID);       //Tablet ID
 
         if(m_headsetAnchorClient == NULL)
         {
@@ -3799,11 +4650,10 @@ endFor:;
             if(firstConnected && client == headset) //Send only if we are discussing with the headset and not the tablet
                 m_headsetAnchorClient = headset;
         }
-        data[offset++] = firstConnected;
+        msg.pushByte(firstConnected);
         
         INFO << "Sending HEADSET BINDING INFO Event data\n";
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3845,19 +4695,11 @@ endFor:;
         //Send segment by segment
         for(auto& itSegment : m_anchorData.getSegmentData())
         {
-            uint8_t* data = (uint8_t*)malloc(sizeof(uint16_t)+sizeof(uint32_t));
-            uint32_t offset = 0;
-
-            //Header
-            writeUint16(data, VFV_SEND_HEADSET_ANCHOR_SEGMENT);
-            offset += sizeof(uint16_t);
-
-            writeUint32(data+offset, itSegment.dataSize);
-            offset += sizeof(uint32_t);
-
             //Header message
-            std::shared_ptr<uint8_t> sharedData(data, free);
-            SocketMessage<int> sm(client->socket, sharedData, offset);
+            VFVMessageBuilder msg(m_bufferPool, VFV_SEND_HEADSET_ANCHOR_SEGMENT, sizeof(uint32_t));
+            msg.pushUint32(itSegment.dataSize);
+
+            SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
             writeMessage(sm);
 
             //Segment message
@@ -3885,32 +4727,21 @@ endFor:;
     void VFVServer::sendSubDatasetLockOwner(SubDatasetMetaData* metaData)
     {
         //Generate the data
-        uint8_t* data   = (uint8_t*)malloc(sizeof(uint16_t) + 3*sizeof(uint32_t));
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_SUBDATASET_LOCK_OWNER);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, metaData->datasetID);
-        offset+= sizeof(uint32_t);
-
-        writeUint32(data+offset, metaData->sdID);
-        offset+= sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SUBDATASET_LOCK_OWNER, 3*sizeof(uint32_t));
+        msg.pushUint32(metaData->datasetID)
+           .pushUint32(metaData->sdID);
 
         uint32_t id = -1;
         if(metaData->hmdClient != NULL)
             id = metaData->hmdClient->getHeadsetData().id;
-        writeUint32(data+offset, id); 
-        offset+= sizeof(uint32_t);
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
+        msg.pushUint32(id);
 
         INFO << "Setting lock owner dataset ID " <<  metaData->datasetID << " sub dataset ID " << metaData->sdID << " headset ID" << id << std::endl;
 
         //Send the data
         for(auto it : m_clientTable)
         {
-            SocketMessage<int> sm(it.second->socket, sharedData, offset);
+            SocketMessage<int> sm(it.second->socket, msg.getData(), msg.getSize());
             writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3937,29 +4768,18 @@ endFor:;
     void VFVServer::sendSubDatasetOwner(VFVClientSocket* client, SubDatasetMetaData* metaData)
     {
         //Generate the data
-        uint8_t* data   = (uint8_t*)malloc(sizeof(uint16_t) + 3*sizeof(uint32_t));
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_SUBDATASET_OWNER);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, metaData->datasetID);
-        offset+= sizeof(uint32_t);
-
-        writeUint32(data+offset, metaData->sdID);
-        offset+= sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SUBDATASET_OWNER, 3*sizeof(uint32_t));
+        msg.pushUint32(metaData->datasetID)
+           .pushUint32(metaData->sdID);
 
         uint32_t id = -1;
         if(metaData->owner != NULL)
             id = metaData->owner->getHeadsetData().id;
-        writeUint32(data+offset, id); 
-        offset+= sizeof(uint32_t);
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
+        msg.pushUint32(id);
 
         INFO << "Setting owner dataset ID " <<  metaData->datasetID << " sub dataset ID " << metaData->sdID << " headset ID" << id << std::endl;
 
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -3977,25 +4797,13 @@ endFor:;
 
     void VFVServer::sendStartAnnotation(VFVClientSocket* client, const VFVStartAnnotation& startAnnot)
     {
-        uint8_t* data = (uint8_t*)malloc(sizeof(uint16_t) + 3*sizeof(uint32_t));
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_START_ANNOTATION);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, startAnnot.datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, startAnnot.subDatasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, startAnnot.pointingID);
-        offset += sizeof(uint32_t);
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_START_ANNOTATION, 3*sizeof(uint32_t));
+        msg.pushUint32(startAnnot.datasetID)
+           .pushUint32(startAnnot.subDatasetID)
+           .pushUint32(startAnnot.pointingID);
 
         INFO << "Sending start annotation \n";
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, startAnnot);
@@ -4003,59 +4811,29 @@ endFor:;
 
     void VFVServer::sendAnchorAnnotation(VFVClientSocket* client, const VFVAnchorAnnotation& anchorAnnot)
     {
-        uint8_t* data = (uint8_t*)malloc(sizeof(uint16_t) + 4*sizeof(uint32_t) + 3*sizeof(float));
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_ANCHOR_ANNOTATION);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, anchorAnnot.datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, anchorAnnot.subDatasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, anchorAnnot.annotationID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, anchorAnnot.headsetID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ANCHOR_ANNOTATION, 4*sizeof(uint32_t) + 3*sizeof(float));
+        msg.pushUint32(anchorAnnot.datasetID)
+           .pushUint32(anchorAnnot.subDatasetID)
+           .pushUint32(anchorAnnot.annotationID)
+           .pushUint32(anchorAnnot.headsetID);
 
         for(uint8_t i = 0; i < 3; i++)
-        {
-            writeFloat(data+offset, anchorAnnot.localPos[i]);
-            offset += sizeof(float);
-        }
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
+            msg.pushFloat(anchorAnnot.localPos[i]);
 
         INFO << "Sending anchor annotation " << anchorAnnot.localPos[0] << "x" << anchorAnnot.localPos[1] << "x" << anchorAnnot.localPos[2] << "\n";
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
         saveMessageSentToJSONLog(client, anchorAnnot);
     }
 
     void VFVServer::sendClearAnnotations(VFVClientSocket* client, const VFVClearAnnotations& clearAnnot)
     {
-        uint8_t* data = (uint8_t*)malloc(sizeof(uint16_t) + 2*sizeof(uint32_t));
-        uint32_t offset = 0;
-
-        //ID
-        writeUint16(data, VFV_SEND_CLEAR_ANNOTATION);
-        offset += sizeof(uint16_t);
-
-        //datasetID
-        writeUint32(data+offset, clearAnnot.datasetID);
-        offset += sizeof(uint32_t);
-
-        //subdatasetID
-        writeUint32(data+offset, clearAnnot.subDatasetID);
-        offset += sizeof(uint32_t);
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_CLEAR_ANNOTATION, 2*sizeof(uint32_t));
+        msg.pushUint32(clearAnnot.datasetID)     //datasetID
+           .pushUint32(clearAnnot.subDatasetID); //subdatasetID
 
         INFO << "Sending clear annotation \n";
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
         saveMessageSentToJSONLog(client, clearAnnot);
     }
@@ -4063,40 +4841,20 @@ endFor:;
     void VFVServer::sendLocationTablet(const glm::vec3& pos, const Quaternionf& rot, VFVClientSocket* client)
     {
         //Generate the data
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(float) + 4*sizeof(float);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        //Message ID
-        writeUint16(data, VFV_SEND_LOCATION);
-        offset += sizeof(uint16_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_LOCATION, 3*sizeof(float) + 4*sizeof(float));
 
         //Position
-        writeFloat(data+offset, pos.x);
-        offset += sizeof(float);
-        writeFloat(data+offset, pos.y);
-        offset += sizeof(float);
-        writeFloat(data+offset, pos.z);
-        offset += sizeof(float);
+        msg.pushFloat(pos.x).pushFloat(pos.y).pushFloat(pos.z);
 
         //Rotation
-        writeFloat(data+offset, rot.w);
-        offset += sizeof(float);
-        writeFloat(data+offset, rot.x);
-        offset += sizeof(float);
-        writeFloat(data+offset, rot.y);
-        offset += sizeof(float);
-        writeFloat(data+offset, rot.z);
-        offset += sizeof(float);
+        msg.pushFloat(rot.w).pushFloat(rot.x).pushFloat(rot.y).pushFloat(rot.z);
 
         //INFO << "Sending tablet location: "
         //     << "Tablet position: " << pos.x << " " << pos.y << " " << pos.z << "; "
         //     << "Tablet rotation: " << rot.w << " " << rot.x << " " << rot.y << " " << rot.z << std::endl;
         
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        
         //Send the data
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -4114,52 +4872,25 @@ endFor:;
 
     void VFVServer::sendAddNewSelectionInput(VFVClientSocket* client, const VFVAddNewSelectionInput& addInput)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        //Message ID
-        writeUint16(data, VFV_SEND_ADD_NEW_SELECTION_INPUT);
-        offset += sizeof(uint16_t);
-
         //Boolean operation in use
-        writeUint32(data+offset, addInput.booleanOp);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_NEW_SELECTION_INPUT, sizeof(uint32_t));
+        msg.pushUint32(addInput.booleanOp);
 
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        
         //Send the data
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
         saveMessageSentToJSONLog(client, addInput);
     }
 
     void VFVServer::sendToggleMapVisibility(VFVClientSocket* client, const VFVToggleMapVisibility& visibility)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 2*sizeof(uint32_t) + sizeof(uint8_t);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        //Message ID
-        writeUint16(data, VFV_SEND_TOGGLE_MAP_VISIBILITY);
-        offset += sizeof(uint16_t);
-
-        //Dataset ID
-        writeUint32(data+offset, visibility.datasetID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_TOGGLE_MAP_VISIBILITY, 2*sizeof(uint32_t) + sizeof(uint8_t));
+        msg.pushUint32(visibility.datasetID)            //Dataset ID
+           .pushUint32(visibility.subDatasetID)         //SubDataset ID
+           .pushByte(visibility.visibility ? 1 : 0);    //Visibility status
 
-        //SubDataset ID
-        writeUint32(data+offset, visibility.subDatasetID);
-        offset += sizeof(uint32_t);
-
-        //Visibility status
-        data[offset] = visibility.visibility ? 1 : 0;
-        offset++;
-
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        
         //Send the data
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
         
         saveMessageSentToJSONLog(client, visibility);
@@ -4168,25 +4899,13 @@ endFor:;
 
     void VFVServer::sendResetVolumetricSelection(VFVClientSocket* client, int datasetID, int sdID, int headsetID)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_RESET_VOLUMETRIC_SELECTION);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, sdID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, headsetID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_RESET_VOLUMETRIC_SELECTION, 3*sizeof(uint32_t));
+        msg.pushUint32(datasetID)
+           .pushUint32(sdID)
+           .pushUint32(headsetID);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
         
 #ifdef VFV_LOG_DATA
@@ -4204,30 +4923,16 @@ endFor:;
 
     void VFVServer::sendSetDrawableAnnotationPositionColor(VFVClientSocket* client, const VFVSetDrawableAnnotationPositionDefaultColor& color)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t) + sizeof(uint32_t);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_SET_DRAWABLE_ANNOTATION_POSITION_DEFAULT_COLOR);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, color.datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, color.subDatasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, color.drawableID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, color.color);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SET_DRAWABLE_ANNOTATION_POSITION_DEFAULT_COLOR, 3*sizeof(uint32_t) + sizeof(uint32_t));
+        msg.pushUint32(color.datasetID)
+           .pushUint32(color.subDatasetID)
+           .pushUint32(color.drawableID)
+           .pushUint32(color.color);
 
         INFO << "Set color..." << std::endl;
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, color);
@@ -4235,32 +4940,17 @@ endFor:;
 
     void VFVServer::sendSetDrawableAnnotationPositionIdx(VFVClientSocket* client, const VFVSetDrawableAnnotationPositionMappedIdx& idx)
     {
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SET_DRAWABLE_ANNOTATION_POSITION_MAPPED_IDX, 3*sizeof(uint32_t) + (1+idx.idx.size())*sizeof(uint32_t));
+        msg.pushUint32(idx.datasetID)
+           .pushUint32(idx.subDatasetID)
+           .pushUint32(idx.drawableID)
+           .pushUint32(idx.idx.size());
 
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t) + (1+idx.idx.size())*sizeof(uint32_t);
-        uint8_t* data = (uint8_t*)malloc(dataSize);
-        uint32_t offset = 0;
-
-        writeUint16(data, VFV_SEND_SET_DRAWABLE_ANNOTATION_POSITION_MAPPED_IDX);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, idx.datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, idx.subDatasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, idx.drawableID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, idx.idx.size());
-        offset += sizeof(uint32_t);
-
-        for(uint32_t i = 0; i < idx.idx.size(); i++, offset += sizeof(uint32_t))
-            writeUint32(data+offset, idx.idx[i]);
+        for(uint32_t i = 0; i < idx.idx.size(); i++)
+            msg.pushUint32(idx.idx[i]);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, idx);
@@ -4268,28 +4958,14 @@ endFor:;
 
     void VFVServer::sendAddSubjectiveViewGroup(VFVClientSocket* client, const VFVAddSubjectiveViewGroup& addSV)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint8_t) + 3*sizeof(uint32_t);
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_ADD_SUBJECTIVE_VIEW_GROUP);
-        offset += sizeof(uint16_t);
-
-        data[offset] = addSV.svType;
-        offset++;
-
-        writeUint32(data+offset, addSV.baseDatasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, addSV.baseSDID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, addSV.sdgID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_SUBJECTIVE_VIEW_GROUP, sizeof(uint8_t) + 3*sizeof(uint32_t));
+        msg.pushByte(addSV.svType)
+           .pushUint32(addSV.baseDatasetID)
+           .pushUint32(addSV.baseSDID)
+           .pushUint32(addSV.sdgID);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, addSV);
@@ -4297,28 +4973,14 @@ endFor:;
 
     void VFVServer::sendAddSubDatasetToSVStackedGroup(VFVClientSocket* client, SubDatasetGroupMetaData& sdgMD, uint32_t datasetID, uint32_t sdStackedID, uint32_t sdLinkedID)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 4*sizeof(uint32_t);
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_ADD_SD_TO_SV_STACKED_LINKED_GROUP);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, sdgMD.sdgID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, sdStackedID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, sdLinkedID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_ADD_SD_TO_SV_STACKED_LINKED_GROUP, 4*sizeof(uint32_t));
+        msg.pushUint32(sdgMD.sdgID)
+           .pushUint32(datasetID)
+           .pushUint32(sdStackedID)
+           .pushUint32(sdLinkedID);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -4337,28 +4999,14 @@ endFor:;
 
     void VFVServer::sendSVStackedGroupGlobalParameters(VFVClientSocket* client, const VFVSetSVStackedGroupGlobalParameters& params)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 2*sizeof(uint32_t) + sizeof(float) + 1;
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_SET_SV_STACKED_GLOBAL_PARAMETERS);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, params.sdgID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, params.stackMethod);
-        offset += sizeof(uint32_t);
-
-        writeFloat(data+offset, params.gap);
-        offset += sizeof(float);
-
-        data[offset] = params.merged;
-        offset++;
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SET_SV_STACKED_GLOBAL_PARAMETERS, 2*sizeof(uint32_t) + sizeof(float) + 1);
+        msg.pushUint32(params.sdgID)
+           .pushUint32(params.stackMethod)
+           .pushFloat(params.gap)
+           .pushByte(params.merged);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, params);
@@ -4366,19 +5014,11 @@ endFor:;
 
     void VFVServer::sendRemoveSubDatasetsGroup(VFVClientSocket* client, const VFVRemoveSubDatasetGroup& removeSDGroup)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 1*sizeof(uint32_t);
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_REMOVE_SUBDATASET_GROUP);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, removeSDGroup.sdgID);
-        offset += sizeof(uint32_t);
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_REMOVE_SUBDATASET_GROUP, 1*sizeof(uint32_t));
+        msg.pushUint32(removeSDGroup.sdgID);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, removeSDGroup);
@@ -4386,28 +5026,13 @@ endFor:;
 
     void VFVServer::sendRenameSubDataset(VFVClientSocket* client, const VFVRenameSubDataset& rename)
     {
-        uint32_t dataSize = sizeof(uint16_t) + 3*sizeof(uint32_t) + rename.name.size();
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_RENAME_SD);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, rename.datasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, rename.subDatasetID);
-        offset += sizeof(uint32_t);
-
-        writeUint32(data+offset, rename.name.size());
-        offset += sizeof(uint32_t);
-
-        memcpy(data+offset, rename.name.c_str(), rename.name.size());
-        offset += rename.name.size();
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_RENAME_SD, 3*sizeof(uint32_t) + rename.name.size());
+        msg.pushUint32(rename.datasetID)
+           .pushUint32(rename.subDatasetID)
+           .pushString(rename.name);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
         writeMessage(sm);
 
         saveMessageSentToJSONLog(client, rename);
@@ -4415,22 +5040,11 @@ endFor:;
 
     void VFVServer::sendMessageToDisplay(VFVClientSocket* client, const std::string& msg)
     {
-        uint32_t dataSize = sizeof(uint16_t) + sizeof(uint32_t) + msg.size();
-        uint8_t* data     = (uint8_t*)malloc(dataSize);
-        uint32_t offset   = 0;
-
-        writeUint16(data, VFV_SEND_DISPLAY_SHORT_MESSAGE);
-        offset += sizeof(uint16_t);
-
-        writeUint32(data+offset, msg.size());
-        offset += sizeof(uint32_t);
-
-        memcpy(data+offset, msg.c_str(), msg.size());
-        offset += msg.size();
+        VFVMessageBuilder builder(m_bufferPool, VFV_SEND_DISPLAY_SHORT_MESSAGE, sizeof(uint32_t) + msg.size());
+        builder.pushString(msg);
 
         //Send the data
-        std::shared_ptr<uint8_t> sharedData(data, free);
-        SocketMessage<int> sm(client->socket, sharedData, offset);
+        SocketMessage<int> sm(client->socket, builder.getData(), builder.getSize());
         writeMessage(sm);
 
 #ifdef VFV_LOG_DATA
@@ -4442,6 +5056,77 @@ endFor:;
 #endif
     }
 
+    void VFVServer::sendDatasetLoadingStatus(VFVClientSocket* client, uint32_t datasetID, const VFVDatasetLoading& loading, VFVDatasetLoadingStatus status)
+    {
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_DATASET_LOADING_STATUS, 4*sizeof(uint32_t) + loading.name.size() + 1);
+        msg.pushUint32(datasetID)                  //Dataset ID
+           .pushString(loading.name)               //Dataset name
+           .pushUint32(loading.nbLoadedTimesteps)  //Number of timesteps usable
+           .pushUint32(loading.nbTimesteps)        //Total number of timesteps
+           .pushByte(status);                      //Status
+
+        SocketMessage<int> sm(client->socket, msg.getData(), msg.getSize());
+        writeMessage(sm);
+    }
+
+    void VFVServer::sendSelectionProgress(const VFVSelectionJob& job, VFVSelectionStatus status)
+    {
+        if(job.headset == NULL)
+            return;
+
+        float progress = (job.meshes.empty() ? 1.0f : (float)job.nbMeshesDone / job.meshes.size());
+
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SELECTION_PROGRESS, 2*sizeof(uint32_t) + sizeof(float) + 1);
+        msg.pushUint32(job.datasetID)     //Dataset ID
+           .pushUint32(job.subDatasetID)  //SubDataset ID
+           .pushFloat(progress)           //Progress [0, 1]
+           .pushByte(status);             //Status
+
+        SocketMessage<int> sm(job.headset->socket, msg.getData(), msg.getSize());
+        writeMessage(sm);
+
+        VFVClientSocket* tablet = job.headset->getHeadsetData().tablet;
+        if(tablet)
+        {
+            SocketMessage<int> smTablet(tablet->socket, msg.getData(), msg.getSize());
+            writeMessage(smTablet);
+        }
+    }
+
+    void VFVServer::sendSelectionPreview(VFVClientSocket* headset, VFVSelectionPreviewState& state)
+    {
+        //The points of the preview, spread over the whole dataset by the octree. They stay the same as long as the preview points do: send them once
+        if(state.subset.empty())
+        {
+            state.preview->getOctree()->getSubset(SELECTION_PREVIEW_MAX_POINTS, state.subset);
+
+            VFVMessageBuilder msgPoints(m_bufferPool, VFV_SEND_SELECTION_PREVIEW_POINTS, 3*sizeof(uint32_t) + sizeof(uint32_t)*state.subset.size());
+            msgPoints.pushUint32(state.datasetID)         //Dataset ID
+                     .pushUint32(state.subDatasetID)      //SubDataset ID
+                     .pushUint32(state.subset.size());    //Number of points
+            for(uint32_t id : state.subset)
+                msgPoints.pushUint32(id*state.preview->getPointStride()); //The point ID in the dataset
+
+            SocketMessage<int> smPoints(headset->socket, msgPoints.getData(), msgPoints.getSize());
+            writeMessage(smPoints);
+        }
+
+        state.sentVersion = state.preview->getVersion();
+
+        std::vector<uint8_t> bits;
+        state.preview->getPreview(state.subset, bits);
+
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_SELECTION_PREVIEW, 4*sizeof(uint32_t) + bits.size());
+        msg.pushUint32(state.datasetID)                  //Dataset ID
+           .pushUint32(state.subDatasetID)               //SubDataset ID
+           .pushUint32(state.preview->getNbDatasetPoints())             //Number of points of the dataset
+           .pushUint32(bits.size())                      //Mask size
+           .pushBytes(bits.data(), bits.size());         //Mask
+
+        SocketMessage<int> sm(headset->socket, msg.getData(), msg.getSize());
+        writeMessage(sm);
+    }
+
     /*----------------------------------------------------------------------------*/
     /*---------------------OVERRIDED METHOD + ADDITIONAL ONES---------------------*/
     /*----------------------------------------------------------------------------*/
@@ -4479,12 +5164,14 @@ endFor:;
             switch(msg.type)
             {
                 case IDENT_TABLET:
+                case IDENT_TABLET_FRAMED:
                 {
                     loginTablet(client, msg.identTablet);
                     break;
                 }
 
                 case IDENT_HEADSET:
+                case IDENT_HEADSET_FRAMED:
                 {
                     loginHeadset(client);
                     break;
@@ -4498,7 +5185,7 @@ endFor:;
 
                 case ROTATE_DATASET:
                 {
-                    rotateSubDataset(client, msg.rotate);
+                    queueRotateSubDataset(client, msg.rotate);
                     break;
                 }
 
@@ -4515,7 +5202,7 @@ endFor:;
 
                 case ANCHORING_DATA_SEGMENT:
                 {
-                    std::lock_guard<std::mutex> lock(m_mapMutex);
+                    VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
                     if(m_headsetAnchorClient != client)
                     {
                         VFVSERVER_NOT_CORRECT_HEADSET
@@ -4529,13 +5216,13 @@ endFor:;
                 {
                     if(m_headsetAnchorClient != client)
                     {
-                        std::lock_guard<std::mutex> lock(m_mapMutex);
+                        VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
                         VFVSERVER_NOT_CORRECT_HEADSET
                         return;
                     }
                     INFO << "Receiving end of anchoring data : " << msg.anchoringDataStatus.succeed << std::endl;
-                    std::lock_guard<std::mutex> lock(m_datasetMutex); //No dataset must be touched while we transmit anchor data
-                    std::lock_guard<std::mutex> lockMap(m_mapMutex);
+                    VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats); //No dataset must be touched while we transmit anchor data
+                    VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
 
                     m_anchorData.finalize(msg.anchoringDataStatus.succeed);
 
@@ -4555,12 +5242,12 @@ endFor:;
                 }
                 case TRANSLATE_DATASET:
                 {
-                    translateSubDataset(client, msg.translate);
+                    queueTranslateSubDataset(client, msg.translate);
                     break;
                 }
                 case SCALE_DATASET:
                 {
-                    scaleSubDataset(client, msg.scale);
+                    queueScaleSubDataset(client, msg.scale);
                     break;
                 }
 
@@ -4573,7 +5260,7 @@ endFor:;
                 case HEADSET_CURRENT_ACTION:
                 {
                     //Look for the headset to modify
-                    std::lock_guard<std::mutex> lock(m_mapMutex);
+                    VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
                     VFVClientSocket* headset = getHeadsetFromClient(client);
                     if(!headset)
                         break;
@@ -4768,6 +5455,30 @@ endFor:;
                     break;
                 }
 
+                case CLIENT_FEATURES:
+                {
+                    onClientFeatures(client, msg.clientFeatures);
+                    break;
+                }
+
+                case CANCEL_SELECTION:
+                {
+                    onCancelSelection(client, msg.cancelSelection);
+                    break;
+                }
+
+                case SELECTION_PREVIEW:
+                {
+                    onSelectionPreview(client, msg.selectionPreview);
+                    break;
+                }
+
+                case VOLUMETRIC_MASK_RESYNC:
+                {
+                    onVolumetricMaskResync(client, msg.volumetricMaskResync);
+                    break;
+                }
+
                 default:
                     break;
             }
@@ -4775,13 +5486,176 @@ endFor:;
             continue;
         }
 
-
+        //The frames not pulled yet are views over "data", which is released once we return
+        client->detachFrames();
         return;
     clientError:
         closeClient(client->socket);
         return;
     }
 
+    bool VFVServer::generateHeadsetsStatusDelta(VFVClientSocket* client, const std::map<uint32_t, VFVHeadsetStatus>& headsetsStatus, VFVMessageBuilder& msg)
+    {
+        std::map<uint32_t, VFVHeadsetStatus>& sentStatus = client->getSentHeadsetsStatus();
+        bool quantized = client->hasFeature(CLIENT_FEATURE_QUANTIZED_ROTATION);
+
+        //Headsets which disconnected since the last message
+        uint32_t nbRemoved = 0;
+        msg.pushUint32(0); //Write NB_REMOVED later
+        for(auto it = sentStatus.begin(); it != sentStatus.end();)
+        {
+            if(headsetsStatus.find(it->first) == headsetsStatus.end())
+            {
+                msg.pushUint32(it->first);
+                it = sentStatus.erase(it);
+                nbRemoved++;
+            }
+            else
+                it++;
+        }
+        msg.setUint32At(sizeof(uint16_t), nbRemoved);
+
+        //Headsets which changed since the last message
+        uint32_t nbChanged = 0;
+        size_t   nbChangedOffset = msg.getSize();
+        msg.pushUint32(0); //Write NB_CHANGED later
+        for(auto& it : headsetsStatus)
+        {
+            const VFVHeadsetStatus& status = it.second;
+            auto sentIt = sentStatus.find(it.first);
+            bool isNew  = (sentIt == sentStatus.end());
+
+            uint8_t fields = 0;
+            if(isNew || sentIt->second.color != status.color)
+                fields |= HEADSET_STATUS_FIELD_COLOR;
+            if(isNew || sentIt->second.currentAction != status.currentAction)
+                fields |= HEADSET_STATUS_FIELD_CURRENT_ACTION;
+            if(isNew || !std::equal(status.position, status.position+3, sentIt->second.position))
+                fields |= HEADSET_STATUS_FIELD_POSITION;
+
+            uint8_t largestIdx = 0;
+            int16_t quantizedRot[3];
+            if(quantized)
+            {
+                quantizeQuaternion(status.rotation, &largestIdx, quantizedRot);
+                uint8_t sentLargestIdx = 0;
+                int16_t sentQuantizedRot[3];
+                if(!isNew)
+                    quantizeQuaternion(sentIt->second.rotation, &sentLargestIdx, sentQuantizedRot);
+                if(isNew || largestIdx != sentLargestIdx || !std::equal(quantizedRot, quantizedRot+3, sentQuantizedRot))
+                    fields |= HEADSET_STATUS_FIELD_ROTATION | HEADSET_STATUS_FIELD_QUANTIZED_ROTATION;
+            }
+            else if(isNew || !std::equal(status.rotation, status.rotation+4, sentIt->second.rotation))
+                fields |= HEADSET_STATUS_FIELD_ROTATION;
+
+            if(isNew || sentIt->second.pointingIT           != status.pointingIT           ||
+                        sentIt->second.pointingDatasetID    != status.pointingDatasetID    ||
+                        sentIt->second.pointingSubDatasetID != status.pointingSubDatasetID ||
+                        sentIt->second.pointingInPublic     != status.pointingInPublic     ||
+                        !std::equal(status.pointingPosition, status.pointingPosition+10, sentIt->second.pointingPosition))
+                fields |= HEADSET_STATUS_FIELD_POINTING;
+
+            if(fields == 0)
+                continue;
+
+            msg.pushUint32(it.first) //ID
+               .pushByte(fields);    //The fields following
+
+            if(fields & HEADSET_STATUS_FIELD_COLOR)
+                msg.pushUint32(status.color);
+            if(fields & HEADSET_STATUS_FIELD_CURRENT_ACTION)
+                msg.pushUint32(status.currentAction);
+            if(fields & HEADSET_STATUS_FIELD_POSITION)
+                for(uint32_t i = 0; i < 3; i++)
+                    msg.pushFloat(status.position[i]);
+            if(fields & HEADSET_STATUS_FIELD_QUANTIZED_ROTATION)
+            {
+                msg.pushByte(largestIdx);
+                for(uint32_t i = 0; i < 3; i++)
+                    msg.pushUint16((uint16_t)quantizedRot[i]);
+            }
+            else if(fields & HEADSET_STATUS_FIELD_ROTATION)
+                for(uint32_t i = 0; i < 4; i++)
+                    msg.pushFloat(status.rotation[i]);
+            if(fields & HEADSET_STATUS_FIELD_POINTING)
+                writeHeadsetPointingStatus(msg, status);
+
+            sentStatus[it.first] = status;
+            nbChanged++;
+        }
+        msg.setUint32At(nbChangedOffset, nbChanged);
+
+        return nbRemoved > 0 || nbChanged > 0;
+    }
+
+    VFVMessageBuilder VFVServer::generateHeadsetsStatus(const std::map<uint32_t, VFVHeadsetStatus>& headsetsStatus)
+    {
+        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_HEADSETS_STATUS, sizeof(uint32_t) + 
+                              headsetsStatus.size()*(7*sizeof(float) + 3*sizeof(uint32_t) + 3*sizeof(uint32_t) + 1 + 10*sizeof(float)));
+
+        msg.pushUint32(headsetsStatus.size()); //NB_HEADSET
+
+#ifdef LOG_UPDATE_HEAD
+#ifdef VFV_LOG_DATA
+        std::lock_guard<std::mutex> logLock(m_logMutex);
+        VFV_BEGINING_TO_JSON(m_log, VFV_SENDER_SERVER, "ALL:Broadcast", getTimeOffset(), "HeadsetStatus");
+        m_log << ",    \"status\" : [";
+        bool logAdded = false;
+#endif
+#endif
+
+        for(auto& it : headsetsStatus)
+        {
+            const VFVHeadsetStatus& status = it.second;
+
+            msg.pushUint32(it.first)              //ID
+               .pushUint32(status.color)          //Color
+               .pushUint32(status.currentAction); //Current action
+
+            //Position
+            for(uint32_t i = 0; i < 3; i++)
+                msg.pushFloat(status.position[i]);
+
+            //Rotation
+            for(uint32_t i = 0; i < 4; i++)
+                msg.pushFloat(status.rotation[i]);
+
+            writeHeadsetPointingStatus(msg, status);
+
+#ifdef LOG_UPDATE_HEAD
+#ifdef VFV_LOG_DATA
+            if(logAdded)
+                m_log << ", ";
+
+            m_log << "{\n"
+                  << "    \"id\" : " << it.first << ",\n"
+                  << "    \"color\" : " << status.color << ",\n"
+                  << "    \"currentAction\" : " << status.currentAction << ",\n"
+                  << "    \"position\" : [" << status.position[0] << ", " << status.position[1] << ", " << status.position[2] << "],\n"
+                  << "    \"rotation\" : [" << status.rotation[0] << ", " << status.rotation[1] << ", " << status.rotation[2] << ", " << status.rotation[3] << "],\n"
+                  << "    \"pointingIT\" : " << status.pointingIT << ",\n"
+                  << "    \"pointingDatasetID\" : " << status.pointingDatasetID << ",\n"
+                  << "    \"pointingSubDatasetID\" : " << status.pointingSubDatasetID << ",\n"
+                  << "    \"pointingInPublic\" : " << status.pointingInPublic << ",\n"
+                  << "    \"pointingLocalSDPosition\" : [" << status.pointingPosition[0] << "," << status.pointingPosition[1] << "," << status.pointingPosition[2] << "],\n"
+                  << "    \"pointingHeadsetStartPosition\" : [" << status.pointingPosition[3] << "," << status.pointingPosition[4] << "," << status.pointingPosition[5] << "],\n"
+                  << "    \"pointingHeadsetStartOrientation\" : [" << status.pointingPosition[6] << "," << status.pointingPosition[7] << "," << status.pointingPosition[8] << "," << status.pointingPosition[9] << "]\n"
+                  << "}\n";
+            logAdded = true;
+#endif
+#endif
+        }
+
+#ifdef LOG_UPDATE_HEAD
+#ifdef VFV_LOG_DATA
+        m_log << "]},\n";
+        m_log << std::flush;
+#endif
+#endif
+
+        return msg;
+    }
+
     void VFVServer::updateThread()
     {
         while(!m_closeThread)
@@ -4794,8 +5668,21 @@ endFor:;
 
             if(m_anchorData.isCompleted())
             {
-                std::lock_guard<std::mutex> lock2(m_datasetMutex);
-                std::lock_guard<std::mutex> lock(m_mapMutex);
+                //The headsets status do not depend on the datasets: do not wait for m_datasetMutex
+                VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
+
+                struct timespec tickBeg;
+                struct timespec tickEnd;
+                clock_gettime(CLOCK_MONOTONIC, &tickBeg);
+
+                //Read the status of every headset once
+                std::map<uint32_t, VFVHeadsetStatus> headsetsStatus;
+                for(auto& it : m_clientTable)
+                    if(it.second->isHeadset())
+                        readHeadsetStatus(it.second->getHeadsetData(), headsetsStatus[it.second->getHeadsetData().id]);
+
+                //The full HEADSETS_STATUS message is the same for every recipient: build it once
+                VFVMessageBuilder fullMsg = generateHeadsetsStatus(headsetsStatus);
 
                 //Send HEADSETS_STATUS
                 for(auto it : m_clientTable)
@@ -4804,117 +5691,63 @@ endFor:;
                         it.second->getBytesInWritting() > (1 << 16))
                         continue;
 
-                    uint8_t* data = (uint8_t*)malloc(sizeof(uint16_t) + sizeof(uint32_t) + 
-                                                     MAX_NB_HEADSETS*(7*sizeof(float) + 3*sizeof(uint32_t) + 3*sizeof(uint32_t) + 1 + 10*sizeof(float)));
-                    uint32_t offset    = 0;
-                    uint32_t nbHeadset = 0;
-
-                    //Type
-                    writeUint16(data+offset, VFV_SEND_HEADSETS_STATUS);
-                    offset += sizeof(uint16_t) + sizeof(uint32_t); //Write NB_HEADSET later
-#ifdef LOG_UPDATE_HEAD
-#ifdef VFV_LOG_DATA
-                    m_logMutex.lock();
-                    VFV_BEGINING_TO_JSON(m_log, VFV_SENDER_SERVER, getHeadsetIPAddr(it.second), getTimeOffset(), "HeadsetStatus");
-                    m_log << ",    \"status\" : [";
-                    m_log << std::flush;
-                    bool logAdded = false;
-#endif
-#endif
-                    for(auto& it2 : m_clientTable)
+                    //Send only what changed to the clients supporting it. 
+                    //Skipped clients (see above) keep their last sent status and will receive every change at once
+                    if(it.second->hasFeature(CLIENT_FEATURE_HEADSETS_STATUS_DELTA))
                     {
-                        if(it2.second->isHeadset())
+                        VFVMessageBuilder msg(m_bufferPool, VFV_SEND_HEADSETS_STATUS_DELTA, 2*sizeof(uint32_t) + 
+                                              headsetsStatus.size()*(2*sizeof(uint32_t) + 1 + 7*sizeof(float) + 3*sizeof(uint32_t) + 1 + 10*sizeof(float)));
+                        if(generateHeadsetsStatusDelta(it.second, headsetsStatus, msg))
                         {
-                            VFVHeadsetData& headsetData = it2.second->getHeadsetData();
-
-                            //ID
-                            writeUint32(data+offset, headsetData.id);
-                            offset += sizeof(uint32_t);
-
-                            //Color
-                            writeUint32(data+offset, headsetData.color);
-                            offset += sizeof(uint32_t);
-
-                            //Current action
-                            writeUint32(data+offset, headsetData.currentAction);
-                            offset += sizeof(uint32_t);
-
-                            //Position
-                            for(uint32_t i = 0; i < 3; i++, offset+=sizeof(float))
-                                writeFloat(data+offset, headsetData.position[i]);
-
-                            //Rotation
-                            for(uint32_t i = 0; i < 4; i++, offset+=sizeof(float))
-                                writeFloat(data+offset, headsetData.rotation[i]);
+                            SocketMessage<int> sm(it.first, msg.getData(), msg.getSize());
+                            writeMessage(sm);
+                        }
+                        continue;
+                    }
 
-                            //Pointing IT
-                            writeUint32(data+offset, headsetData.pointingData.pointingIT);
-                            offset += sizeof(uint32_t);
+                    //Share the buffer with every recipient
+                    SocketMessage<int> sm(it.first, fullMsg.getData(), fullMsg.getSize());
+                    writeMessage(sm);
+                }
 
-                            //Pointing Dataset ID
-                            writeUint32(data+offset, headsetData.pointingData.datasetID);
-                            offset += sizeof(uint32_t);
+                clock_gettime(CLOCK_MONOTONIC, &tickEnd);
 
-                            //Pointing SubDataset ID
-                            writeUint32(data+offset, headsetData.pointingData.subDatasetID);
-                            offset += sizeof(uint32_t);
+                //Progress of the volumetric selections being computed
+                {
+                    std::lock_guard<std::mutex> lockJobs(m_selectionJobsMutex);
+                    for(auto& it : m_selectionJobs)
+                        if(it.second->nbMeshesDone > 0)
+                            sendSelectionProgress(*it.second, SELECTION_STATUS_RUNNING);
+                }
 
-                            //Pointing done in public space?
-                            data[offset] = headsetData.pointingData.pointingInPublic ? 1 : 0;
-                            offset++;
+                m_headsetsStatusTiming.addSample((tickEnd.tv_sec - tickBeg.tv_sec)*1000000 + (tickEnd.tv_nsec - tickBeg.tv_nsec)/1000);
+            }
 
-                            //Pointing local SD position
-                            for(uint32_t i = 0; i < 3; i++, offset+=sizeof(float))
-                                writeFloat(data+offset, headsetData.pointingData.localSDPosition[i]);
+            //Live selection previews, at most SELECTION_PREVIEW_FRAMERATE times per second each
+            {
+                VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
 
-                            //Pointing headset starting position
-                            for(uint32_t i = 0; i < 3; i++, offset+=sizeof(float))
-                                writeFloat(data+offset, headsetData.pointingData.headsetStartPosition[i]);
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                uint64_t nowUS = now.tv_sec*1000000ull + now.tv_nsec/1000;
 
-                            //Pointing headset starting orientation
-                            for(uint32_t i = 0; i < 4; i++, offset+=sizeof(float))
-                                writeFloat(data+offset, headsetData.pointingData.headsetStartOrientation[i]);
+                for(auto& it : m_selectionPreviews)
+                {
+                    VFVSelectionPreviewState& state = it.second;
 
-#ifdef LOG_UPDATE_HEAD
-#ifdef VFV_LOG_DATA
-                            if(logAdded)
-                                m_log << ", ";
-
-                            m_log << "{\n"
-                                  << "    \"id\" : " << headsetData.id << ",\n"
-                                  << "    \"color\" : " << headsetData.color << ",\n"
-                                  << "    \"currentAction\" : " << headsetData.currentAction << ",\n"
-                                  << "    \"position\" : [" << headsetData.position[0] << ", " << headsetData.position[1] << ", " << headsetData.position[2] << "],\n"
-                                  << "    \"rotation\" : [" << headsetData.rotation[0] << ", " << headsetData.rotation[1] << ", " << headsetData.rotation[2] << ", " << headsetData.rotation[3] << "],\n"
-                                  << "    \"pointingIT\" : " << headsetData.pointingData.pointingIT << ",\n"
-                                  << "    \"pointingDatasetID\" : " << headsetData.pointingData.datasetID << ",\n"
-                                  << "    \"pointingSubDatasetID\" : " << headsetData.pointingData.subDatasetID << ",\n"
-                                  << "    \"pointingInPublic\" : " << headsetData.pointingData.pointingInPublic << ",\n"
-                                  << "    \"pointingLocalSDPosition\" : [" << headsetData.pointingData.localSDPosition[0] << "," << headsetData.pointingData.localSDPosition[1] << "," << headsetData.pointingData.localSDPosition[2] << "],\n"
-                                  << "    \"pointingHeadsetStartPosition\" : [" << headsetData.pointingData.headsetStartPosition[0] << "," << headsetData.pointingData.headsetStartPosition[1] << "," << headsetData.pointingData.headsetStartPosition[2] << "],\n"
-                                  << "    \"pointingHeadsetStartOrientation\" : [" << headsetData.pointingData.headsetStartOrientation[0] << "," << headsetData.pointingData.headsetStartOrientation[1] << "," << headsetData.pointingData.headsetStartOrientation[2] << "," << headsetData.pointingData.headsetStartOrientation[3] << "]\n"
-                                  << "}\n";
-                            logAdded = true;
-#endif
-#endif
-                            nbHeadset++;
-                        }
+                    //The slices could not be scheduled when they were pushed (the compute pool was full)
+                    if(state.preview->hasPending())
+                    {
+                        std::shared_ptr<VFVSelectionPreview> preview = state.preview;
+                        m_computePool.tryPush([preview]() {preview->processPending();}, TASK_PRIORITY_HIGH);
                     }
 
-#ifdef LOG_UPDATE_HEAD
-#ifdef VFV_LOG_DATA
-                    m_log << "]},\n";
-                    m_log << std::flush;
-                    m_logMutex.unlock();
-#endif
-#endif
-                    //Write the number of headset to take account of
-                    writeUint32(data+sizeof(uint16_t), nbHeadset);
+                    if(state.preview->getVersion() == state.sentVersion || nowUS - state.sentTime < 1000000/SELECTION_PREVIEW_FRAMERATE ||
+                       it.first->getBytesInWritting() > (1 << 16))
+                        continue;
 
-                    //Send the message to all
-                    std::shared_ptr<uint8_t> sharedData(data, free);
-                    SocketMessage<int> sm(it.first, sharedData, offset);
-                    writeMessage(sm);
+                    state.sentTime = nowUS;
+                    sendSelectionPreview(it.first, state);
                 }
             }
 
@@ -4923,8 +5756,8 @@ endFor:;
 
             //Check owner ending time
             {
-                std::lock_guard<std::mutex> lock2(m_datasetMutex);
-                std::lock_guard<std::mutex> lock(m_mapMutex);
+                VFVTimedLockGuard<std::shared_mutex> lock2(m_datasetMutex, m_datasetLockStats);
+                VFVTimedLockGuard<std::mutex> lock(m_mapMutex, m_mapLockStats);
 
                 auto f = [this, endTime](DatasetMetaData& mt)
                 {
@@ -4956,34 +5789,50 @@ endFor:;
         }
     }
 
-    void VFVServer::pushHeavy(const std::function<void(void)>& f)
+    void VFVServer::transformThread()
     {
-        std::unique_lock<std::mutex> lock(m_computeTasksMutex);
-        std::condition_variable cv;
+        while(!m_closeThread)
+        {
+            struct timespec beg;
+            struct timespec end;
+
+            clock_gettime(CLOCK_REALTIME, &beg);
+            flushTransforms();
+            runDeferredValuesTasks();
+            clock_gettime(CLOCK_REALTIME, &end);
 
-        while(cv.wait_for(lock, std::chrono::microseconds(1), [&](){return m_computeTasks.size() < 10;}));
-        m_computeTasks.push(f);
+            //Sleep
+            time_t endTime = end.tv_nsec*1.e-3 + end.tv_sec*1.e6;
+            usleep(std::max(0.0, 1.e6/TRANSFORM_FLUSH_FRAMERATE - endTime + (beg.tv_nsec*1.e-3 + beg.tv_sec*1.e6)));
+        }
     }
 
-    void VFVServer::computeThread()
+    void VFVServer::deferUntilValuesFree(const std::function<void(void)>& task)
     {
-        while(!m_closeThread)
-        {
-            std::unique_lock<std::mutex> lock(m_computeMutex);
-            m_computeCond.wait(lock, [&]() {return m_closeThread || !m_computeTasks.empty();});
+        std::lock_guard<std::mutex> lock(m_deferredValuesTasksMutex);
+        m_deferredValuesTasks.push_back(task);
+    }
 
-            m_computeTasksMutex.lock();
-            if(m_computeTasks.empty())
-            {
-                m_computeTasksMutex.unlock();
-                continue;
-            }
+    void VFVServer::runDeferredValuesTasks()
+    {
+        //Most ticks have nothing to retry: do not take the global locks for nothing
+        std::vector<std::function<void(void)>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(m_deferredValuesTasksMutex);
+            if(m_deferredValuesTasks.empty())
+                return;
+            tasks.swap(m_deferredValuesTasks);
+        }
 
-            auto f = m_computeTasks.front();
-            m_computeTasks.pop();
-            m_computeTasksMutex.unlock();
+        //In order: e.g., a mask update deferred after a reset. The tasks still waiting defer themselves again
+        VFVTimedLockGuard<std::shared_mutex> lock(m_datasetMutex, m_datasetLockStats);
+        VFVTimedLockGuard<std::mutex> lockMap(m_mapMutex, m_mapLockStats);
+        for(auto& task : tasks)
+            task();
+    }
 
-            f();
-        }
+    bool VFVServer::pushHeavy(const std::function<void(void)>& f, VFVTaskPriority priority)
+    {
+        return m_computePool.push(f, priority);
     }
 }
@@ -0,0 +1,49 @@
+#include "VFVTimeSeries.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace sereno
+{
+    bool compareTimestepSuffixes(const std::string& a, const std::string& b)
+    {
+        //Ignore the leading zeros: the longest number is then the greatest
+        size_t zerosA = std::min(a.find_first_not_of('0'), a.size());
+        size_t zerosB = std::min(b.find_first_not_of('0'), b.size());
+        if(a.size()-zerosA != b.size()-zerosB)
+            return a.size()-zerosA < b.size()-zerosB;
+
+        int cmp = a.compare(zerosA, std::string::npos, b, zerosB, std::string::npos);
+        if(cmp != 0)
+            return cmp < 0;
+        return a < b; //Same number: keep a stable order ("01" < "1")
+    }
+
+    bool getTimeSeriesSuffixes(const std::string& directory, const std::string& name, std::vector<std::string>& suffixes)
+    {
+        std::filesystem::path path     = std::filesystem::path(directory) / name;
+        std::string           prefix   = path.filename().string() + ".";
+        std::filesystem::path parent   = path.parent_path();
+
+        std::error_code error;
+        std::filesystem::directory_iterator it(parent.empty() ? std::filesystem::path(".") : parent, error);
+        if(error)
+            return false;
+
+        for(; it != std::filesystem::directory_iterator(); it.increment(error))
+        {
+            if(error)
+                return false;
+
+            std::string fileName = it->path().filename().string();
+            if(fileName.size() <= prefix.size() || fileName.compare(0, prefix.size(), prefix) != 0)
+                continue;
+
+            std::string suffix = fileName.substr(prefix.size());
+            if(std::all_of(suffix.begin(), suffix.end(), [](char c) {return c >= '0' && c <= '9';}))
+                suffixes.push_back(suffix);
+        }
+
+        std::sort(suffixes.begin(), suffixes.end(), &compareTimestepSuffixes);
+        return true;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef  VFVTEST_INC
+#define  VFVTEST_INC
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+
+/* \brief Check a condition of a test. Print the failure and count it if the condition is false */
+#define VFV_CHECK(cond) sereno::checkTest((cond), #cond, __FILE__, __LINE__)
+
+namespace sereno
+{
+    /** \brief  Get the number of failed checks of the running test
+     * \return   a reference to the counter */
+    inline uint32_t& getNbTestFailures()
+    {
+        static uint32_t nbFailures = 0;
+        return nbFailures;
+    }
+
+    /** \brief  Check a condition of a test. See VFV_CHECK
+     * \param cond the condition
+     * \param text the condition, as written
+     * \param file the source file
+     * \param line the source line
+     * \return   cond */
+    inline bool checkTest(bool cond, const char* text, const char* file, int line)
+    {
+        if(!cond)
+        {
+            std::cerr << file << ":" << line << ": check failed: " << text << std::endl;
+            getNbTestFailures()++;
+        }
+        return cond;
+    }
+
+    /** \brief  Get the exit code of the test, to return from main
+     * \return   EXIT_SUCCESS if every check passed, EXIT_FAILURE otherwise */
+    inline int getTestResult()
+    {
+        if(getNbTestFailures())
+            std::cerr << getNbTestFailures() << " check(s) failed" << std::endl;
+        return getNbTestFailures() ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef  VFVTESTMESH_INC
+#define  VFVTESTMESH_INC
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+namespace sereno
+{
+    /** \brief  A closed mesh, as read by VFVPointInMesh::setMesh */
+    struct TestMesh
+    {
+        struct Point
+        {
+            double x, y, z;
+        };
+        std::vector<Point>    points;    /*!< The vertices*/
+        std::vector<uint32_t> triangles; /*!< Three vertex indices per triangle*/
+
+        /** \brief  Add a quad as two triangles, split along the diagonal a-c */
+        void addQuad(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+        {
+            triangles.insert(triangles.end(), {a, b, c, a, c, d});
+        }
+
+        /** \brief  Scale then translate every vertex
+         * \param scale the scaling factor
+         * \param tx the translation along X
+         * \param ty the translation along Y
+         * \param tz the translation along Z */
+        void transform(double scale, double tx, double ty, double tz)
+        {
+            for(Point& p : points)
+                p = {p.x*scale + tx, p.y*scale + ty, p.z*scale + tz};
+        }
+    };
+
+    /** \brief  Generate a torus around the Z axis
+     * \param R the radius of the center circle
+     * \param r the radius of the tube
+     * \param n the number of segments along each circle
+     * \return   the mesh */
+    inline TestMesh generateTorus(double R, double r, uint32_t n)
+    {
+        TestMesh mesh;
+        for(uint32_t i = 0; i < n; i++)
+            for(uint32_t j = 0; j < n; j++)
+            {
+                double u = 2.0*M_PI*i/n, v = 2.0*M_PI*j/n;
+                mesh.points.push_back({(R + r*std::cos(v))*std::cos(u), (R + r*std::cos(v))*std::sin(u), r*std::sin(v)});
+            }
+        for(uint32_t i = 0; i < n; i++)
+            for(uint32_t j = 0; j < n; j++)
+                mesh.addQuad(i*n+j, ((i+1)%n)*n+j, ((i+1)%n)*n+(j+1)%n, i*n+(j+1)%n);
+        return mesh;
+    }
+
+    /** \brief  Generate the cube [0, 1]^3. Every face is split along the diagonal going through its corner the closest to the origin
+     * \return   the mesh */
+    inline TestMesh generateCube()
+    {
+        TestMesh mesh;
+        for(uint32_t i = 0; i < 8; i++)
+            mesh.points.push_back({(double)(i&1), (double)((i>>1)&1), (double)((i>>2)&1)});
+        mesh.addQuad(0, 2, 6, 4); //x == 0
+        mesh.addQuad(1, 5, 7, 3); //x == 1
+        mesh.addQuad(0, 4, 5, 1); //y == 0
+        mesh.addQuad(2, 3, 7, 6); //y == 1
+        mesh.addQuad(0, 1, 3, 2); //z == 0
+        mesh.addQuad(4, 6, 7, 5); //z == 1
+        return mesh;
+    }
+}
+
+#endif
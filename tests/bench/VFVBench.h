@@ -0,0 +1,47 @@
+#ifndef  VFVBENCH_INC
+#define  VFVBENCH_INC
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+
+namespace sereno
+{
+    /** \brief  Run a function several times and print its best duration
+     * \param name the name to print
+     * \param nbRuns the number of runs
+     * \param f the function to measure
+     * \return   the best duration, in milliseconds */
+    template<typename F>
+    double benchmark(const std::string& name, uint32_t nbRuns, F f)
+    {
+        double best = -1.0;
+        for(uint32_t i = 0; i < nbRuns; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            double duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if(best < 0 || duration < best)
+                best = duration;
+        }
+
+        std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(3) << std::setw(12) << best << " ms" << std::endl;
+        return best;
+    }
+
+    /** \brief  Get a size parameter of a benchmark from the command line
+     * \param argc the number of arguments
+     * \param argv the arguments
+     * \param defaultValue the value to use if no argument is given
+     * \return   the first argument as a number, or defaultValue */
+    inline size_t getBenchSize(int argc, char** argv, size_t defaultValue)
+    {
+        if(argc > 1)
+            return std::strtoull(argv[1], NULL, 10);
+        return defaultValue;
+    }
+}
+
+#endif
@@ -0,0 +1,245 @@
+/* Benchmark of the field decoding of VFVClientSocket::feedMessage:
+ * the byte per byte VFVBufferValue pushes it used, against the chunked pushes and the direct decoding of the fields not split between two segments.
+ * The stream mimics a busy session: UPDATE_HEADSET-like messages and lassos, cut in TCP segments.
+ * Usage: benchFieldDecoding [nbMessages] */
+
+#include <vector>
+#include <random>
+#include <functional>
+#include "VFVBufferValue.h"
+#include "readData.h"
+#include "writeData.h"
+#include "VFVBench.h"
+
+using namespace sereno;
+
+/* \brief The size of the TCP segments the stream is cut in */
+#define BENCH_SEGMENT_SIZE 1460
+
+/** \brief  The types of the fields of the stream */
+enum FieldType
+{
+    FIELD_UINT16,
+    FIELD_UINT32,
+    FIELD_FLOAT
+};
+
+/** \brief  A stream of fields, as received */
+struct FieldStream
+{
+    std::vector<FieldType> fields; /*!< The fields, in order*/
+    std::vector<uint8_t>   data;   /*!< The serialized fields*/
+};
+
+/** \brief  Generate the stream
+ * \param nbMessages the number of messages
+ * \return   the stream */
+static FieldStream generateStream(size_t nbMessages)
+{
+    FieldStream stream;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    uint8_t buf[4];
+
+    auto pushUint16 = [&](uint16_t v) {writeUint16(buf, v); stream.data.insert(stream.data.end(), buf, buf+2); stream.fields.push_back(FIELD_UINT16);};
+    auto pushUint32 = [&](uint32_t v) {writeUint32(buf, v); stream.data.insert(stream.data.end(), buf, buf+4); stream.fields.push_back(FIELD_UINT32);};
+    auto pushFloat  = [&](float v)    {writeFloat(buf, v);  stream.data.insert(stream.data.end(), buf, buf+4); stream.fields.push_back(FIELD_FLOAT);};
+
+    for(size_t i = 0; i < nbMessages; i++)
+    {
+        //One lasso every 64 messages, headset updates otherwise
+        if(i%64 == 63)
+        {
+            pushUint16(1);
+            pushUint32(300);
+            for(uint32_t j = 0; j < 300; j++)
+                pushFloat(dist(rng));
+        }
+        else
+        {
+            pushUint16(2);
+            for(uint32_t j = 0; j < 7; j++) //Position + rotation
+                pushFloat(dist(rng));
+            pushUint32(i);                  //Pointing technique, etc.
+            for(uint32_t j = 0; j < 6; j++) //Pointing positions
+                pushFloat(dist(rng));
+        }
+    }
+    return stream;
+}
+
+/** \brief  The incremental decoder state, shared by the three decoders */
+struct Decoder
+{
+    VFVBufferValue<uint16_t> uint16Buffer;
+    VFVBufferValue<uint32_t> uint32Buffer;
+    VFVBufferValue<float>    floatBuffer;
+    size_t                   field = 0;   /*!< The field being decoded*/
+    double                   sum   = 0.0; /*!< The sum of the decoded values*/
+};
+
+/** \brief  Decode one segment byte per byte (the previous VFVClientSocket::feedMessage)
+ * \param stream the stream
+ * \param d the decoder
+ * \param message the segment
+ * \param size the segment size */
+static void decodeBytePerByte(const FieldStream& stream, Decoder& d, const uint8_t* message, uint32_t size)
+{
+    for(; size > 0; message++, size--)
+    {
+        switch(stream.fields[d.field])
+        {
+            case FIELD_UINT16:
+                d.uint16Buffer.pushValue(*message);
+                if(d.uint16Buffer.isFull())
+                {
+                    d.sum += d.uint16Buffer.getValue();
+                    d.uint16Buffer.clear();
+                    d.field++;
+                }
+                break;
+            case FIELD_UINT32:
+                d.uint32Buffer.pushValue(*message);
+                if(d.uint32Buffer.isFull())
+                {
+                    d.sum += d.uint32Buffer.getValue();
+                    d.uint32Buffer.clear();
+                    d.field++;
+                }
+                break;
+            case FIELD_FLOAT:
+                d.floatBuffer.pushValue(*message);
+                if(d.floatBuffer.isFull())
+                {
+                    d.sum += d.floatBuffer.getValue();
+                    d.floatBuffer.clear();
+                    d.field++;
+                }
+                break;
+        }
+    }
+}
+
+/** \brief  Push as many bytes as possible of the current field
+ * \param buffer the buffer of the field
+ * \param d the decoder
+ * \param message[in, out] the segment, advanced
+ * \param size[in, out] the remaining segment size */
+template<typename T>
+static void pushChunk(VFVBufferValue<T>& buffer, Decoder& d, const uint8_t*& message, uint32_t& size)
+{
+    uint32_t nbPushed = buffer.pushValues(message, size);
+    message += nbPushed;
+    size    -= nbPushed;
+    if(buffer.isFull())
+    {
+        d.sum += buffer.getValue();
+        buffer.clear();
+        d.field++;
+    }
+}
+
+/** \brief  Decode one segment with chunked pushes
+ * \param stream the stream
+ * \param d the decoder
+ * \param message the segment
+ * \param size the segment size */
+static void decodeChunked(const FieldStream& stream, Decoder& d, const uint8_t* message, uint32_t size)
+{
+    while(size > 0)
+    {
+        switch(stream.fields[d.field])
+        {
+            case FIELD_UINT16:
+                pushChunk(d.uint16Buffer, d, message, size);
+                break;
+            case FIELD_UINT32:
+                pushChunk(d.uint32Buffer, d, message, size);
+                break;
+            case FIELD_FLOAT:
+                pushChunk(d.floatBuffer, d, message, size);
+                break;
+        }
+    }
+}
+
+/** \brief  Decode one segment, reading the fields directly when they are not split between two segments (the current VFVClientSocket::feedMessage)
+ * \param stream the stream
+ * \param d the decoder
+ * \param message the segment
+ * \param size the segment size */
+static void decodeFastPath(const FieldStream& stream, Decoder& d, const uint8_t* message, uint32_t size)
+{
+    while(size > 0)
+    {
+        switch(stream.fields[d.field])
+        {
+            case FIELD_UINT16:
+                if(d.uint16Buffer.buffer.empty() && size >= sizeof(uint16_t))
+                {
+                    d.sum += readUint16(message);
+                    message += sizeof(uint16_t);
+                    size    -= sizeof(uint16_t);
+                    d.field++;
+                }
+                else
+                    pushChunk(d.uint16Buffer, d, message, size);
+                break;
+            case FIELD_UINT32:
+                if(d.uint32Buffer.buffer.empty() && size >= sizeof(uint32_t))
+                {
+                    d.sum += readUint32(message);
+                    message += sizeof(uint32_t);
+                    size    -= sizeof(uint32_t);
+                    d.field++;
+                }
+                else
+                    pushChunk(d.uint32Buffer, d, message, size);
+                break;
+            case FIELD_FLOAT:
+                if(d.floatBuffer.buffer.empty() && size >= sizeof(float))
+                {
+                    d.sum += readFloat(message);
+                    message += sizeof(float);
+                    size    -= sizeof(float);
+                    d.field++;
+                }
+                else
+                    pushChunk(d.floatBuffer, d, message, size);
+                break;
+        }
+    }
+}
+
+/** \brief  Decode the whole stream, segment per segment
+ * \param stream the stream
+ * \param decode the decoding function
+ * \return   the sum of the decoded values */
+static double decodeStream(const FieldStream& stream, void (*decode)(const FieldStream&, Decoder&, const uint8_t*, uint32_t))
+{
+    Decoder d;
+    for(size_t offset = 0; offset < stream.data.size(); offset += BENCH_SEGMENT_SIZE)
+        decode(stream, d, stream.data.data()+offset, std::min((size_t)BENCH_SEGMENT_SIZE, stream.data.size()-offset));
+    if(d.field != stream.fields.size())
+        return -1.0;
+    return d.sum;
+}
+
+int main(int argc, char** argv)
+{
+    size_t nbMessages = getBenchSize(argc, argv, 200000);
+    FieldStream stream = generateStream(nbMessages);
+    std::cout << nbMessages << " messages, " << stream.fields.size() << " fields, " << stream.data.size() << " bytes" << std::endl;
+
+    double sums[3];
+    benchmark("Byte per byte VFVBufferValue::pushValue", 5, [&]() {sums[0] = decodeStream(stream, &decodeBytePerByte);});
+    benchmark("Chunked VFVBufferValue::pushValues",      5, [&]() {sums[1] = decodeStream(stream, &decodeChunked);});
+    benchmark("Direct decoding of contiguous fields",    5, [&]() {sums[2] = decodeStream(stream, &decodeFastPath);});
+
+    if(sums[0] < 0 || sums[0] != sums[1] || sums[0] != sums[2])
+    {
+        std::cerr << "The decoders disagree: " << sums[0] << " " << sums[1] << " " << sums[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
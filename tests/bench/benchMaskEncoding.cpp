@@ -0,0 +1,147 @@
+/* Benchmark of the volumetric mask encoding (VFV_SEND_VOLUMETRIC_MASK_ENCODED): the time spent choosing and encoding
+ * against the bytes it saves over the raw mask (VFV_SEND_VOLUMETRIC_MASK), on the masks the selections produce.
+ * Every encoded mask is decoded back and compared to the original one.
+ * Usage: benchMaskEncoding [gridSize] (the masks have gridSize^3 points) */
+
+#include <vector>
+#include <random>
+#include <functional>
+#include <cmath>
+#include "VFVMaskEncoding.h"
+#include "VFVBench.h"
+
+using namespace sereno;
+
+/* \brief The link speed used to convert the saved bytes to a transfer time, in bytes per millisecond (100 Mbit/s, a busy Wi-Fi network) */
+#define BENCH_LINK_BYTES_PER_MS 12500.0
+
+/** \brief  Read a LEB128 varint
+ * \param in the encoded data
+ * \param offset[in, out] where to read, advanced
+ * \return   the value */
+static uint64_t readVarint(const uint8_t* in, size_t& offset)
+{
+    uint64_t value = 0;
+    for(uint32_t shift = 0; ; shift += 7)
+    {
+        uint8_t b = in[offset++];
+        value |= (uint64_t)(b & 0x7f) << shift;
+        if(!(b & 0x80))
+            return value;
+    }
+}
+
+/** \brief  Decode a mask, as the clients do
+ * \param in the encoded mask
+ * \param encodedSize its size
+ * \param encoding its encoding
+ * \param size the mask size in bytes
+ * \return   the mask */
+static std::vector<uint8_t> decodeMask(const uint8_t* in, size_t encodedSize, VFVMaskEncoding encoding, size_t size)
+{
+    std::vector<uint8_t> mask;
+    size_t offset = 0;
+    switch(encoding)
+    {
+        case VFV_MASK_ENCODING_RAW:
+            mask.assign(in, in+encodedSize);
+            break;
+        case VFV_MASK_ENCODING_BITS:
+            for(size_t i = 0; i < size; i++)
+                mask.push_back((in[i/8] >> (i%8)) & 1);
+            break;
+        case VFV_MASK_ENCODING_BITS_RLE:
+            for(uint8_t value = 0; offset < encodedSize; value = !value)
+                mask.insert(mask.end(), readVarint(in, offset), value);
+            break;
+        case VFV_MASK_ENCODING_BYTES_RLE:
+            while(offset < encodedSize)
+            {
+                uint8_t value = in[offset++];
+                mask.insert(mask.end(), readVarint(in, offset), value);
+            }
+            break;
+    }
+    return mask;
+}
+
+/** \brief  Get the name of an encoding
+ * \param encoding the encoding
+ * \return   its name */
+static const char* getEncodingName(VFVMaskEncoding encoding)
+{
+    switch(encoding)
+    {
+        case VFV_MASK_ENCODING_RAW:       return "RAW";
+        case VFV_MASK_ENCODING_BITS:      return "BITS";
+        case VFV_MASK_ENCODING_BITS_RLE:  return "BITS_RLE";
+        case VFV_MASK_ENCODING_BYTES_RLE: return "BYTES_RLE";
+    }
+    return "?";
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n    = getBenchSize(argc, argv, 256);
+    const size_t size = n*n*n;
+    std::cout << size << " points (" << n << "^3 grid)" << std::endl;
+
+    //The masks, one byte per point, the points of a grid being ordered X first as in a VTK dataset
+    std::mt19937 rng(1);
+    auto gridMask = [&](const std::function<bool(float, float, float)>& selected)
+    {
+        std::vector<uint8_t> mask(size);
+        for(size_t z = 0, i = 0; z < n; z++)
+            for(size_t y = 0; y < n; y++)
+                for(size_t x = 0; x < n; x++, i++)
+                    mask[i] = selected((float)x/n - 0.5f, (float)y/n - 0.5f, (float)z/n - 0.5f);
+        return mask;
+    };
+    auto randomMask = [&](float ratio)
+    {
+        std::bernoulli_distribution dist(ratio);
+        std::vector<uint8_t> mask(size);
+        for(uint8_t& v : mask)
+            v = dist(rng);
+        return mask;
+    };
+
+    const std::vector<std::pair<std::string, std::vector<uint8_t>>> masks = {
+        {"Empty (reset)",                    std::vector<uint8_t>(size, 0)},
+        {"Sphere, grid",                     gridMask([](float x, float y, float z) {return x*x + y*y + z*z < 0.09f;})},
+        {"Slab, grid",                       gridMask([](float, float, float z) {return z > -0.1f && z < 0.1f;})},
+        {"Brush tube, grid",                 gridMask([](float x, float y, float z) {float r = std::sqrt(x*x + y*y) - 0.3f; return r*r + z*z < 0.01f;})},
+        {"Scattered selection, cloud (20%)", randomMask(0.2f)},
+        {"Small selection, cloud (1%)",      randomMask(0.01f)},
+    };
+
+    bool valid = true;
+    for(const auto& it : masks)
+    {
+        const std::vector<uint8_t>& mask = it.second;
+        std::cout << "--- " << it.first << std::endl;
+
+        size_t          encodedSize = 0;
+        VFVMaskEncoding encoding    = VFV_MASK_ENCODING_RAW;
+        std::vector<uint8_t> encoded;
+        double raw  = benchmark("Raw copy (VFV_SEND_VOLUMETRIC_MASK)", 5, [&]() {encoded.assign(mask.begin(), mask.end());});
+        double time = benchmark("chooseMaskEncoding + encodeMask",     5, [&]()
+        {
+            encoding = chooseMaskEncoding(mask.data(), size, &encodedSize);
+            encoded.resize(encodedSize);
+            encodeMask(mask.data(), size, encoding, encoded.data());
+        });
+
+        double savedMS = (double)(size - encodedSize)/BENCH_LINK_BYTES_PER_MS;
+        std::cout << getEncodingName(encoding) << ": " << encodedSize << " bytes (" << std::setprecision(2) << 100.0*encodedSize/size << "% of the raw mask), "
+                  << std::setprecision(3) << time - raw << " ms spent to save " << savedMS << " ms of transfer at 100 Mbit/s" << std::endl;
+
+        if(decodeMask(encoded.data(), encodedSize, encoding, size) != mask)
+        {
+            std::cerr << "The decoded mask differs from the original one" << std::endl;
+            valid = false;
+        }
+    }
+
+    return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
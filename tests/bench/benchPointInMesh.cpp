@@ -0,0 +1,161 @@
+/* Benchmark of VFVPointInMesh::compute, as used by the confirmed cloud point selections:
+ * a tangible brush-like mesh (a star-shaped lasso extruded along a spring) tested against a point cloud generated like new_gen_spring.py
+ * (particles on a spring surrounded by uniform noise), with every instruction set the CPU supports,
+ * then through evaluateSelection with and without the octree (in the calling thread).
+ * Usage: benchPointInMesh [nbPoints] */
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include "VFVPointInMesh.h"
+#include "VFVSelectionEvaluator.h"
+#include "VFVBench.h"
+
+using namespace sereno;
+
+/* \brief The number of lasso points of the mesh */
+#define BENCH_LASSO_SIZE 24
+
+/* \brief The number of lasso positions along the spring */
+#define BENCH_NB_RINGS 300
+
+/* \brief The spring of new_gen_spring.py: radius of the tube, radius of the turns, length and number of turns */
+#define BENCH_SPRING_SMALL_RADIUS 0.10f
+#define BENCH_SPRING_BIG_RADIUS   0.25f
+#define BENCH_SPRING_LENGTH       1.0f
+#define BENCH_SPRING_NB_ROUNDS    3
+
+/* \brief The height gained by the spring per half turn (P in new_gen_spring.py) */
+#define BENCH_SPRING_PITCH ((BENCH_SPRING_LENGTH-BENCH_SPRING_SMALL_RADIUS)/(2*BENCH_SPRING_NB_ROUNDS))
+
+/* \brief The number of noise particles per spring particle (40000 for 100000 in new_gen_spring.py) */
+#define BENCH_NOISE_RATIO 0.4f
+
+/** \brief  A closed mesh, as read by VFVPointInMesh::setMesh */
+struct BenchMesh
+{
+    struct Point
+    {
+        float x, y, z;
+    };
+    std::vector<Point>    points;    /*!< The vertices*/
+    std::vector<uint32_t> triangles; /*!< Three vertex indices per triangle*/
+};
+
+/** \brief  Generate a star-shaped lasso extruded along the spring of the particles, closed by a fan on both ends.
+ * The lasso is about as big as the spring tube: the mesh takes most of the spring particles and a few of the noise ones
+ * \return   the mesh */
+static BenchMesh generateSpring()
+{
+    BenchMesh mesh;
+    for(uint32_t r = 0; r < BENCH_NB_RINGS; r++)
+    {
+        float t  = 2.0f*BENCH_SPRING_NB_ROUNDS*(float)M_PI*r/(BENCH_NB_RINGS-1);
+        float cx = BENCH_SPRING_BIG_RADIUS*std::cos(t);
+        float cy = BENCH_SPRING_BIG_RADIUS*std::sin(t);
+        float cz = BENCH_SPRING_PITCH*t/(float)M_PI;
+        for(uint32_t i = 0; i < BENCH_LASSO_SIZE; i++)
+        {
+            float a      = 2.0f*(float)M_PI*i/BENCH_LASSO_SIZE;
+            float radius = (i%2 ? 0.10f : 0.14f);
+            //The lasso lies in the plane spanned by the radial direction and Z
+            mesh.points.push_back({cx + radius*std::cos(a)*std::cos(t), cy + radius*std::cos(a)*std::sin(t), cz + radius*std::sin(a)});
+        }
+    }
+
+    for(uint32_t r = 0; r+1 < BENCH_NB_RINGS; r++)
+    {
+        for(uint32_t i = 0; i < BENCH_LASSO_SIZE; i++)
+        {
+            uint32_t a = r*BENCH_LASSO_SIZE + i;
+            uint32_t b = r*BENCH_LASSO_SIZE + (i+1)%BENCH_LASSO_SIZE;
+            mesh.triangles.insert(mesh.triangles.end(), {a, b, b+BENCH_LASSO_SIZE, a, b+BENCH_LASSO_SIZE, a+BENCH_LASSO_SIZE});
+        }
+    }
+
+    //The caps: a fan around the center of the first and last lassos
+    for(uint32_t r : {0u, (uint32_t)BENCH_NB_RINGS-1})
+    {
+        BenchMesh::Point center = {0.0f, 0.0f, 0.0f};
+        for(uint32_t i = 0; i < BENCH_LASSO_SIZE; i++)
+        {
+            center.x += mesh.points[r*BENCH_LASSO_SIZE+i].x/BENCH_LASSO_SIZE;
+            center.y += mesh.points[r*BENCH_LASSO_SIZE+i].y/BENCH_LASSO_SIZE;
+            center.z += mesh.points[r*BENCH_LASSO_SIZE+i].z/BENCH_LASSO_SIZE;
+        }
+        uint32_t centerID = mesh.points.size();
+        mesh.points.push_back(center);
+        for(uint32_t i = 0; i < BENCH_LASSO_SIZE; i++)
+            mesh.triangles.insert(mesh.triangles.end(), {centerID, r*BENCH_LASSO_SIZE + (i+1)%BENCH_LASSO_SIZE, r*BENCH_LASSO_SIZE + i});
+    }
+    return mesh;
+}
+
+int main(int argc, char** argv)
+{
+    size_t nbPoints = getBenchSize(argc, argv, 10000000);
+
+    //The particles of new_gen_spring.py: the noise first, then the spring
+    VFVPointCloud cloud;
+    float* xyz = cloud.allocate(nbPoints);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    std::uniform_real_distribution<float> springV(0.0f, (float)M_PI);
+    std::uniform_real_distribution<float> springU(0.0f, 2.0f*BENCH_SPRING_NB_ROUNDS*(float)M_PI);
+
+    size_t nbNoise = (size_t)(nbPoints*BENCH_NOISE_RATIO/(1.0f+BENCH_NOISE_RATIO));
+    for(size_t i = 0; i < 3*nbNoise; i++)
+        xyz[i] = noise(rng);
+    for(size_t i = nbNoise; i < nbPoints; i++)
+    {
+        float v = springV(rng);
+        float u = springU(rng);
+        xyz[3*i+0] = (BENCH_SPRING_BIG_RADIUS + BENCH_SPRING_SMALL_RADIUS*std::cos(v))*std::cos(u);
+        xyz[3*i+1] = (BENCH_SPRING_BIG_RADIUS + BENCH_SPRING_SMALL_RADIUS*std::cos(v))*std::sin(u);
+        xyz[3*i+2] = BENCH_SPRING_SMALL_RADIUS*std::sin(v) + BENCH_SPRING_PITCH*u/(float)M_PI;
+    }
+
+    BenchMesh spring = generateSpring();
+    VFVPointInMesh mesh(spring);
+    std::cout << nbPoints << " points, " << mesh.getNbTriangles() << " triangles, " << mesh.getGridResolution() << "x" << mesh.getGridResolution() << " grid" << std::endl;
+
+    std::vector<uint8_t> reference;
+    bool agree = true;
+    for(VFVSIMDLevel level : {VFV_SIMD_SCALAR, VFV_SIMD_SSE2, VFV_SIMD_AVX2})
+    {
+        if(level > getSIMDLevel())
+            break;
+
+        std::vector<uint8_t> inside(nbPoints);
+        benchmark(std::string("VFVPointInMesh::compute, ") + getSIMDLevelName(level), 3, [&]() {mesh.compute(cloud, 0, nbPoints, inside.data(), level);});
+
+        if(reference.empty())
+        {
+            reference = std::move(inside);
+            size_t nbInside = 0;
+            for(uint8_t v : reference)
+                nbInside += v;
+            std::cout << nbInside << " points inside" << std::endl;
+        }
+        else
+            agree = agree && inside == reference;
+    }
+
+    //The whole chain, tile per tile or subtree per subtree
+    VFVPointOctree octree;
+    benchmark("VFVPointOctree::build", 1, [&]() {octree.build(cloud);});
+
+    std::vector<VFVSelectionStep> steps = {{&mesh, VFV_SELECTION_OP_REPLACE}};
+    std::vector<uint8_t> tiledMask(nbPoints, 0);
+    std::vector<uint8_t> octreeMask(nbPoints, 0);
+    benchmark("evaluateSelection, tiles",  3, [&]() {evaluateSelection(cloud, steps, tiledMask.data());});
+    benchmark("evaluateSelection, octree", 3, [&]() {evaluateSelection(cloud, octree, steps, octreeMask.data());});
+    agree = agree && tiledMask == reference && octreeMask == reference;
+
+    if(!agree)
+    {
+        std::cerr << "The instruction sets or the evaluations disagree" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
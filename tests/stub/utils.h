@@ -0,0 +1,12 @@
+#ifndef  UTILS_INC
+#define  UTILS_INC
+
+#include <iostream>
+
+/* Minimal copy of the logging macros of serenoServer's utils.h, used when building the tests without the sereno libraries */
+
+#define ERROR   std::cerr << "[Error] "
+#define WARNING std::cerr << "[Warning] "
+#define INFO    std::cout << "[Info] "
+
+#endif
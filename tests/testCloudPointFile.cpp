@@ -0,0 +1,111 @@
+/* Tests of VFVCloudPointReader, as loadCloudPointDataset uses it to publish a decimated preview before the library loads the values:
+ * files written like new_gen_spring.py (native header, big endian positions and values), read whole, by range, and decimated. */
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include "VFVCloudPointFile.h"
+#include "writeData.h"
+#include "VFVTest.h"
+
+using namespace sereno;
+
+/** \brief  Write a cloud point file as new_gen_spring.py does. The point i is at (i, -i, i/2) and its value is i
+ * \param path the file to write
+ * \param nbPoints the number of points
+ * \param bigEndianHeader true to write the number of points in big endian, false in little endian */
+static void writeCloudPointFile(const std::filesystem::path& path, uint32_t nbPoints, bool bigEndianHeader)
+{
+    std::vector<uint8_t> data(4 + 16*(size_t)nbPoints);
+    if(bigEndianHeader)
+        writeUint32(data.data(), nbPoints);
+    else
+        for(uint32_t i = 0; i < 4; i++)
+            data[i] = (nbPoints >> (8*i)) & 0xff;
+
+    for(uint32_t i = 0; i < nbPoints; i++)
+    {
+        writeFloat(&data[4 + 12*(size_t)i],   (float)i);
+        writeFloat(&data[4 + 12*(size_t)i+4], -(float)i);
+        writeFloat(&data[4 + 12*(size_t)i+8], i/2.0f);
+        writeFloat(&data[4 + 12*(size_t)nbPoints + 4*(size_t)i], (float)i);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*)data.data(), data.size());
+}
+
+/** \brief  Check the position of a point read from a file written by writeCloudPointFile
+ * \param xyz the position read
+ * \param i the point index
+ * \return   true if the position is the expected one */
+static bool checkPosition(const float* xyz, uint32_t i)
+{
+    return xyz[0] == (float)i && xyz[1] == -(float)i && xyz[2] == i/2.0f;
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "testCloudPointFile";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    //More than one chunk, not a multiple of it, with both header byte orders
+    const uint32_t nbPoints = 150001;
+    for(bool bigEndianHeader : {true, false})
+    {
+        std::filesystem::path path = directory / "spring.cp";
+        writeCloudPointFile(path, nbPoints, bigEndianHeader);
+
+        VFVCloudPointReader reader;
+        VFV_CHECK(reader.open(path.string()));
+        VFV_CHECK(reader.getNbPoints() == nbPoints);
+
+        std::vector<float> xyz(3*nbPoints);
+        VFV_CHECK(reader.readPositions(0, nbPoints, xyz.data()));
+        bool ok = true;
+        for(uint32_t i = 0; i < nbPoints; i++)
+            ok = ok && checkPosition(&xyz[3*i], i);
+        VFV_CHECK(ok);
+
+        //A range starting in the middle of a chunk
+        VFV_CHECK(reader.readPositions(70000, 70010, xyz.data()));
+        VFV_CHECK(checkPosition(&xyz[0], 70000) && checkPosition(&xyz[27], 70009));
+
+        //The same points as VFVPointCloud::decimate
+        VFVPointCloud decimated;
+        uint32_t stride = reader.readDecimatedPositions(1000, decimated);
+        VFV_CHECK(stride == 151);
+        VFV_CHECK(decimated.size() == (nbPoints+stride-1)/stride);
+        ok = true;
+        for(uint32_t i = 0; i < decimated.size(); i++)
+            ok = ok && checkPosition(decimated[i], i*stride);
+        VFV_CHECK(ok);
+
+        VFV_CHECK(reader.readPositions(0, nbPoints, xyz.data()));
+        VFVPointCloud borrowed(xyz.data(), nbPoints);
+        VFVPointCloud expected;
+        VFV_CHECK(borrowed.decimate(1000, expected) == stride);
+        VFV_CHECK(memcmp(expected.data(), decimated.data(), 3*sizeof(float)*decimated.size()) == 0);
+
+        //Small enough to be kept whole
+        VFVPointCloud whole;
+        VFV_CHECK(reader.readDecimatedPositions(nbPoints, whole) == 1);
+        VFV_CHECK(whole.size() == nbPoints && checkPosition(whole[nbPoints-1], nbPoints-1));
+    }
+
+    //Truncated files and missing files are rejected
+    {
+        std::filesystem::path path = directory / "truncated.cp";
+        writeCloudPointFile(path, 10, true);
+        std::filesystem::resize_file(path, 4 + 16*10 - 1);
+        VFVCloudPointReader reader;
+        VFV_CHECK(!reader.open(path.string()));
+        VFV_CHECK(!reader.open((directory / "missing.cp").string()));
+    }
+
+    std::filesystem::remove_all(directory);
+    return getTestResult();
+}
@@ -0,0 +1,180 @@
+/* Tests of VFVComputePool, as the background dataset loading uses it:
+ * loadVTKDataset is pushed at TASK_PRIORITY_LOW and must not delay interactive work, and it calls parallelFor from a worker. */
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include "VFVComputePool.h"
+#include "VFVTest.h"
+
+using namespace sereno;
+
+/** \brief  A gate the tasks wait on until it is opened */
+struct Gate
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    bool                    opened = false;
+
+    void open()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        opened = true;
+        cond.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this]() {return opened;});
+    }
+};
+
+/** \brief  Test that the tasks pushed before the launch run once launched */
+static void testPushBeforeLaunch()
+{
+    VFVComputePool pool(16);
+    std::atomic<uint32_t> nbRun{0};
+    for(uint32_t i = 0; i < 8; i++)
+        VFV_CHECK(pool.push([&]() {nbRun++;}));
+    VFV_CHECK(nbRun == 0);
+
+    VFV_CHECK(pool.launch(2));
+    VFV_CHECK(!pool.launch(2));
+    while(pool.getNbExecuted() < 8)
+        std::this_thread::yield();
+    VFV_CHECK(nbRun == 8);
+}
+
+/** \brief  Test that the queued tasks run by priority, whatever their push order */
+static void testPriorities()
+{
+    VFVComputePool pool(16);
+    VFV_CHECK(pool.launch(1));
+
+    //Keep the only worker busy while queueing the tasks
+    Gate gate;
+    std::atomic<bool> started{false};
+    pool.push([&]() {started = true; gate.wait();});
+    while(!started)
+        std::this_thread::yield();
+
+    std::mutex            orderMutex;
+    std::vector<uint32_t> order;
+    auto record = [&](uint32_t value) {return [&, value]() {std::lock_guard<std::mutex> lock(orderMutex); order.push_back(value);};};
+    pool.push(record(TASK_PRIORITY_LOW),    TASK_PRIORITY_LOW);
+    pool.push(record(TASK_PRIORITY_NORMAL), TASK_PRIORITY_NORMAL);
+    pool.push(record(TASK_PRIORITY_HIGH),   TASK_PRIORITY_HIGH);
+    pool.push(record(TASK_PRIORITY_LOW),    TASK_PRIORITY_LOW);
+    gate.open();
+
+    while(pool.getNbExecuted() < 5)
+        std::this_thread::yield();
+    VFV_CHECK((order == std::vector<uint32_t>{TASK_PRIORITY_HIGH, TASK_PRIORITY_NORMAL, TASK_PRIORITY_LOW, TASK_PRIORITY_LOW}));
+}
+
+/** \brief  Test parallelFor called from the workers of a full pool (e.g., loadVTKDataset parsing the timesteps of a time series) */
+static void testNestedParallelFor()
+{
+    const size_t nbIterations = 1000;
+    VFVComputePool pool(2);
+    VFV_CHECK(pool.launch(2));
+
+    std::vector<std::atomic<uint32_t>> counts[3];
+    for(auto& c : counts)
+        c = std::vector<std::atomic<uint32_t>>(nbIterations);
+    std::atomic<uint32_t> nbDone{0};
+
+    //More outer tasks than workers and than room in the pool: every worker runs a parallelFor while the pool is full
+    for(uint32_t t = 0; t < 3; t++)
+        VFV_CHECK(pool.push([&, t]()
+        {
+            pool.parallelFor(nbIterations, [&, t](size_t i) {counts[t][i]++;}, TASK_PRIORITY_LOW);
+            nbDone++;
+        }, TASK_PRIORITY_LOW));
+
+    while(nbDone < 3)
+        std::this_thread::yield();
+    for(auto& c : counts)
+        for(auto& v : c)
+            VFV_CHECK(v == 1);
+
+    //From a non-worker thread too, and with nothing to do
+    std::vector<std::atomic<uint32_t>> count(nbIterations);
+    pool.parallelFor(nbIterations, [&](size_t i) {count[i]++;});
+    for(auto& v : count)
+        VFV_CHECK(v == 1);
+    pool.parallelFor(0, [&](size_t) {VFV_CHECK(false);});
+}
+
+/** \brief  Test the cap of parallelFor on the iterations running at once (e.g., the VTK timesteps parsed at once, see VTK_TIMESTEP_PARSING_MAX_THREADS) */
+static void testMaxParallelism()
+{
+    VFVComputePool pool(64);
+    VFV_CHECK(pool.launch(8));
+
+    for(size_t maxParallelism : {1, 3, 0})
+    {
+        std::atomic<uint32_t> running{0};
+        std::atomic<uint32_t> maxRunning{0};
+        std::atomic<uint32_t> nbRun{0};
+        pool.parallelFor(64, [&](size_t)
+        {
+            uint32_t r = ++running;
+            uint32_t m = maxRunning;
+            while(r > m && !maxRunning.compare_exchange_weak(m, r));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            running--;
+            nbRun++;
+        }, TASK_PRIORITY_LOW, maxParallelism);
+
+        VFV_CHECK(nbRun == 64);
+        if(maxParallelism > 0)
+            VFV_CHECK(maxRunning <= maxParallelism);
+        else
+            VFV_CHECK(maxRunning <= pool.getNbThreads()+1);
+    }
+}
+
+/** \brief  Test that closing the pool releases the threads waiting for room and discards the pending tasks */
+static void testClose()
+{
+    VFVComputePool pool(1);
+    VFV_CHECK(pool.launch(1));
+
+    Gate gate;
+    std::atomic<bool> started{false};
+    std::atomic<bool> discardedRun{false};
+    pool.push([&]() {started = true; gate.wait();});
+    while(!started)
+        std::this_thread::yield();
+    VFV_CHECK(pool.push([&]() {discardedRun = true;}));
+    VFV_CHECK(!pool.tryPush([&]() {discardedRun = true;}));
+
+    //The pool is full: this push waits until the pool closes
+    std::atomic<bool> pushResult{true};
+    std::thread pusher([&]() {pushResult = pool.push([&]() {discardedRun = true;});});
+    while(pool.getNbBlockedPushes() == 0)
+        std::this_thread::yield();
+    pool.close();
+    pusher.join();
+    VFV_CHECK(!pushResult);
+
+    gate.open();
+    pool.wait();
+    VFV_CHECK(!discardedRun);
+    VFV_CHECK(!pool.push([]() {}));
+}
+
+int main()
+{
+    testPushBeforeLaunch();
+    testPriorities();
+    testNestedParallelFor();
+    testMaxParallelism();
+    testClose();
+    return getTestResult();
+}
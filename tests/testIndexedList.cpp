@@ -0,0 +1,94 @@
+/* Tests of VFVIndexedList, as SubDatasetMetaDataList: the SubDatasetMetaData are found by ID in constant time,
+ * and the pointers the server keeps to them (e.g., VFVServer::getMetaData) survive the insertions and the removals of the others. */
+
+#include <vector>
+#include <string>
+#include "VFVIndexedList.h"
+#include "VFVTest.h"
+
+using namespace sereno;
+
+/** \brief  An element, as SubDatasetMetaData */
+struct Element
+{
+    uint64_t    sdID = 0; /*!< The element ID*/
+    std::string name;     /*!< Some data*/
+};
+
+typedef VFVIndexedList<Element, &Element::sdID> ElementList;
+
+/** \brief  Get the IDs of a list, in order
+ * \param list the list
+ * \return   the IDs */
+static std::vector<uint64_t> getIDs(const ElementList& list)
+{
+    std::vector<uint64_t> ids;
+    for(const Element& e : list)
+        ids.push_back(e.sdID);
+    return ids;
+}
+
+int main()
+{
+    ElementList list;
+    VFV_CHECK(list.empty());
+    VFV_CHECK(list.find(0) == list.end());
+
+    //Insertion order, whatever the IDs
+    std::vector<Element*> pointers;
+    for(uint64_t id : {5, 1, 9, 3, 7})
+    {
+        list.push_back(Element{id, "sd" + std::to_string(id)});
+        pointers.push_back(&list.back());
+    }
+    VFV_CHECK(list.size() == 5);
+    VFV_CHECK((getIDs(list) == std::vector<uint64_t>{5, 1, 9, 3, 7}));
+
+    //Lookups
+    for(Element* e : pointers)
+        VFV_CHECK(&(*list.find(e->sdID)) == e);
+    VFV_CHECK(list.find(4) == list.end());
+
+    //Removing an element keeps the others in place
+    auto next = list.erase(list.find(9));
+    VFV_CHECK(next != list.end() && next->sdID == 3);
+    VFV_CHECK(list.find(9) == list.end());
+    VFV_CHECK((getIDs(list) == std::vector<uint64_t>{5, 1, 3, 7}));
+    for(size_t i : {0, 1, 3, 4})
+    {
+        VFV_CHECK(&(*list.find(pointers[i]->sdID)) == pointers[i]);
+        VFV_CHECK(pointers[i]->name == "sd" + std::to_string(pointers[i]->sdID));
+    }
+
+    //Many insertions do not move the elements either
+    for(uint64_t id = 100; id < 10100; id++)
+        list.push_back(Element{id, ""});
+    for(size_t i : {0, 1, 3, 4})
+        VFV_CHECK(&(*list.find(pointers[i]->sdID)) == pointers[i]);
+    VFV_CHECK(list.find(5000)->sdID == 5000);
+
+    //A removed ID can be added again
+    list.push_back(Element{9, "again"});
+    VFV_CHECK(list.find(9)->name == "again");
+
+    //Copies index their own elements
+    ElementList copy = list;
+    VFV_CHECK(copy.size() == list.size());
+    VFV_CHECK(getIDs(copy) == getIDs(list));
+    VFV_CHECK(&(*copy.find(5)) != pointers[0]);
+    copy.find(5)->name = "copied";
+    VFV_CHECK(pointers[0]->name == "sd5");
+    copy.erase(copy.find(1));
+    VFV_CHECK(list.find(1) != list.end());
+
+    const ElementList& self = copy;
+    copy = self; //Self assignment
+    VFV_CHECK(copy.size() == list.size()-1);
+
+    list.clear();
+    VFV_CHECK(list.empty());
+    VFV_CHECK(list.find(5) == list.end());
+    VFV_CHECK(copy.find(5)->name == "copied");
+
+    return getTestResult();
+}
@@ -0,0 +1,195 @@
+/* Tests of VFVMaskBricks, as sendVolumetricMaskUpdate uses it to find the bricks of a volumetric mask to send:
+ * only the marked bricks whose content changed are reported, whether the mask is written directly or by evaluateSelection. */
+
+#include <vector>
+#include <random>
+#include <thread>
+#include <memory>
+#include "VFVMaskBricks.h"
+#include "VFVSelectionEvaluator.h"
+#include "VFVComputePool.h"
+#include "VFVTest.h"
+#include "VFVTestMesh.h"
+
+using namespace sereno;
+
+/* \brief The brick size used by the tests, small to get many bricks */
+#define TEST_BRICK_SIZE 1000
+
+/** \brief  Find the bricks which differ between two masks (the reference)
+ * \param a the first mask
+ * \param b the second mask, of the same size
+ * \return   the bricks which differ, in ascending order */
+static std::vector<uint32_t> diffBricks(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+    std::vector<uint32_t> bricks;
+    for(size_t begin = 0; begin < a.size(); begin += TEST_BRICK_SIZE)
+    {
+        size_t end = std::min(begin+TEST_BRICK_SIZE, a.size());
+        if(!std::equal(a.begin()+begin, a.begin()+end, b.begin()+begin))
+            bricks.push_back(begin/TEST_BRICK_SIZE);
+    }
+    return bricks;
+}
+
+/** \brief  Test the tracker on masks written directly */
+static void testDirectWrites()
+{
+    const size_t nbPoints = 10*TEST_BRICK_SIZE + 37; //A partial last brick
+    std::vector<uint8_t>  mask(nbPoints, 0);
+    std::vector<uint32_t> changed;
+    VFVMaskBricks bricks(TEST_BRICK_SIZE);
+
+    //The first mask is new
+    VFV_CHECK(bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK(changed.empty());
+
+    //Nothing written, nothing reported
+    VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK(changed.empty());
+
+    //Marked and changed bricks only
+    mask[5]                   = 1;
+    mask[3*TEST_BRICK_SIZE+1] = 1;
+    mask[nbPoints-1]          = 1;
+    bricks.markPoint(5);
+    bricks.markDirty(3*TEST_BRICK_SIZE, 3*TEST_BRICK_SIZE+2);
+    bricks.markPoint(nbPoints-1);
+    bricks.markDirty(6*TEST_BRICK_SIZE, 8*TEST_BRICK_SIZE); //Written, but unchanged
+    VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK((changed == std::vector<uint32_t>{0, 3, 10}));
+
+    //The marks are cleared by the update
+    changed.clear();
+    VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK(changed.empty());
+
+    //A brick changed then restored is not sent again
+    mask[4*TEST_BRICK_SIZE] = 1;
+    mask[4*TEST_BRICK_SIZE] = 0;
+    bricks.markPoint(4*TEST_BRICK_SIZE);
+    VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK(changed.empty());
+
+    //Marking everything hashes everything
+    std::vector<uint8_t> previous = mask;
+    std::fill(mask.begin(), mask.end(), 0);
+    bricks.markAllDirty();
+    VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK(changed == diffBricks(previous, mask));
+
+    //Copies track the mask independently
+    changed.clear();
+    mask[2*TEST_BRICK_SIZE] = 1;
+    bricks.markPoint(2*TEST_BRICK_SIZE);
+    VFVMaskBricks copy = bricks;
+    VFV_CHECK(!copy.update(mask.data(), mask.size(), changed));
+    VFV_CHECK((changed == std::vector<uint32_t>{2}));
+    changed.clear();
+    VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK((changed == std::vector<uint32_t>{2}));
+
+    //A resized mask is new. The marks out of the mask are ignored
+    changed.clear();
+    mask.resize(3*TEST_BRICK_SIZE);
+    bricks.markPoint(20*TEST_BRICK_SIZE);
+    bricks.markDirty(0, 50*TEST_BRICK_SIZE);
+    VFV_CHECK(bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK(changed.empty());
+}
+
+/** \brief  Test the tracker marked concurrently, as the compute pool tasks do */
+static void testConcurrentMarks()
+{
+    const size_t nbPoints = 64*TEST_BRICK_SIZE;
+    std::vector<uint8_t>  mask(nbPoints, 0);
+    std::vector<uint8_t>  previous = mask;
+    std::vector<uint32_t> changed;
+    VFVMaskBricks bricks(TEST_BRICK_SIZE);
+    bricks.update(mask.data(), mask.size(), changed);
+
+    std::vector<std::thread> threads;
+    for(uint32_t t = 0; t < 4; t++)
+        threads.emplace_back([&, t]()
+        {
+            //Each thread writes every fourth point of every third brick
+            for(size_t i = t; i < nbPoints; i += 4)
+                if((i/TEST_BRICK_SIZE)%3 == 0)
+                {
+                    mask[i] = 1;
+                    bricks.markPoint(i);
+                }
+        });
+    for(std::thread& th : threads)
+        th.join();
+
+    VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+    VFV_CHECK(changed == diffBricks(previous, mask));
+}
+
+/** \brief  Test the marks left by evaluateSelection */
+static void testEvaluateSelection()
+{
+    const size_t nbPoints = 40*TEST_BRICK_SIZE + 11;
+    VFVPointCloud cloud;
+    float* xyz = cloud.allocate(nbPoints);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(size_t i = 0; i < 3*nbPoints; i++)
+        xyz[i] = dist(rng);
+
+    //The points are not sorted spatially: a small torus touches some bricks only if they are
+    for(size_t i = 0; i < nbPoints; i++)
+        if((i/TEST_BRICK_SIZE)%2)
+            for(uint32_t j = 0; j < 3; j++)
+                xyz[3*i+j] = 0.5f*xyz[3*i+j] + 2.0f;
+
+    TestMesh torus = generateTorus(0.4, 0.2, 24);
+    VFVPointInMesh mesh(torus);
+    VFVPointOctree octree;
+    octree.build(cloud);
+
+    VFVComputePool pool(64);
+    VFV_CHECK(pool.launch(4));
+
+    for(VFVSelectionOp op : {VFV_SELECTION_OP_REPLACE, VFV_SELECTION_OP_UNION, VFV_SELECTION_OP_MINUS})
+    {
+        const std::vector<VFVSelectionStep> steps = {{&mesh, op}};
+        std::vector<uint8_t>  mask(nbPoints, 0);
+        std::vector<uint32_t> changed;
+        VFVMaskBricks bricks(TEST_BRICK_SIZE);
+        bricks.update(mask.data(), mask.size(), changed);
+
+        //Twice: the second evaluation does not change anything
+        for(uint32_t i = 0; i < 2; i++)
+        {
+            std::vector<uint8_t> previous = mask;
+            VFV_CHECK(evaluateSelection(cloud, octree, steps, mask.data(), &pool, NULL, &bricks));
+            changed.clear();
+            VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+            VFV_CHECK(changed == diffBricks(previous, mask));
+            if(op == VFV_SELECTION_OP_MINUS || i == 1)
+                VFV_CHECK(changed.empty());
+            else
+                VFV_CHECK(!changed.empty() && changed.size() <= 21);
+
+            //The tiled evaluation marks its tiles
+            previous = mask;
+            VFV_CHECK(evaluateSelection(cloud, steps, mask.data(), &pool, NULL, &bricks));
+            changed.clear();
+            VFV_CHECK(!bricks.update(mask.data(), mask.size(), changed));
+            VFV_CHECK(changed.empty());
+        }
+    }
+
+    pool.close();
+    pool.wait();
+}
+
+int main()
+{
+    testDirectWrites();
+    testConcurrentMarks();
+    testEvaluateSelection();
+    return getTestResult();
+}
@@ -0,0 +1,94 @@
+/* Tests of VFVPointCloud (borrowed and owned positions, decimation) and of the VFVPointOctree built over it,
+ * as loadCloudPointDataset uses them: the octree over the positions the library loaded, and a decimated copy meanwhile. */
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "VFVPointInMesh.h"
+#include "VFVPointOctree.h"
+#include "VFVTest.h"
+
+using namespace sereno;
+
+/** \brief  Check that an octree covers every point of a cloud once, each node bounding its points
+ * \param cloud the cloud the octree was built over
+ * \param octree the octree */
+static void checkOctree(const VFVPointCloud& cloud, const VFVPointOctree& octree)
+{
+    std::vector<uint32_t> ids = octree.getPointIDs();
+    VFV_CHECK(ids.size() == cloud.size());
+    std::sort(ids.begin(), ids.end());
+    for(size_t i = 0; i < ids.size(); i++)
+        if(!VFV_CHECK(ids[i] == i))
+            break;
+
+    for(const VFVPointOctree::Node& node : octree.getNodes())
+    {
+        for(uint32_t i = node.begin; i < node.end; i++)
+        {
+            const float* p = cloud[octree.getPointIDs()[i]];
+            bool inBounds = true;
+            for(uint32_t k = 0; k < 3; k++)
+                inBounds = inBounds && p[k] >= node.min[k] && p[k] <= node.max[k];
+            if(!VFV_CHECK(inBounds))
+                return;
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    //The buffer of the library
+    const size_t nbPoints = 100003;
+    std::vector<float> xyz(3*nbPoints);
+    for(float& v : xyz)
+        v = dist(rng);
+
+    //Borrowed positions are not copied
+    VFVPointCloud cloud(xyz.data(), nbPoints);
+    VFV_CHECK(cloud.size() == nbPoints);
+    VFV_CHECK(cloud.data() == xyz.data());
+    VFV_CHECK(cloud[12] == xyz.data()+36);
+
+    //Decimation: one point every stride points, at most maxPoints points
+    for(size_t maxPoints : {(size_t)1, (size_t)1000, (size_t)65536, nbPoints, 2*nbPoints})
+    {
+        VFVPointCloud subset;
+        uint32_t stride = cloud.decimate(maxPoints, subset);
+        VFV_CHECK(stride >= 1);
+        VFV_CHECK(subset.size() <= maxPoints);
+        VFV_CHECK(subset.size() == (nbPoints + stride-1)/stride);
+        VFV_CHECK(stride == 1 || (nbPoints + stride-2)/(stride-1) > maxPoints); //The smallest stride
+        VFV_CHECK(subset.data() != xyz.data());
+        for(size_t i = 0; i < subset.size(); i++)
+            if(!VFV_CHECK(std::equal(subset[i], subset[i]+3, cloud[i*stride])))
+                break;
+
+        //Moving an owned cloud keeps its positions
+        const float* data = subset.data();
+        VFVPointCloud moved(std::move(subset));
+        VFV_CHECK(moved.data() == data);
+    }
+
+    //The octrees over the borrowed positions and over a decimated copy
+    VFVPointOctree octree;
+    octree.build(cloud);
+    checkOctree(cloud, octree);
+
+    VFVPointCloud subset;
+    cloud.decimate(4096, subset);
+    VFVPointOctree subsetOctree;
+    subsetOctree.build(subset);
+    checkOctree(subset, subsetOctree);
+
+    //An empty cloud
+    VFVPointCloud empty;
+    VFVPointOctree emptyOctree;
+    emptyOctree.build(empty);
+    VFV_CHECK(emptyOctree.getPointIDs().empty());
+
+    return getTestResult();
+}
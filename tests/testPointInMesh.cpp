@@ -0,0 +1,161 @@
+/* Tests of VFVPointInMesh: the bounding box reject and the YZ grid must give exactly the parity of a brute-force ray cast,
+ * with every instruction set the CPU supports, including for rays passing through shared edges and vertices. */
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include "VFVPointInMesh.h"
+#include "VFVTest.h"
+#include "VFVTestMesh.h"
+
+using namespace sereno;
+
+/** \brief  Brute-force ray cast along +X against every triangle, in double precision
+ * \param mesh the mesh
+ * \param p the point
+ * \param ambiguous[out] set to true if the ray passes too close to an edge or the point too close to a triangle to trust the result
+ * \return   true if the point is inside, false otherwise */
+static bool bruteForceInside(const TestMesh& mesh, const float* p, bool& ambiguous)
+{
+    const double eps = 1e-5;
+    bool inside = false;
+    ambiguous   = false;
+    for(size_t t = 0; t < mesh.triangles.size(); t+=3)
+    {
+        const TestMesh::Point* v[3] = {&mesh.points[mesh.triangles[t]], &mesh.points[mesh.triangles[t+1]], &mesh.points[mesh.triangles[t+2]]};
+
+        //Edge functions in the YZ plane
+        double e[3];
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            const TestMesh::Point* a = v[i];
+            const TestMesh::Point* b = v[(i+1)%3];
+            e[i] = (b->y - a->y)*(p[2] - a->z) - (b->z - a->z)*(p[1] - a->y);
+        }
+        double area = e[0] + e[1] + e[2];
+        if(std::abs(area) < 1e-12)
+            continue;
+        if(std::min({std::abs(e[0]), std::abs(e[1]), std::abs(e[2])}) < eps)
+        {
+            ambiguous = true;
+            continue;
+        }
+        if(!((e[0] > 0 && e[1] > 0 && e[2] > 0) || (e[0] < 0 && e[1] < 0 && e[2] < 0)))
+            continue;
+
+        //The X coordinate where the ray crosses the triangle
+        double x = (e[1]*v[0]->x + e[2]*v[1]->x + e[0]*v[2]->x)/area;
+        if(std::abs(x - p[0]) < eps)
+            ambiguous = true;
+        else if(x > p[0])
+            inside = !inside;
+    }
+    return inside;
+}
+
+/** \brief  Get the instruction sets to test
+ * \return   every instruction set the CPU supports */
+static std::vector<VFVSIMDLevel> getLevels()
+{
+    std::vector<VFVSIMDLevel> levels;
+    for(VFVSIMDLevel level : {VFV_SIMD_SCALAR, VFV_SIMD_SSE2, VFV_SIMD_AVX2})
+        if(level <= getSIMDLevel())
+            levels.push_back(level);
+    return levels;
+}
+
+/** \brief  Test random points, part of them outside the mesh bounding box, against a brute-force ray cast
+ * \param mesh the mesh
+ * \param nbPoints the number of points
+ * \param extent the points are drawn in [-extent, extent]^3 */
+static void testAgainstBruteForce(const TestMesh& mesh, size_t nbPoints, float extent)
+{
+    VFVPointInMesh pointInMesh(mesh);
+    VFV_CHECK(pointInMesh.getGridResolution() > 1);
+
+    VFVPointCloud cloud;
+    float* xyz = cloud.allocate(nbPoints);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-extent, extent);
+    for(size_t i = 0; i < 3*nbPoints; i++)
+        xyz[i] = dist(rng);
+
+    std::vector<uint8_t> expected(nbPoints);
+    std::vector<bool>    ambiguous(nbPoints);
+    size_t nbInside = 0;
+    for(size_t i = 0; i < nbPoints; i++)
+    {
+        bool amb;
+        expected[i]  = bruteForceInside(mesh, cloud[i], amb);
+        ambiguous[i] = amb;
+        nbInside    += expected[i];
+    }
+    VFV_CHECK(nbInside > 0 && nbInside < nbPoints);
+
+    for(VFVSIMDLevel level : getLevels())
+    {
+        //The whole cloud, then a sub-range not aligned on the SIMD width
+        std::vector<uint8_t> inside(nbPoints, 2);
+        pointInMesh.compute(cloud, 0, nbPoints, inside.data(), level);
+        size_t nbErrors = 0;
+        for(size_t i = 0; i < nbPoints; i++)
+            nbErrors += (!ambiguous[i] && inside[i] != expected[i]) || inside[i] > 1;
+        if(!VFV_CHECK(nbErrors == 0))
+            std::cerr << nbErrors << " wrong points with " << getSIMDLevelName(level) << std::endl;
+
+        std::vector<uint8_t> subRange(nbPoints-10, 2);
+        pointInMesh.compute(cloud, 3, nbPoints-7, subRange.data(), level);
+        VFV_CHECK(std::equal(subRange.begin(), subRange.end(), inside.begin()+3));
+    }
+}
+
+/** \brief  Test rays passing exactly through the shared edges and vertices of the cube: each point must be counted once */
+static void testSharedEdges()
+{
+    TestMesh cube = generateCube();
+    VFVPointInMesh pointInMesh(cube);
+
+    //On the face diagonals (y == z), on the edges of the faces (y or z in {0, 1}), and through the vertices, at every X
+    const float coords[] = {0.0f, 0.25f, 0.5f, 1.0f};
+    const float xs[]     = {-0.5f, 0.25f, 0.5f, 1.5f};
+    std::vector<float> xyz;
+    std::vector<uint8_t> expected;
+    for(float y : coords)
+        for(float z : coords)
+            for(float x : xs)
+            {
+                //Points on the boundary can be either side, as long as the parity is consistent along the ray: only test the strict interior and the outside
+                bool onBoundary = (y == 0.0f || y == 1.0f || z == 0.0f || z == 1.0f);
+                if(onBoundary && x > 0.0f && x < 1.0f)
+                    continue;
+                xyz.insert(xyz.end(), {x, y, z});
+                expected.push_back(!onBoundary && x > 0.0f && x < 1.0f);
+            }
+
+    VFVPointCloud cloud(xyz.data(), expected.size());
+    for(VFVSIMDLevel level : getLevels())
+    {
+        std::vector<uint8_t> inside(cloud.size());
+        pointInMesh.compute(cloud, 0, cloud.size(), inside.data(), level);
+        if(!VFV_CHECK(inside == expected))
+            std::cerr << "Wrong parities through shared edges with " << getSIMDLevelName(level) << std::endl;
+    }
+}
+
+int main()
+{
+    //The torus is not convex: rays cross it up to four times
+    testAgainstBruteForce(generateTorus(0.6, 0.25, 48), 20000, 1.0f);
+    testSharedEdges();
+
+    //An empty mesh contains nothing
+    VFVPointInMesh empty;
+    VFV_CHECK(empty.getGridResolution() == 0);
+    float p[3] = {0.0f, 0.0f, 0.0f};
+    uint8_t inside = 1;
+    empty.compute(VFVPointCloud(p, 1), 0, 1, &inside);
+    VFV_CHECK(inside == 0);
+
+    return getTestResult();
+}
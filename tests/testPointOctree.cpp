@@ -0,0 +1,87 @@
+/* Tests of the VFVPointOctree queries used by the volumetric selections:
+ * whole-node accept/reject must give exactly the per-point parities, the subtrees must cover every point once,
+ * and the preview subset must be spread over the whole cloud. */
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "VFVPointOctree.h"
+#include "VFVTest.h"
+#include "VFVTestMesh.h"
+
+using namespace sereno;
+
+int main()
+{
+    //A dense cluster and a sparse background, so that the octree is unbalanced
+    const size_t nbPoints = 60000;
+    VFVPointCloud cloud;
+    float* xyz = cloud.allocate(nbPoints);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::normal_distribution<float>       cluster(0.3f, 0.05f);
+    for(size_t i = 0; i < nbPoints; i++)
+        for(uint32_t j = 0; j < 3; j++)
+            xyz[3*i+j] = (i%2 ? dist(rng) : cluster(rng));
+
+    VFVPointOctree octree;
+    octree.build(cloud);
+    const std::vector<uint32_t>& pointIDs = octree.getPointIDs();
+
+    TestMesh torus = generateTorus(0.6, 0.25, 32);
+    TestMesh cube  = generateCube();
+    cube.transform(0.4, 0.1, 0.1, 0.1);
+    for(const TestMesh* m : {&torus, &cube})
+    {
+        VFVPointInMesh mesh(*m);
+        std::vector<uint8_t> expected(nbPoints);
+        mesh.compute(cloud, 0, nbPoints, expected.data());
+
+        //The whole cloud
+        std::vector<uint32_t> ids;
+        octree.queryInside(cloud, mesh, ids);
+        std::sort(ids.begin(), ids.end());
+        std::vector<uint32_t> expectedIDs;
+        for(uint32_t i = 0; i < nbPoints; i++)
+            if(expected[i])
+                expectedIDs.push_back(i);
+        VFV_CHECK(ids == expectedIDs);
+
+        //Subtree per subtree
+        std::vector<uint32_t> subtrees;
+        octree.getSubtrees(4096, subtrees);
+        VFV_CHECK(subtrees.size() > 1);
+        uint32_t next = 0;
+        bool     classified = true;
+        for(uint32_t nodeID : subtrees)
+        {
+            const VFVPointOctree::Node& node = octree.getNodes()[nodeID];
+            VFV_CHECK(node.begin == next);
+            VFV_CHECK(node.end - node.begin <= 4096 || node.nbChildren == 0);
+            next = node.end;
+
+            std::vector<uint8_t> inside(node.end - node.begin, 2);
+            octree.classifyInside(cloud, mesh, nodeID, inside.data());
+            for(uint32_t i = node.begin; i < node.end; i++)
+                classified = classified && inside[i-node.begin] == expected[pointIDs[i]];
+        }
+        VFV_CHECK(next == nbPoints);
+        VFV_CHECK(classified);
+    }
+
+    //The preview subset: unique, sorted, within the budget, and covering both the cluster and the background
+    for(size_t maxPoints : {(size_t)100, (size_t)5000, 2*nbPoints})
+    {
+        std::vector<uint32_t> subset;
+        octree.getSubset(maxPoints, subset);
+        VFV_CHECK(!subset.empty() && subset.size() <= maxPoints);
+        VFV_CHECK(std::is_sorted(subset.begin(), subset.end()));
+        VFV_CHECK(std::adjacent_find(subset.begin(), subset.end()) == subset.end());
+        VFV_CHECK(subset.back() < nbPoints);
+
+        size_t nbBackground = std::count_if(subset.begin(), subset.end(), [](uint32_t id) {return id%2 == 1;});
+        VFV_CHECK(nbBackground > 0 && nbBackground < subset.size());
+    }
+
+    return getTestResult();
+}
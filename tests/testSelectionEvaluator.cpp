@@ -0,0 +1,117 @@
+/* Tests of evaluateSelection, as runSelectionJob uses it on the cloud point datasets:
+ * the tiled evaluation of a whole boolean chain, with or without the octree and the compute pool, must give exactly the mask
+ * obtained by applying the meshes one after the other on the whole cloud. */
+
+#include <vector>
+#include <random>
+#include <memory>
+#include <atomic>
+#include "VFVSelectionEvaluator.h"
+#include "VFVComputePool.h"
+#include "VFVTest.h"
+#include "VFVTestMesh.h"
+
+using namespace sereno;
+
+/** \brief  Apply the meshes one after the other on the whole cloud (the reference)
+ * \param points the points
+ * \param steps the steps to apply
+ * \param mask[in, out] the mask, one byte per point */
+static void applySequentially(const VFVPointCloud& points, const std::vector<VFVSelectionStep>& steps, std::vector<uint8_t>& mask)
+{
+    std::vector<uint8_t> inside(points.size());
+    for(const VFVSelectionStep& step : steps)
+    {
+        step.mesh->compute(points, 0, points.size(), inside.data());
+        for(size_t i = 0; i < points.size(); i++)
+        {
+            switch(step.op)
+            {
+                case VFV_SELECTION_OP_REPLACE:
+                    mask[i] = inside[i];
+                    break;
+                case VFV_SELECTION_OP_UNION:
+                    mask[i] = mask[i] || inside[i];
+                    break;
+                case VFV_SELECTION_OP_INTERSECTION:
+                    mask[i] = mask[i] && inside[i];
+                    break;
+                case VFV_SELECTION_OP_MINUS:
+                    mask[i] = mask[i] && !inside[i];
+                    break;
+            }
+        }
+    }
+}
+
+int main()
+{
+    //Not a multiple of the tile size
+    const size_t nbPoints = 5*VFV_SELECTION_TILE_SIZE + 123;
+    VFVPointCloud cloud;
+    float* xyz = cloud.allocate(nbPoints);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(size_t i = 0; i < 3*nbPoints; i++)
+        xyz[i] = dist(rng);
+
+    //Overlapping meshes
+    TestMesh torus = generateTorus(0.6, 0.25, 32);
+    TestMesh cube  = generateCube();
+    cube.transform(1.0, -0.5, -0.5, -0.5);
+    TestMesh smallTorus = generateTorus(0.3, 0.15, 24);
+    smallTorus.transform(1.0, 0.4, 0.0, 0.1);
+    std::vector<std::unique_ptr<VFVPointInMesh>> meshes;
+    for(const TestMesh* m : {&torus, &cube, &smallTorus})
+        meshes.push_back(std::make_unique<VFVPointInMesh>(*m));
+
+    //A random initial mask (the selection made so far)
+    std::vector<uint8_t> initialMask(nbPoints);
+    for(uint8_t& v : initialMask)
+        v = rng()%2;
+
+    VFVPointOctree octree;
+    octree.build(cloud);
+
+    VFVComputePool pool(64);
+    VFV_CHECK(pool.launch(4));
+
+    const std::vector<std::vector<VFVSelectionStep>> chains = {
+        {{meshes[0].get(), VFV_SELECTION_OP_REPLACE}},
+        {{meshes[0].get(), VFV_SELECTION_OP_UNION}, {meshes[1].get(), VFV_SELECTION_OP_INTERSECTION}},
+        {{meshes[1].get(), VFV_SELECTION_OP_REPLACE}, {meshes[0].get(), VFV_SELECTION_OP_MINUS}, {meshes[2].get(), VFV_SELECTION_OP_UNION}},
+        {{meshes[2].get(), VFV_SELECTION_OP_MINUS}, {meshes[0].get(), VFV_SELECTION_OP_INTERSECTION}, {meshes[1].get(), VFV_SELECTION_OP_UNION},
+         {meshes[0].get(), VFV_SELECTION_OP_MINUS}},
+        {},
+    };
+
+    for(const std::vector<VFVSelectionStep>& steps : chains)
+    {
+        std::vector<uint8_t> expected = initialMask;
+        applySequentially(cloud, steps, expected);
+
+        for(VFVComputePool* p : {(VFVComputePool*)NULL, &pool})
+        {
+            std::vector<uint8_t> mask = initialMask;
+            VFV_CHECK(evaluateSelection(cloud, steps, mask.data(), p));
+            VFV_CHECK(mask == expected);
+
+            //Whole octree nodes accepted or rejected at once
+            mask = initialMask;
+            VFV_CHECK(evaluateSelection(cloud, octree, steps, mask.data(), p));
+            VFV_CHECK(mask == expected);
+        }
+    }
+
+    //A cancelled evaluation reports it
+    std::atomic<bool> cancelled{true};
+    std::vector<uint8_t> mask = initialMask;
+    VFV_CHECK(!evaluateSelection(cloud, chains[1], mask.data(), &pool, &cancelled));
+    VFV_CHECK(mask == initialMask);
+    VFV_CHECK(!evaluateSelection(cloud, octree, chains[1], mask.data(), &pool, &cancelled));
+    VFV_CHECK(mask == initialMask);
+
+    pool.close();
+    pool.wait();
+    return getTestResult();
+}
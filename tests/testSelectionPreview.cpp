@@ -0,0 +1,86 @@
+/* Tests of VFVSelectionPreview, whose selection runSelectionJob applies on the SubDataset mask (one byte per point) instead of recomputing it:
+ * the slices XOR-ed through the octree, then applied on a mask, must give exactly what evaluateSelection computes from the whole meshes. */
+
+#include <vector>
+#include <random>
+#include <memory>
+#include "VFVSelectionPreview.h"
+#include "VFVSelectionEvaluator.h"
+#include "VFVTest.h"
+#include "VFVTestMesh.h"
+
+using namespace sereno;
+
+int main()
+{
+    const size_t nbPoints = 3*VFV_SELECTION_TILE_SIZE + 77;
+    auto cloud = std::make_shared<VFVPointCloud>();
+    float* xyz = cloud->allocate(nbPoints);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(size_t i = 0; i < 3*nbPoints; i++)
+        xyz[i] = dist(rng);
+
+    auto octree = std::make_shared<VFVPointOctree>();
+    octree->build(*cloud);
+
+    //Two boxes sharing a face, pushed as two slices of the same mesh: their XOR is the box made of both
+    TestMesh boxA = generateCube();
+    boxA.transform(0.5, -0.5, -0.25, -0.25);
+    TestMesh boxB = generateCube();
+    boxB.transform(0.5, 0.0, -0.25, -0.25);
+    TestMesh torus = generateTorus(0.6, 0.25, 32);
+
+    auto sliceA     = std::make_shared<VFVPointInMesh>(boxA);
+    auto sliceB     = std::make_shared<VFVPointInMesh>(boxB);
+    auto torusSlice = std::make_shared<VFVPointInMesh>(torus);
+
+    //The mesh made of both boxes, for the reference
+    TestMesh bothBoxes = boxA;
+    for(uint32_t t : boxB.triangles)
+        bothBoxes.triangles.push_back(t + boxA.points.size());
+    bothBoxes.points.insert(bothBoxes.points.end(), boxB.points.begin(), boxB.points.end());
+    VFVPointInMesh bothBoxesMesh(bothBoxes);
+
+    std::vector<uint8_t> initialMask(nbPoints);
+    for(uint8_t& v : initialMask)
+        v = rng()%2;
+
+    for(VFVSelectionOp firstOp : {VFV_SELECTION_OP_REPLACE, VFV_SELECTION_OP_UNION, VFV_SELECTION_OP_INTERSECTION, VFV_SELECTION_OP_MINUS})
+    {
+        VFVSelectionPreview preview(cloud, octree);
+        preview.beginMesh(firstOp);
+        preview.pushSlice(sliceA);
+        preview.pushSlice(sliceB);
+        preview.beginMesh(VFV_SELECTION_OP_MINUS);
+        preview.pushSlice(torusSlice);
+        VFV_CHECK(preview.hasPending());
+        preview.processPending();
+        VFV_CHECK(!preview.hasPending());
+        VFV_CHECK(preview.getNbMeshes() == 2);
+        VFV_CHECK(preview.getNbPoints() == nbPoints);
+
+        std::vector<uint8_t> expected = initialMask;
+        evaluateSelection(*cloud, {{&bothBoxesMesh, firstOp}, {torusSlice.get(), VFV_SELECTION_OP_MINUS}}, expected.data());
+
+        std::vector<uint8_t> mask = initialMask;
+        preview.applyOnMask(mask.data());
+        VFV_CHECK(mask == expected);
+
+        //The view of the subset spread by the octree starts from an empty mask
+        std::vector<uint8_t> fromEmpty(nbPoints, 0);
+        preview.applyOnMask(fromEmpty.data());
+        std::vector<uint32_t> subset;
+        octree->getSubset(1000, subset);
+        VFV_CHECK(!subset.empty() && subset.size() <= 1000);
+        std::vector<uint8_t> bits;
+        preview.getPreview(subset, bits);
+        VFV_CHECK(bits.size() == (subset.size()+7)/8);
+        bool previewMatches = true;
+        for(size_t i = 0; i < subset.size(); i++)
+            previewMatches = previewMatches && ((bits[i/8] >> (i%8)) & 1) == fromEmpty[subset[i]];
+        VFV_CHECK(previewMatches);
+    }
+
+    return getTestResult();
+}
@@ -0,0 +1,61 @@
+/* Tests of getTimeSeriesSuffixes, as loadVTKDataset uses it to find the timesteps of a VTK dataset:
+ * only the "<name>.<digits>" files are timesteps, and they are ordered numerically. */
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include "VFVTimeSeries.h"
+#include "VFVTest.h"
+
+using namespace sereno;
+
+/** \brief  Create an empty file
+ * \param path the file path */
+static void touch(const std::filesystem::path& path)
+{
+    std::ofstream file(path);
+}
+
+int main()
+{
+    //Numerical order, leading zeros ignored
+    VFV_CHECK(compareTimestepSuffixes("2", "10"));
+    VFV_CHECK(!compareTimestepSuffixes("10", "2"));
+    VFV_CHECK(compareTimestepSuffixes("009", "10"));
+    VFV_CHECK(compareTimestepSuffixes("99999999999999999999", "100000000000000000000"));
+    VFV_CHECK(!compareTimestepSuffixes("7", "7"));
+    VFV_CHECK(compareTimestepSuffixes("07", "7") != compareTimestepSuffixes("7", "07"));
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "testTimeSeries";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sub");
+
+    for(const char* name : {"ocean.vtk", "ocean.vtk.1", "ocean.vtk.10", "ocean.vtk.2", "ocean.vtk.0", //The series
+                            "ocean.vtk.3a", "ocean.vtk.", "ocean.vtkX4", "ocean.vtk.5.bak", "other.vtk.6",  //Not part of it
+                            "sub/ocean.vtk", "sub/ocean.vtk.7"})
+        touch(directory / name);
+    std::filesystem::create_directories(directory / "ocean.vtk.11"); //A directory: not parsable, but let the parser report it
+
+    std::vector<std::string> suffixes;
+    VFV_CHECK(getTimeSeriesSuffixes(directory.string(), "ocean.vtk", suffixes));
+    VFV_CHECK((suffixes == std::vector<std::string>{"0", "1", "2", "10", "11"}));
+
+    //Datasets in a sub directory
+    suffixes.clear();
+    VFV_CHECK(getTimeSeriesSuffixes(directory.string(), "sub/ocean.vtk", suffixes));
+    VFV_CHECK((suffixes == std::vector<std::string>{"7"}));
+
+    //No other timestep, and no directory
+    suffixes.clear();
+    VFV_CHECK(getTimeSeriesSuffixes(directory.string(), "other.vtk", suffixes));
+    VFV_CHECK(suffixes == std::vector<std::string>{"6"});
+    suffixes.clear();
+    VFV_CHECK(getTimeSeriesSuffixes(directory.string(), "single.vtk", suffixes));
+    VFV_CHECK(suffixes.empty());
+    VFV_CHECK(!getTimeSeriesSuffixes((directory / "missing").string(), "ocean.vtk", suffixes));
+    VFV_CHECK(suffixes.empty());
+
+    std::filesystem::remove_all(directory);
+    return getTestResult();
+}
@@ -0,0 +1,143 @@
+/* Tests of VFVTimestepSource, as loadVTKDataset uses it to share the parsing of a VTK dataset between the clients opening it:
+ * every subscriber receives every timestep once, in order, then the end of the parsing, without waiting for the publisher. */
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include "VFVTimestepSource.h"
+#include "VFVTest.h"
+
+using namespace sereno;
+
+/** \brief  What a subscriber received */
+struct Received
+{
+    std::vector<int>  timesteps;           /*!< The timesteps received, in order*/
+    uint32_t          nbFinish   = 0;      /*!< The number of onFinish calls*/
+    bool              ordered    = true;   /*!< Were the indices consecutive, from 0?*/
+    std::atomic<bool> inCallback{false};   /*!< Is a callback running?*/
+    bool              overlapped = false;  /*!< Did two callbacks run at once?*/
+};
+
+/** \brief  Subscribe to a source, recording what is received
+ * \param source the source
+ * \param received where to record the calls */
+static void subscribe(VFVTimestepSource<int>& source, Received& received)
+{
+    source.subscribe([&](size_t i, std::shared_ptr<int> timestep)
+    {
+        if(received.inCallback.exchange(true))
+            received.overlapped = true;
+        if(i != received.timesteps.size())
+            received.ordered = false;
+        received.timesteps.push_back(*timestep);
+        source.getNbTimesteps(); //The source is not locked
+        received.inCallback = false;
+    },
+    [&]()
+    {
+        if(received.inCallback.exchange(true))
+            received.overlapped = true;
+        received.nbFinish++;
+        received.inCallback = false;
+    });
+}
+
+/** \brief  Test subscriptions made before, during and after the parsing, in one thread */
+static void testSequential()
+{
+    VFVTimestepSource<int> source;
+    Received early, middle, late;
+
+    subscribe(source, early);
+    VFV_CHECK(early.timesteps.empty() && early.nbFinish == 0);
+
+    source.setNbTimesteps(3);
+    source.publish(std::make_shared<int>(10));
+    source.publish(std::make_shared<int>(11));
+    VFV_CHECK((early.timesteps == std::vector<int>{10, 11}));
+
+    //The published timesteps are given at once
+    subscribe(source, middle);
+    VFV_CHECK((middle.timesteps == std::vector<int>{10, 11}));
+    VFV_CHECK(source.getNbSubscribers() == 2);
+
+    source.publish(std::make_shared<int>(12));
+    source.finish();
+    VFV_CHECK(source.getNbSubscribers() == 0);
+
+    //Everything at once after the parsing
+    subscribe(source, late);
+    VFV_CHECK(source.getNbSubscribers() == 0);
+
+    for(Received* r : {&early, &middle, &late})
+    {
+        VFV_CHECK((r->timesteps == std::vector<int>{10, 11, 12}));
+        VFV_CHECK(r->nbFinish == 1);
+        VFV_CHECK(r->ordered);
+    }
+    VFV_CHECK(source.getNbTimesteps() == 3);
+
+    //A failed parsing: only the end
+    VFVTimestepSource<int> failed;
+    Received failedReceived;
+    subscribe(failed, failedReceived);
+    failed.finish();
+    VFV_CHECK(failedReceived.timesteps.empty() && failedReceived.nbFinish == 1);
+}
+
+/** \brief  Test subscriptions made while another thread publishes */
+static void testConcurrent()
+{
+    const int nbTimesteps   = 2000;
+    const int nbSubscribers = 8;
+    VFVTimestepSource<int> source;
+    std::vector<std::unique_ptr<Received>> received;
+    for(int i = 0; i < nbSubscribers; i++)
+        received.push_back(std::make_unique<Received>());
+
+    std::thread publisher([&]()
+    {
+        for(int i = 0; i < nbTimesteps; i++)
+        {
+            source.publish(std::make_shared<int>(i));
+            if(i%128 == 0)
+                std::this_thread::yield();
+        }
+        source.finish();
+    });
+
+    std::vector<std::thread> subscribers;
+    for(int i = 0; i < nbSubscribers; i++)
+        subscribers.emplace_back([&, i]()
+        {
+            //Subscribe at various points of the parsing
+            for(int j = 0; j < i*2000; j++)
+                std::this_thread::yield();
+            subscribe(source, *received[i]);
+        });
+
+    publisher.join();
+    for(std::thread& t : subscribers)
+        t.join();
+
+    std::vector<int> expected(nbTimesteps);
+    for(int i = 0; i < nbTimesteps; i++)
+        expected[i] = i;
+    for(auto& r : received)
+    {
+        VFV_CHECK(r->timesteps == expected);
+        VFV_CHECK(r->nbFinish == 1);
+        VFV_CHECK(r->ordered);
+        VFV_CHECK(!r->overlapped);
+    }
+    VFV_CHECK(source.getNbSubscribers() == 0);
+}
+
+int main()
+{
+    testSequential();
+    testConcurrent();
+    return getTestResult();
+}
@@ -0,0 +1,51 @@
+/* Tests of VFVValuesMutex, as loadCloudPointDataset uses it to keep the values of a cloud point dataset locked while the library loads them:
+ * the values are locked by one thread and unlocked by another, and the threads waiting for them resume. */
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "VFVValuesMutex.h"
+#include "VFVTest.h"
+
+using namespace sereno;
+
+int main()
+{
+    VFVValuesMutex mutex;
+
+    //try_lock fails while the values are locked, even from the thread owning them
+    {
+        std::unique_lock<VFVValuesMutex> lock(mutex, std::try_to_lock);
+        VFV_CHECK(lock.owns_lock());
+        VFV_CHECK(!mutex.try_lock());
+    }
+    VFV_CHECK(mutex.try_lock());
+    mutex.unlock();
+
+    //Locked here, unlocked by another thread, as the completion callback of the library does
+    mutex.lock();
+    std::atomic<bool> waited{false};
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&]()
+    {
+        std::lock_guard<VFVValuesMutex> lock(mutex);
+        acquired = true;
+    });
+    std::thread loader([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        waited = !acquired;
+        mutex.unlock();
+    });
+    loader.join();
+    waiter.join();
+    VFV_CHECK(waited);
+    VFV_CHECK(acquired);
+
+    //Free once the waiter released it
+    VFV_CHECK(mutex.try_lock());
+    mutex.unlock();
+
+    return getTestResult();
+}